@@ -0,0 +1,69 @@
+#include "benchutil.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+
+#include "../src/cataloggenerator.h"
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+// Counts every allocation; the array and nothrow forms forward here.
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+std::size_t allocationCount() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+void reportAllocations(benchmark::State& state, std::size_t before) {
+  state.counters["allocs/iter"] = benchmark::Counter(
+      static_cast<double>(allocationCount() - before),
+      benchmark::Counter::kAvgIterations);
+}
+
+std::string syntheticCatalog(std::size_t rows) {
+  static std::map<std::size_t, std::string> generated;
+  auto found = generated.find(rows);
+  if (found != generated.end()) {
+    return found->second;
+  }
+  std::string path;
+  const char* directory = std::getenv("YOUTUBE_BENCH_CATALOGS");
+  if (directory && *directory) {
+    path = (std::filesystem::path(directory) /
+            ("videos_" + std::to_string(rows) + ".txt"))
+               .string();
+  }
+  if (path.empty() || !std::filesystem::exists(path)) {
+    path = (std::filesystem::temp_directory_path() /
+            ("youtube_bench_catalog_" + std::to_string(rows) + ".txt"))
+               .string();
+    CatalogOptions options;
+    options.rows = rows;
+    std::ofstream out(path, std::ios::binary);
+    CatalogGenerator(options).write(out);
+  }
+  generated.emplace(rows, path);
+  return path;
+}
+
+void catalogSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("videos")->RangeMultiplier(10)->Range(10, 10000000);
+}
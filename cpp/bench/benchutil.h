@@ -0,0 +1,48 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Writes a catalog with the given number of rows and CatalogGenerator's
+// default shape to a temporary file, once per process, and returns its path.
+// If YOUTUBE_BENCH_CATALOGS names a directory holding videos_<rows>.txt,
+// say from youtube_generate, that file is used instead.
+std::string syntheticCatalog(std::size_t rows);
+
+// Runs a benchmark over catalogs of 10 to 10,000,000 videos, by powers of
+// ten, passing the size as range(0).
+void catalogSizes(benchmark::internal::Benchmark* benchmark);
+
+/**
+ * Discards std::cout and feeds std::cin an empty stream while in scope, so
+ * VideoPlayer commands can run inside benchmark loops. Declare it before
+ * the players, which flush their buffered output when they are destroyed.
+ */
+class SilencedIo {
+ private:
+  std::istringstream mSource;
+  std::streambuf* mOut;
+  std::streambuf* mIn;
+
+ public:
+  SilencedIo()
+      : mOut(std::cout.rdbuf(nullptr)), mIn(std::cin.rdbuf(mSource.rdbuf())) {}
+  ~SilencedIo() {
+    std::cout.rdbuf(mOut);
+    std::cout.clear();
+    std::cin.rdbuf(mIn);
+    std::cin.clear();
+  }
+};
+
+// Returns the number of heap allocations made by the process so far. The
+// benchmarks replace the global operator new to count them.
+std::size_t allocationCount();
+
+// Reports the allocations made per iteration of a benchmark as the
+// "allocs/iter" counter.
+void reportAllocations(benchmark::State& state, std::size_t before);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#include "../src/casefold.h"
+
+namespace {
+
+// How the search and playlist paths folded strings before the kernels: a
+// std::transform/toupper copy of each side.
+std::string transformToUpper(const std::string& input) {
+  std::string output(input);
+  std::transform(output.begin(), output.end(), output.begin(),
+                 [](char c) { return static_cast<char>(std::toupper(c)); });
+  return output;
+}
+
+// A title-like haystack of the given length, with the needle at the end.
+std::string haystack(std::size_t size) {
+  std::string text;
+  while (text.size() + 8 < size) {
+    text += "Amazing ";
+  }
+  text.resize(size - 4, ' ');
+  return text + "Cats";
+}
+
+void BM_FindTransformToUpper(benchmark::State& state) {
+  std::string text = haystack(static_cast<std::size_t>(state.range(0)));
+  std::string needle = "cats";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        transformToUpper(text).find(transformToUpper(needle)));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindTransformToUpper)->RangeMultiplier(4)->Range(16, 4096);
+
+void BM_FindFoldedScalar(benchmark::State& state) {
+  std::string text = haystack(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(findFoldedScalar(text, "CATS"));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindFoldedScalar)->RangeMultiplier(4)->Range(16, 4096);
+
+void BM_FindFolded(benchmark::State& state) {
+  std::string text = haystack(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(findFolded(text, "CATS"));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindFolded)->RangeMultiplier(4)->Range(16, 4096);
+
+void BM_EqualsTransformToUpper(benchmark::State& state) {
+  std::string a(static_cast<std::size_t>(state.range(0)), 'p');
+  std::string b(a.size(), 'P');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(transformToUpper(a) == transformToUpper(b));
+  }
+}
+BENCHMARK(BM_EqualsTransformToUpper)->RangeMultiplier(4)->Range(16, 1024);
+
+void BM_EqualsFolded(benchmark::State& state) {
+  std::string a(static_cast<std::size_t>(state.range(0)), 'p');
+  std::string b(a.size(), 'P');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(equalsFolded(a, b));
+  }
+}
+BENCHMARK(BM_EqualsFolded)->RangeMultiplier(4)->Range(16, 1024);
+
+}  // namespace
@@ -0,0 +1,313 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/commandparser.h"
+#include "../src/commandtokens.h"
+#include "../src/helper.h"
+#include "../src/outputsink.h"
+#include "../src/sessionmanager.h"
+#include "../src/videolibrary.h"
+#include "../src/videoplayer.h"
+#include "benchutil.h"
+
+namespace {
+
+// How NUMBER_OF_ALL_VIDEOS counted the library before the views: a copy of
+// every video, for its size.
+void BM_NumberOfVideosCopying(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(static_cast<std::size_t>(state.range(0))));
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(library.getVideos().size());
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_NumberOfVideosCopying)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_NumberOfVideos(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.numberOfVideos();
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_NumberOfVideos)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_PlayRandomVideo(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  player.flagVideo("video_0_id");
+  player.seedRandom(1);
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.playRandomVideo();
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlayRandomVideo)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// A player with the given number of playlists of ten videos each.
+void addPlaylists(VideoPlayer& player, int playlists) {
+  SilencedIo io;
+  for (int playlist = 0; playlist < playlists; ++playlist) {
+    std::string name = "playlist_" + std::to_string(playlist);
+    player.createPlaylist(name);
+    for (int video = 0; video < 10; ++video) {
+      player.addVideoToPlaylist(
+          name, "video_" + std::to_string(playlist * 10 + video) + "_id");
+    }
+  }
+}
+
+void BM_ShowAllPlaylists(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(100000)));
+  addPlaylists(player, static_cast<int>(state.range(0)));
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.showAllPlaylists();
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_ShowAllPlaylists)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ShowPlaylist(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(100000)));
+  addPlaylists(player, 1);
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.showPlaylist("playlist_0");
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_ShowPlaylist)->Unit(benchmark::kMicrosecond);
+
+// How playlists checked for duplicates before they were indexed: a scan of
+// the entries in order.
+void BM_PlaylistAddRemoveLinear(benchmark::State& state) {
+  std::vector<VideoHandle> list;
+  for (VideoHandle video = 0; video < state.range(0); ++video) {
+    list.push_back(video);
+  }
+  VideoHandle video = static_cast<VideoHandle>(state.range(0));
+  for (auto _ : state) {
+    if (std::find(list.begin(), list.end(), video) == list.end()) {
+      list.push_back(video);
+    }
+    list.erase(std::remove(list.begin(), list.end(), video), list.end());
+  }
+}
+BENCHMARK(BM_PlaylistAddRemoveLinear)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_PlaylistAddRemove(benchmark::State& state) {
+  VideoPlaylist playlist("list");
+  for (VideoHandle video = 0; video < state.range(0); ++video) {
+    playlist.addVideo(video);
+  }
+  VideoHandle video = static_cast<VideoHandle>(state.range(0));
+  for (auto _ : state) {
+    if (!playlist.contains(video)) {
+      playlist.addVideo(video);
+    }
+    playlist.removeVideo(video);
+  }
+}
+BENCHMARK(BM_PlaylistAddRemove)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// A playlist-heavy command script: long names (past the small-string
+// buffer) typed in a different case each time.
+void runPlaylistScript(VideoPlayer& player, int playlists) {
+  static const std::string names[] = {"My_Favourite_Playlist_",
+                                      "MY_FAVOURITE_PLAYLIST_",
+                                      "my_favourite_playlist_"};
+  for (int playlist = 0; playlist < playlists; ++playlist) {
+    std::string suffix = std::to_string(playlist);
+    player.createPlaylist(names[0] + suffix);
+    player.addVideoToPlaylist(names[1] + suffix, "video_1_id");
+    player.addVideoToPlaylist(names[2] + suffix, "video_2_id");
+    player.showPlaylist(names[1] + suffix);
+    player.removeFromPlaylist(names[2] + suffix, "video_1_id");
+    player.clearPlaylist(names[0] + suffix);
+    player.deletePlaylist(names[1] + suffix);
+  }
+}
+
+void BM_PlaylistScript(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(1000)));
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    runPlaylistScript(player, 100);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlaylistScript)->Unit(benchmark::kMicrosecond);
+
+// How playlists were looked up before the case-insensitive map: by an
+// upper-cased copy of the name.
+void BM_PlaylistLookupUpperCased(benchmark::State& state) {
+  std::unordered_map<std::string, VideoPlaylist> playlists;
+  std::string name = "My_Favourite_Playlist_7";
+  playlists.emplace(stringToUpper(name), VideoPlaylist(name));
+  std::string typed = "my_favourite_PLAYLIST_7";
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(playlists.find(stringToUpper(typed)));
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlaylistLookupUpperCased);
+
+void BM_PlaylistLookup(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(1000));
+  library.createPlaylist("My_Favourite_Playlist_7");
+  std::string typed = "my_favourite_PLAYLIST_7";
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(library.getPlaylist(typed));
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlaylistLookup);
+
+// Refusing a playlist that already exists allocates nothing.
+void BM_CreateExistingPlaylist(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(1000));
+  library.createPlaylist("My_Favourite_Playlist_7");
+  std::string typed = "my_favourite_PLAYLIST_7";
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(library.createPlaylist(typed));
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_CreateExistingPlaylist);
+
+// Writes lines of a SHOW_ALL_VIDEOS-sized listing to /dev/null, flushing
+// after every line as std::endl did.
+void BM_OutputEndl(benchmark::State& state) {
+  std::ofstream out("/dev/null");
+  for (auto _ : state) {
+    for (int line = 0; line < 1000; ++line) {
+      out << "\tAmazing Cats (amazing_cats_video_id) [#cat #animal]"
+          << std::endl;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_OutputEndl)->Unit(benchmark::kMicrosecond);
+
+void BM_OutputSink(benchmark::State& state) {
+  std::ofstream out("/dev/null");
+  StdoutSink sink(out);
+  for (auto _ : state) {
+    for (int line = 0; line < 1000; ++line) {
+      sink << "\tAmazing Cats (amazing_cats_video_id) [#cat #animal]" << '\n';
+    }
+    // One flush per command, at the prompt.
+    sink.flush();
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_OutputSink)->Unit(benchmark::kMicrosecond);
+
+// How the command loop split a line before the tokenizer: a stringstream,
+// a trimmed copy of every token and an upper-cased command name.
+void BM_TokenizeStringstream(benchmark::State& state) {
+  std::string line = "add_to_playlist my_playlist video_1_id";
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    std::vector<std::string> commandList;
+    std::string command;
+    std::stringstream stream(line);
+    while (std::getline(stream, command, ' ')) {
+      commandList.push_back(trim(command));
+    }
+    std::transform(commandList[0].begin(), commandList[0].end(),
+                   commandList[0].begin(),
+                   [](char c) { return static_cast<char>(std::toupper(c)); });
+    benchmark::DoNotOptimize(commandList.data());
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_TokenizeStringstream);
+
+void BM_Tokenize(benchmark::State& state) {
+  std::string line = "add_to_playlist my_playlist video_1_id";
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    CommandTokens tokens(line);
+    benchmark::DoNotOptimize(tokens);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_Tokenize);
+
+// Lines whose commands do almost nothing, so the time is the parse and
+// dispatch: a lookup miss, a usage message and three cheap commands.
+const char* const kCheapLines[] = {"show_playing", "pause", "bogus_command",
+                                   "stop now", "continue"};
+
+void BM_ExecuteLine(benchmark::State& state) {
+  CommandParser parser(VideoPlayer(VideoLibrary(syntheticCatalog(1000)),
+                                   std::make_shared<NullSink>()));
+  std::size_t before = allocationCount();
+  std::size_t line = 0;
+  for (auto _ : state) {
+    parser.executeLine(kCheapLines[line]);
+    line = line + 1 == std::size(kCheapLines) ? 0 : line + 1;
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_ExecuteLine);
+
+// Opening a session costs the same whatever the size of the catalog, which
+// every session shares.
+void BM_OpenSession(benchmark::State& state) {
+  SessionManager manager(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  auto output = std::make_shared<NullSink>();
+  SessionScope scope =
+      state.range(1) ? SessionScope::Private : SessionScope::Shared;
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    manager.close(manager.open(scope, output));
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_OpenSession)
+    ->ArgNames({"videos", "private"})
+    ->ArgsProduct({{1000, 1000000}, {0, 1}});
+
+}  // namespace
@@ -0,0 +1,192 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../src/concurrentflagstore.h"
+#include "../src/epochreclaimer.h"
+#include "../src/flagstore.h"
+#include "../src/outputsink.h"
+#include "../src/sessionmanager.h"
+#include "../src/videolibrary.h"
+#include "benchutil.h"
+
+namespace {
+
+constexpr int kMaxThreads = 64;
+constexpr std::size_t kCatalogSize = 100000;
+
+// Built by the first thread before the timed loop, which every thread waits
+// at, and destroyed by it after, when they are all done.
+std::unique_ptr<SessionManager> gManager;
+std::vector<SessionManager::SessionId> gSessions;
+
+// Returns a thread's share of a command mix: mostly plays and playlist
+// reads, with flags, allows and playlist edits spread across the catalog so
+// threads mostly touch different shards.
+std::vector<std::string> commandMix(int thread, bool writes) {
+  std::mt19937 rng(static_cast<unsigned>(thread));
+  std::vector<std::string> lines;
+  for (int line = 0; line < 256; ++line) {
+    std::string video =
+        "video_" + std::to_string(rng() % kCatalogSize) + "_id";
+    std::string playlist = "list_" + std::to_string(rng() % 16);
+    switch (writes ? rng() % 6 : rng() % 2) {
+      case 0:
+        lines.push_back("PLAY " + video);
+        break;
+      case 1:
+        lines.push_back("SHOW_PLAYLIST " + playlist);
+        break;
+      case 2:
+        lines.push_back("FLAG_VIDEO " + video);
+        break;
+      case 3:
+        lines.push_back("ALLOW_VIDEO " + video);
+        break;
+      case 4:
+        lines.push_back("ADD_TO_PLAYLIST " + playlist + " " + video);
+        break;
+      default:
+        lines.push_back("REMOVE_FROM_PLAYLIST " + playlist + " " + video);
+        break;
+    }
+  }
+  return lines;
+}
+
+// Shared sessions running commands on 1 to 64 threads against one
+// concurrent library. Items per second is the aggregate command rate; with
+// perfect scaling it grows with the thread count up to the core count.
+void BM_ConcurrentCommands(benchmark::State& state) {
+  bool writes = state.range(0) != 0;
+  if (state.thread_index() == 0) {
+    gManager = std::make_unique<SessionManager>(
+        VideoLibrary(syntheticCatalog(kCatalogSize)));
+    gManager->enableConcurrency();
+    auto output = std::make_shared<NullSink>();
+    gSessions.clear();
+    for (int session = 0; session < kMaxThreads; ++session) {
+      gSessions.push_back(gManager->open(SessionScope::Shared, output));
+    }
+    for (int list = 0; list < 16; ++list) {
+      gManager->executeLine(gSessions[0],
+                            "CREATE_PLAYLIST list_" + std::to_string(list));
+    }
+  }
+  std::vector<std::string> lines =
+      commandMix(static_cast<int>(state.thread_index()), writes);
+  std::size_t next = 0;
+  for (auto _ : state) {
+    gManager->executeLine(gSessions[state.thread_index()],
+                          lines[next++ % lines.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    gManager.reset();
+  }
+}
+BENCHMARK(BM_ConcurrentCommands)
+    ->ArgName("writes")
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+// A FlagStore behind one lock, the simplest way to share it, to compare the
+// lock-free store with.
+class LockedFlagStore {
+ private:
+  mutable std::mutex mMutex;
+  FlagStore mFlags;
+
+ public:
+  explicit LockedFlagStore(std::size_t videoCount) : mFlags(videoCount) {}
+
+  template <typename Visitor>
+  bool withReason(VideoHandle video, Visitor&& visit) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::string* reason = mFlags.reason(video);
+    if (!reason) {
+      return false;
+    }
+    visit(*reason);
+    return true;
+  }
+  bool flag(VideoHandle video, std::string_view reason) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFlags.flag(video, reason);
+  }
+  bool allow(VideoHandle video) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFlags.allow(video);
+  }
+};
+
+constexpr std::size_t kChurnVideos = 100000;
+
+// Readers on 1 to 8 threads look up flag reasons, as PLAY and VideoToString
+// do, while a moderation thread flags and allows videos as fast as it can.
+// Items per second is the aggregate read rate.
+template <typename Store>
+void flagReadsDuringChurn(benchmark::State& state) {
+  static std::unique_ptr<Store> store;
+  static std::atomic<bool> stop;
+  static std::thread churn;
+  if (state.thread_index() == 0) {
+    store = std::make_unique<Store>(kChurnVideos);
+    // Start with a tenth of the catalog flagged.
+    for (VideoHandle video = 0; video < kChurnVideos; video += 10) {
+      store->flag(video, "Not supplied");
+    }
+    stop = false;
+    churn = std::thread([] {
+      std::minstd_rand random(1);
+      while (!stop.load(std::memory_order_relaxed)) {
+        VideoHandle video = random() % kChurnVideos;
+        if (!store->allow(video)) {
+          store->flag(video, "Flagged during a moderation burst");
+        }
+      }
+    });
+  }
+  std::minstd_rand random(static_cast<unsigned>(state.thread_index()) + 2);
+  std::size_t found = 0;
+  for (auto _ : state) {
+    VideoHandle video = random() % kChurnVideos;
+    store->withReason(
+        video, [&](const std::string& reason) { found += reason.size(); });
+  }
+  benchmark::DoNotOptimize(found);
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    stop = true;
+    churn.join();
+    store.reset();
+    if constexpr (std::is_same_v<Store, ConcurrentFlagStore>) {
+      // Retired reasons still waiting for the epoch to move on; this should
+      // stay small however long the churn runs.
+      state.counters["unreclaimed"] =
+          static_cast<double>(EpochReclaimer::global().reclaim());
+    }
+  }
+}
+
+void BM_FlagReadsDuringChurnLockFree(benchmark::State& state) {
+  flagReadsDuringChurn<ConcurrentFlagStore>(state);
+}
+BENCHMARK(BM_FlagReadsDuringChurnLockFree)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_FlagReadsDuringChurnLocked(benchmark::State& state) {
+  flagReadsDuringChurn<LockedFlagStore>(state);
+}
+BENCHMARK(BM_FlagReadsDuringChurnLocked)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
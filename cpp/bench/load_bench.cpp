@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/helper.h"
+#include "../src/videolibrary.h"
+#include "benchutil.h"
+
+namespace {
+
+// The stream-based parser VideoLibrary used before the catalog was memory
+// mapped, kept as the baseline for the load benchmarks.
+struct StreamVideo {
+  std::string title;
+  std::string videoId;
+  std::vector<std::string> tags;
+};
+
+std::unordered_map<std::string, StreamVideo> streamLoad(
+    const std::string& path) {
+  std::unordered_map<std::string, StreamVideo> videos;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::stringstream linestream(line);
+    std::string title;
+    std::string id;
+    std::string tag;
+    std::vector<std::string> tags;
+    std::getline(linestream, title, '|');
+    std::getline(linestream, id, '|');
+    while (std::getline(linestream, tag, ',')) {
+      tags.emplace_back(trim(std::move(tag)));
+    }
+    StreamVideo video{trim(std::move(title)), trim(id), std::move(tags)};
+    videos.emplace(trim(std::move(id)), std::move(video));
+  }
+  return videos;
+}
+
+void BM_LoadLibraryStream(benchmark::State& state) {
+  std::string path = syntheticCatalog(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto videos = streamLoad(path);
+    benchmark::DoNotOptimize(videos.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadLibraryStream)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_LoadLibraryMapped(benchmark::State& state) {
+  std::string path = syntheticCatalog(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    VideoLibrary library(path);
+    benchmark::DoNotOptimize(library.getVideo("video_0_id"));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadLibraryMapped)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_LoadLibraryParallel(benchmark::State& state) {
+  std::string path = syntheticCatalog(static_cast<std::size_t>(state.range(0)));
+  unsigned threads = static_cast<unsigned>(state.range(1));
+  for (auto _ : state) {
+    VideoLibrary library(path, threads);
+    benchmark::DoNotOptimize(library.getVideo("video_0_id"));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadLibraryParallel)
+    ->ArgsProduct({{100000, 1000000}, {1, 2, 4, 8}})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_LoadLibrarySnapshot(benchmark::State& state) {
+  std::string path = syntheticCatalog(static_cast<std::size_t>(state.range(0)));
+  std::string snapshotPath = path + ".snapshot";
+  VideoLibrary(path).saveSnapshot(snapshotPath);
+  for (auto _ : state) {
+    auto library = VideoLibrary::fromSnapshot(snapshotPath);
+    benchmark::DoNotOptimize(library->getVideo("video_0_id"));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadLibrarySnapshot)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+// Reloading an unchanged catalog, with the title order either sorted from
+// scratch (0) or carried over from the catalog being replaced (1).
+void BM_ReloadCatalog(benchmark::State& state) {
+  std::string path = syntheticCatalog(static_cast<std::size_t>(state.range(0)));
+  Catalog previous(path, 1);
+  for (auto _ : state) {
+    Catalog catalog(path, 1, state.range(1) ? &previous : nullptr);
+    benchmark::DoNotOptimize(catalog.getTitleOrder().data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ReloadCatalog)
+    ->ArgsProduct({{100000, 1000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,164 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "../src/mutationlog.h"
+#include "../src/videolibrary.h"
+#include "benchutil.h"
+
+namespace {
+
+constexpr std::size_t kCatalogSize = 100000;
+constexpr int kPlaylists = 1000;
+
+std::unique_ptr<MutationLog> emptyLog(const std::string& path) {
+  std::remove(path.c_str());
+  return MutationLog::open(path, [](const Mutation&) {});
+}
+
+// Writes a log of the given number of playlist and flag changes over the
+// synthetic catalog, once per process, and returns its path.
+std::string syntheticLog(std::uint64_t records) {
+  static std::map<std::uint64_t, std::string> paths;
+  auto found = paths.find(records);
+  if (found != paths.end()) {
+    return found->second;
+  }
+  std::string path = "./youtube_bench_" + std::to_string(records) + ".wal";
+  emptyLog(path);
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+  std::mt19937 rng(1);
+  std::string chunk;
+  for (std::uint64_t record = 0; record < records; ++record) {
+    std::string video =
+        "video_" + std::to_string(rng() % kCatalogSize) + "_id";
+    std::string playlist = "list_" + std::to_string(rng() % kPlaylists);
+    unsigned kind = rng() % 20;
+    if (record < kPlaylists) {
+      MutationLog::encode(chunk, {MutationType::CreatePlaylist,
+                                  "list_" + std::to_string(record), {}});
+    } else if (kind < 8) {
+      MutationLog::encode(chunk,
+                          {MutationType::AddToPlaylist, playlist, video});
+    } else if (kind < 12) {
+      MutationLog::encode(chunk,
+                          {MutationType::RemoveFromPlaylist, playlist, video});
+    } else if (kind < 16) {
+      MutationLog::encode(chunk,
+                          {MutationType::Flag, video, "Flagged in a burst"});
+    } else if (kind < 19) {
+      MutationLog::encode(chunk, {MutationType::Allow, video, {}});
+    } else {
+      MutationLog::encode(chunk, {MutationType::ClearPlaylist, playlist, {}});
+    }
+    if (chunk.size() > (1 << 20)) {
+      out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      chunk.clear();
+    }
+  }
+  out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+  paths.emplace(records, path);
+  return path;
+}
+
+// Records batches of flag changes from one thread, syncing after each
+// batch, so every batch costs one write and fsync.
+void BM_LogMutationsPerSync(benchmark::State& state) {
+  auto log = emptyLog("./youtube_bench_sync.wal");
+  std::int64_t batch = state.range(0);
+  std::uint64_t record = 0;
+  for (auto _ : state) {
+    for (std::int64_t change = 0; change < batch; ++change) {
+      std::string video =
+          "video_" + std::to_string(record++ % kCatalogSize) + "_id";
+      log->record({MutationType::Flag, video, "Not supplied"},
+                  [] { return true; });
+    }
+    log->sync();
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+  state.counters["fsyncs"] = static_cast<double>(log->syncCount());
+}
+BENCHMARK(BM_LogMutationsPerSync)
+    ->ArgName("batch")
+    ->RangeMultiplier(16)
+    ->Range(1, 4096)
+    ->UseRealTime();
+
+// Every thread records one change and waits for it to be durable, as a
+// session's command does; threads arriving while an fsync is in flight share
+// the next one. changes/fsync is how many each fsync carried.
+void BM_LogGroupCommit(benchmark::State& state) {
+  static std::unique_ptr<MutationLog> log;
+  if (state.thread_index() == 0) {
+    log = emptyLog("./youtube_bench_group.wal");
+  }
+  std::string video =
+      "video_" + std::to_string(state.thread_index()) + "_id";
+  for (auto _ : state) {
+    log->record({MutationType::Flag, video, "Not supplied"},
+                [] { return true; });
+    log->sync();
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    std::uint64_t syncs = log->syncCount();
+    state.counters["changes/fsync"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * state.threads()) /
+        static_cast<double>(syncs ? syncs : 1));
+    log.reset();
+  }
+}
+BENCHMARK(BM_LogGroupCommit)->ThreadRange(1, 32)->UseRealTime();
+
+// Reads and checks every record of a log, without applying them: the floor
+// for replay.
+void BM_LogReplayRecords(benchmark::State& state) {
+  std::string path = syntheticLog(static_cast<std::uint64_t>(state.range(0)));
+  std::uint64_t replayed = 0;
+  for (auto _ : state) {
+    std::uint64_t seen = 0;
+    auto log = MutationLog::open(
+        path, [&](const Mutation&) { ++seen; }, &replayed);
+    benchmark::DoNotOptimize(seen);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(replayed));
+}
+BENCHMARK(BM_LogReplayRecords)
+    ->RangeMultiplier(10)
+    ->Range(10000, 100000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Startup with a log: replays it onto a fresh library over a 100,000-video
+// catalog.
+void BM_LogReplayLibrary(benchmark::State& state) {
+  std::string path = syntheticLog(static_cast<std::uint64_t>(state.range(0)));
+  std::string catalog = syntheticCatalog(kCatalogSize);
+  std::uint64_t replayed = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto library = std::make_unique<VideoLibrary>(catalog);
+    state.ResumeTiming();
+    library->openLog(path, &replayed);
+    state.PauseTiming();
+    library.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(replayed));
+}
+BENCHMARK(BM_LogReplayLibrary)
+    ->RangeMultiplier(10)
+    ->Range(10000, 100000000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,143 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/videolibrary.h"
+#include "../src/videoplayer.h"
+#include "benchutil.h"
+
+// The commands without a benchmark of their own elsewhere, each run through
+// VideoPlayer over catalogs of 10 to 10,000,000 videos (see catalogSizes),
+// so a command that stops scaling shows up at the size where it matters.
+
+namespace {
+
+std::size_t catalogSize(const benchmark::State& state) {
+  return static_cast<std::size_t>(state.range(0));
+}
+
+std::string videoId(std::size_t video) {
+  return "video_" + std::to_string(video) + "_id";
+}
+
+// Returns 64 video ids spread evenly over a catalog of the given size, so
+// lookups do not all hit the same cache lines.
+std::vector<std::string> spreadIds(std::size_t videos) {
+  std::vector<std::string> ids;
+  for (std::size_t id = 0; id < 64; ++id) {
+    ids.push_back(videoId(id * videos / 64));
+  }
+  return ids;
+}
+
+// PLAY, which looks the id up in the catalog.
+void BM_PlayVideo(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(catalogSize(state))));
+  std::vector<std::string> ids = spreadIds(catalogSize(state));
+  std::size_t next = 0;
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.playVideo(ids[next++ % ids.size()]);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_PlayVideo)->Apply(catalogSizes)->Unit(benchmark::kMicrosecond);
+
+// PAUSE, CONTINUE, SHOW_PLAYING and STOP on a playing video.
+void BM_PlaybackControls(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(catalogSize(state))));
+  std::string id = videoId(catalogSize(state) / 2);
+  for (auto _ : state) {
+    player.playVideo(id);
+    player.pauseVideo();
+    player.continueVideo();
+    player.showPlaying();
+    player.stopVideo();
+  }
+}
+BENCHMARK(BM_PlaybackControls)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_CreateDeletePlaylist(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(catalogSize(state))));
+  for (auto _ : state) {
+    player.createPlaylist("Weekend_Mix");
+    player.deletePlaylist("weekend_mix");
+  }
+}
+BENCHMARK(BM_CreateDeletePlaylist)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// ADD_TO_PLAYLIST of a new video and of one already there, which only
+// checks the playlist, then REMOVE_FROM_PLAYLIST, on a playlist holding
+// every other video in the catalog.
+void BM_AddRemoveFromPlaylist(benchmark::State& state) {
+  SilencedIo io;
+  std::size_t videos = catalogSize(state);
+  VideoLibrary library(syntheticCatalog(videos));
+  VideoPlaylist* playlist = library.createPlaylist("everything");
+  for (VideoHandle video = 0; video + 1 < videos; ++video) {
+    library.addToPlaylist(*playlist, video);
+  }
+  VideoPlayer player(std::move(library));
+  std::string added = videoId(videos - 1);
+  std::string present = videoId(videos / 2);
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.addVideoToPlaylist("everything", added);
+    player.addVideoToPlaylist("everything", present);
+    player.removeFromPlaylist("everything", added);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_AddRemoveFromPlaylist)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// Fills a playlist with ten videos from across the catalog and clears it.
+void BM_ClearPlaylist(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(catalogSize(state))));
+  player.createPlaylist("list");
+  std::vector<std::string> ids = spreadIds(catalogSize(state));
+  ids.resize(10);
+  for (auto _ : state) {
+    for (const std::string& id : ids) {
+      player.addVideoToPlaylist("list", id);
+    }
+    player.clearPlaylist("list");
+  }
+}
+BENCHMARK(BM_ClearPlaylist)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// FLAG_VIDEO with a reason, then ALLOW_VIDEO, on videos across the catalog.
+void BM_FlagAllowVideo(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(VideoLibrary(syntheticCatalog(catalogSize(state))));
+  // The first flag builds the store's arrays; keep that out of the loop.
+  player.flagVideo(videoId(0));
+  std::vector<std::string> ids = spreadIds(catalogSize(state));
+  std::size_t next = 1;
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    const std::string& id = ids[next++ % ids.size()];
+    player.flagVideo(id, "dont_like_cats");
+    player.allowVideo(id);
+  }
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_FlagAllowVideo)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,146 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "../src/helper.h"
+#include "../src/videolibrary.h"
+#include "../src/videoplayer.h"
+#include "benchutil.h"
+
+namespace {
+
+// The linear scan SEARCH_VIDEOS_WITH_TAG used before the tag index: copy the
+// library, upper-case every tag of every video, then sort the matches.
+std::vector<Video> linearTagSearch(VideoLibrary& library,
+                                   const std::string& videoTag) {
+  std::vector<Video> matches;
+  for (auto video : library.getVideos()) {
+    if (library.getFlag(library.findVideo(video.getVideoId()))) {
+      continue;
+    }
+    std::vector<std::string> tags;
+    for (auto tag : video.getTags()) {
+      tags.push_back(stringToUpper(std::string(tag)));
+    }
+    if (std::find(tags.begin(), tags.end(), stringToUpper(videoTag)) !=
+        tags.end()) {
+      matches.push_back(video);
+    }
+  }
+  std::sort(matches.begin(), matches.end(),
+            [](const Video& a, const Video& b) {
+              return a.getTitle() < b.getTitle();
+            });
+  return matches;
+}
+
+void BM_SearchVideosWithTagLinear(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(static_cast<std::size_t>(state.range(0))));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(linearTagSearch(library, "#TAG7").size());
+  }
+}
+BENCHMARK(BM_SearchVideosWithTagLinear)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_SearchVideosWithTagIndexed(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  for (auto _ : state) {
+    player.searchVideosWithTag("#TAG7");
+  }
+}
+BENCHMARK(BM_SearchVideosWithTagIndexed)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// The scan SEARCH_VIDEOS used before the title index: copy the library, run
+// the term as a regex over every upper-cased title, then sort the matches.
+std::vector<Video> linearTitleSearch(VideoLibrary& library,
+                                     const std::string& searchTerm) {
+  std::regex pattern{stringToUpper(searchTerm)};
+  std::vector<Video> matches;
+  for (auto video : library.getVideos()) {
+    if (std::regex_search(stringToUpper(std::string(video.getTitle())),
+                          pattern) &&
+        !library.getFlag(library.findVideo(video.getVideoId()))) {
+      matches.push_back(video);
+    }
+  }
+  std::sort(matches.begin(), matches.end(),
+            [](const Video& a, const Video& b) {
+              return a.getTitle() < b.getTitle();
+            });
+  return matches;
+}
+
+void BM_SearchVideosLinear(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(static_cast<std::size_t>(state.range(0))));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(linearTitleSearch(library, "music 777").size());
+  }
+}
+BENCHMARK(BM_SearchVideosLinear)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_SearchVideosIndexed(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  for (auto _ : state) {
+    player.searchVideos("music 777");
+  }
+}
+BENCHMARK(BM_SearchVideosIndexed)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_SearchVideosRegexLinear(benchmark::State& state) {
+  VideoLibrary library(syntheticCatalog(static_cast<std::size_t>(state.range(0))));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        linearTitleSearch(library, "^live.*(cats|dogs) 7+$").size());
+  }
+}
+BENCHMARK(BM_SearchVideosRegexLinear)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_SearchVideosRegexAutomaton(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  for (auto _ : state) {
+    player.searchVideos("^live.*(cats|dogs) 7+$");
+  }
+}
+BENCHMARK(BM_SearchVideosRegexAutomaton)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ShowAllVideos(benchmark::State& state) {
+  SilencedIo io;
+  VideoPlayer player(
+      VideoLibrary(syntheticCatalog(static_cast<std::size_t>(state.range(0)))));
+  std::size_t before = allocationCount();
+  for (auto _ : state) {
+    player.showAllVideos();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  reportAllocations(state, before);
+}
+BENCHMARK(BM_ShowAllVideos)
+    ->Apply(catalogSizes)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,259 @@
+#include "casefold.h"
+
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CASEFOLD_SSE2 1
+#endif
+
+// AVX2 is compiled in with a target attribute and only used if the CPU
+// reports it, so the default build still runs on any x86-64.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CASEFOLD_AVX2 1
+#endif
+
+namespace {
+
+// Returns whether the first size bytes at text equal foldedNeedle once folded.
+bool matchesFolded(const char* text, const char* foldedNeedle,
+                   std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    if (foldChar(text[i]) != foldedNeedle[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Scans the start positions from pos onwards for a match, one byte at a time.
+std::size_t findFoldedFrom(std::string_view haystack,
+                           std::string_view foldedNeedle, std::size_t pos) {
+  for (; pos + foldedNeedle.size() <= haystack.size(); ++pos) {
+    if (matchesFolded(haystack.data() + pos, foldedNeedle.data(),
+                      foldedNeedle.size())) {
+      return pos;
+    }
+  }
+  return std::string_view::npos;
+}
+
+#if CASEFOLD_SSE2
+
+// Upper-cases the ASCII letters of 16 bytes. Adding 0x80 - 'a' moves 'a'..'z'
+// to the bottom of the signed range, so a single compare finds them.
+inline __m128i foldBlock(__m128i bytes) {
+  __m128i shifted = _mm_add_epi8(bytes, _mm_set1_epi8(0x80 - 'a'));
+  __m128i isLower = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+  return _mm_sub_epi8(bytes, _mm_and_si128(isLower, _mm_set1_epi8(0x20)));
+}
+
+inline __m128i load16(const char* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+void foldAsciiSse2(char*& data, std::size_t& size) {
+  for (; size >= 16; data += 16, size -= 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), foldBlock(load16(data)));
+  }
+}
+
+// Tests 16 start positions at a time: only positions where both the first
+// and the last byte of the needle match are compared in full. Advances pos
+// past the positions it has ruled out.
+std::size_t findFoldedSse2(std::string_view haystack,
+                           std::string_view foldedNeedle, std::size_t& pos) {
+  const std::size_t last = foldedNeedle.size() - 1;
+  const __m128i first = _mm_set1_epi8(foldedNeedle.front());
+  const __m128i final = _mm_set1_epi8(foldedNeedle.back());
+  for (; pos + 16 + last <= haystack.size(); pos += 16) {
+    __m128i starts = foldBlock(load16(haystack.data() + pos));
+    __m128i ends = foldBlock(load16(haystack.data() + pos + last));
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(starts, first), _mm_cmpeq_epi8(ends, final))));
+    while (mask) {
+      std::size_t candidate = pos + static_cast<std::size_t>(__builtin_ctz(mask));
+      if (matchesFolded(haystack.data() + candidate + 1,
+                        foldedNeedle.data() + 1, foldedNeedle.size() - 1)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return std::string_view::npos;
+}
+
+bool equalsFoldedSse2(const char*& a, const char*& b, std::size_t& size) {
+  for (; size >= 16; a += 16, b += 16, size -= 16) {
+    __m128i equal =
+        _mm_cmpeq_epi8(foldBlock(load16(a)), foldBlock(load16(b)));
+    if (_mm_movemask_epi8(equal) != 0xFFFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif  // CASEFOLD_SSE2
+
+#if CASEFOLD_AVX2
+
+bool hasAvx2() {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return supported;
+}
+
+// The AVX2 versions mirror the SSE2 ones above, 32 bytes at a time.
+__attribute__((target("avx2"))) inline __m256i foldBlock32(__m256i bytes) {
+  __m256i shifted = _mm256_add_epi8(bytes, _mm256_set1_epi8(0x80 - 'a'));
+  __m256i isLower = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_sub_epi8(bytes,
+                         _mm256_and_si256(isLower, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2"))) inline __m256i load32(const char* data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+__attribute__((target("avx2"))) void foldAsciiAvx2(char*& data,
+                                                   std::size_t& size) {
+  for (; size >= 32; data += 32, size -= 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data),
+                        foldBlock32(load32(data)));
+  }
+}
+
+__attribute__((target("avx2"))) std::size_t findFoldedAvx2(
+    std::string_view haystack, std::string_view foldedNeedle,
+    std::size_t& pos) {
+  const std::size_t last = foldedNeedle.size() - 1;
+  const __m256i first = _mm256_set1_epi8(foldedNeedle.front());
+  const __m256i final = _mm256_set1_epi8(foldedNeedle.back());
+  for (; pos + 32 + last <= haystack.size(); pos += 32) {
+    __m256i starts = foldBlock32(load32(haystack.data() + pos));
+    __m256i ends = foldBlock32(load32(haystack.data() + pos + last));
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(starts, first),
+                                              _mm256_cmpeq_epi8(ends, final))));
+    while (mask) {
+      std::size_t candidate = pos + static_cast<std::size_t>(__builtin_ctz(mask));
+      if (matchesFolded(haystack.data() + candidate + 1,
+                        foldedNeedle.data() + 1, foldedNeedle.size() - 1)) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return std::string_view::npos;
+}
+
+__attribute__((target("avx2"))) bool equalsFoldedAvx2(const char*& a,
+                                                      const char*& b,
+                                                      std::size_t& size) {
+  for (; size >= 32; a += 32, b += 32, size -= 32) {
+    __m256i equal =
+        _mm256_cmpeq_epi8(foldBlock32(load32(a)), foldBlock32(load32(b)));
+    if (static_cast<unsigned>(_mm256_movemask_epi8(equal)) != 0xFFFFFFFFu) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#endif  // CASEFOLD_AVX2
+
+}  // namespace
+
+void foldAscii(char* data, std::size_t size) {
+#if CASEFOLD_AVX2
+  if (hasAvx2()) {
+    foldAsciiAvx2(data, size);
+  }
+#endif
+#if CASEFOLD_SSE2
+  foldAsciiSse2(data, size);
+#endif
+  foldAsciiScalar(data, size);
+}
+
+std::size_t findFolded(std::string_view haystack,
+                       std::string_view foldedNeedle) {
+  if (foldedNeedle.empty()) {
+    return 0;
+  }
+  std::size_t pos = 0;
+#if CASEFOLD_AVX2
+  if (hasAvx2()) {
+    std::size_t found = findFoldedAvx2(haystack, foldedNeedle, pos);
+    if (found != std::string_view::npos) {
+      return found;
+    }
+  }
+#endif
+#if CASEFOLD_SSE2
+  std::size_t found = findFoldedSse2(haystack, foldedNeedle, pos);
+  if (found != std::string_view::npos) {
+    return found;
+  }
+#endif
+  return findFoldedFrom(haystack, foldedNeedle, pos);
+}
+
+bool equalsFolded(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  const char* left = a.data();
+  const char* right = b.data();
+  std::size_t size = a.size();
+#if CASEFOLD_AVX2
+  if (hasAvx2() && !equalsFoldedAvx2(left, right, size)) {
+    return false;
+  }
+#endif
+#if CASEFOLD_SSE2
+  if (!equalsFoldedSse2(left, right, size)) {
+    return false;
+  }
+#endif
+  return equalsFoldedScalar(std::string_view(left, size),
+                            std::string_view(right, size));
+}
+
+std::size_t hashFolded(std::string_view s) {
+  // FNV-1a over the folded bytes.
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : s) {
+    hash ^= static_cast<unsigned char>(foldChar(c));
+    hash *= 1099511628211ull;
+  }
+  return static_cast<std::size_t>(hash);
+}
+
+void foldAsciiScalar(char* data, std::size_t size) {
+  for (std::size_t i = 0; i < size; ++i) {
+    data[i] = foldChar(data[i]);
+  }
+}
+
+std::size_t findFoldedScalar(std::string_view haystack,
+                             std::string_view foldedNeedle) {
+  return findFoldedFrom(haystack, foldedNeedle, 0);
+}
+
+bool equalsFoldedScalar(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (foldChar(a[i]) != foldChar(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
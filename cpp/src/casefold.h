@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// Case-insensitive string kernels. They fold ASCII letters only, which is
+// what std::toupper does in the "C" locale the player runs in, and never
+// allocate. On x86 they process 16 bytes at a time with SSE2, or 32 with
+// AVX2 when the CPU has it; elsewhere they fall back to the scalar versions.
+
+// Upper-cases an ASCII letter.
+constexpr char foldChar(char c) {
+  return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+// Upper-cases the ASCII letters of data in place.
+void foldAscii(char* data, std::size_t size);
+
+// Returns the position of the first occurrence of foldedNeedle in haystack,
+// ignoring case, or std::string_view::npos. The needle must already be
+// folded; the haystack is folded on the fly.
+std::size_t findFolded(std::string_view haystack,
+                       std::string_view foldedNeedle);
+
+// Returns whether a and b are equal, ignoring case.
+bool equalsFolded(std::string_view a, std::string_view b);
+
+// Hashes s so that strings equal under equalsFolded hash the same.
+std::size_t hashFolded(std::string_view s);
+
+// Byte-at-a-time versions of the kernels above, for comparison in tests and
+// benchmarks.
+void foldAsciiScalar(char* data, std::size_t size);
+std::size_t findFoldedScalar(std::string_view haystack,
+                             std::string_view foldedNeedle);
+bool equalsFoldedScalar(std::string_view a, std::string_view b);
+
+/**
+ * Hash and equality functors for containers keyed case-insensitively.
+ */
+struct FoldedHash {
+  std::size_t operator()(std::string_view s) const { return hashFolded(s); }
+};
+
+struct FoldedEqual {
+  bool operator()(std::string_view a, std::string_view b) const {
+    return equalsFolded(a, b);
+  }
+};
@@ -0,0 +1,232 @@
+#include "catalog.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "casefold.h"
+#include "helper.h"
+#include "searchpattern.h"
+
+namespace {
+
+// Catalogs smaller than this are parsed serially when the thread count is
+// left to the catalog; starting threads would cost more than it saves.
+const std::size_t kParallelParseThreshold = 4 << 20;
+
+// Returns whether term means something different as an ECMAScript regex than
+// as a plain substring.
+bool hasRegexSyntax(std::string_view term) {
+  return term.find_first_of("^$\\.*+?()[]{}|") != std::string_view::npos;
+}
+
+}  // namespace
+
+Catalog::Catalog(const std::string& catalogPath, unsigned parserThreads,
+                 const Catalog* previous)
+    : mFile(catalogPath) {
+  if (mFile.isOpen()) {
+    parse(mFile.contents(), parserThreads);
+    buildIndexes(previous);
+  }
+}
+
+void Catalog::parse(std::string_view contents, unsigned parserThreads) {
+  if (parserThreads == 0) {
+    parserThreads = contents.size() < kParallelParseThreshold
+                        ? 1
+                        : std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  if (parserThreads > 1) {
+    std::vector<CatalogRow> rows = parseCatalog(contents, parserThreads);
+    mVideos.reserve(rows.size());
+    mVideoIndex.reserve(rows.size(), mVideos);
+    for (const auto& row : rows) {
+      addVideo(row);
+    }
+    return;
+  }
+
+  // Size everything up front so that loading does not allocate per row.
+  std::size_t lineCount = countCatalogLines(contents);
+  mVideos.reserve(lineCount);
+  mVideoIndex.reserve(lineCount, mVideos);
+  forEachCatalogLine(contents, [this](std::string_view line) {
+    addVideo(parseCatalogLine(line));
+  });
+}
+
+Catalog::Catalog(MappedFile&& file, const SnapshotView& snapshot)
+    : mFile(std::move(file)) {
+  // The snapshot's tags are distinct, so interning them in order hands out
+  // the same ids the videos were saved with.
+  for (std::size_t i = 0; i < snapshot.tagCount(); ++i) {
+    mTagDictionary.intern(snapshot.tag(i));
+  }
+  mTagDictionary.assignOverflow(snapshot.tagOverflow());
+  mVideos.reserve(snapshot.videoCount());
+  for (std::size_t i = 0; i < snapshot.videoCount(); ++i) {
+    mVideos.emplace_back(snapshot.videoTitle(i), snapshot.videoId(i),
+                         &mTagDictionary, snapshot.videoTags(i));
+  }
+  mVideoIndex.assign(snapshot.indexSlots(), snapshot.videoCount());
+  mTitleOrder.assign(snapshot.titleOrder());
+  mTagIndex.assign(snapshot.tagPostingOffsets(), snapshot.tagPostings());
+  mTitleIndex.assign(snapshot.titleTrigrams(), snapshot.titlePostingOffsets(),
+                     snapshot.titlePostings());
+}
+
+std::shared_ptr<const Catalog> Catalog::open(const std::string& catalogPath,
+                                             const std::string& snapshotPath,
+                                             unsigned parserThreads,
+                                             const Catalog* previous) {
+  if (!snapshotPath.empty() && snapshotIsFresh(snapshotPath, catalogPath)) {
+    MappedFile file(snapshotPath);
+    SnapshotView snapshot;
+    if (file.isOpen() && snapshot.open(file.contents())) {
+      return std::make_shared<const Catalog>(std::move(file), snapshot);
+    }
+  }
+  return std::make_shared<const Catalog>(catalogPath, parserThreads, previous);
+}
+
+void Catalog::addVideo(const CatalogRow& row) {
+  // Like unordered_map::emplace, the first video with a given id wins.
+  if (mVideoIndex.find(row.videoId, mVideos) != VideoIndex::npos) {
+    return;
+  }
+  mRowTags.clear();
+  forEachCatalogTag(row.tags, [this](std::string_view tag) {
+    mRowTags.push_back(mTagDictionary.intern(tag));
+  });
+  mVideos.emplace_back(
+      row.title, row.videoId, &mTagDictionary,
+      mTagDictionary.makeTagSet(mRowTags.data(), mRowTags.size()));
+  mVideoIndex.insert(static_cast<std::uint32_t>(mVideos.size() - 1), mVideos);
+}
+
+void Catalog::buildIndexes(const Catalog* previous) {
+  if (!previous || !reuseTitleOrder(*previous)) {
+    std::vector<std::uint32_t> titleOrder(mVideos.size());
+    for (std::uint32_t position = 0; position < mVideos.size(); ++position) {
+      titleOrder[position] = position;
+    }
+    std::sort(titleOrder.begin(), titleOrder.end(),
+              [this](std::uint32_t a, std::uint32_t b) {
+                return titleLess(a, b);
+              });
+    mTitleOrder.assign(std::move(titleOrder));
+  }
+  mTagIndex.build(mVideos, mTagDictionary, mTitleOrder.span());
+  mTitleIndex.build(mVideos, mTitleOrder.span());
+}
+
+// Orders positions by title, ties in catalog order.
+bool Catalog::titleLess(std::uint32_t a, std::uint32_t b) const {
+  int order = mVideos[a].getTitle().compare(mVideos[b].getTitle());
+  return order < 0 || (order == 0 && a < b);
+}
+
+// Builds the title order from the one of the catalog being replaced: the
+// videos that kept their id and title are already in order, so only the new
+// or retitled ones need sorting, after which the two runs are merged. Returns
+// false, leaving the order to be sorted from scratch, if the rows moved
+// around so much that the kept videos are no longer in order.
+bool Catalog::reuseTitleOrder(const Catalog& previous) {
+  std::vector<std::uint32_t> kept;
+  kept.reserve(std::min(previous.mVideos.size(), mVideos.size()));
+  std::vector<bool> isKept(mVideos.size(), false);
+  for (std::uint32_t oldPosition : previous.mTitleOrder) {
+    const Video& video = previous.mVideos[oldPosition];
+    std::uint32_t position = mVideoIndex.find(video.getVideoId(), mVideos);
+    if (position != VideoIndex::npos &&
+        mVideos[position].getTitle() == video.getTitle()) {
+      if (!kept.empty() && !titleLess(kept.back(), position)) {
+        return false;
+      }
+      kept.push_back(position);
+      isKept[position] = true;
+    }
+  }
+  std::vector<std::uint32_t> added;
+  added.reserve(mVideos.size() - kept.size());
+  for (std::uint32_t position = 0; position < mVideos.size(); ++position) {
+    if (!isKept[position]) {
+      added.push_back(position);
+    }
+  }
+  auto less = [this](std::uint32_t a, std::uint32_t b) {
+    return titleLess(a, b);
+  };
+  std::sort(added.begin(), added.end(), less);
+  std::vector<std::uint32_t> titleOrder(mVideos.size());
+  std::merge(kept.begin(), kept.end(), added.begin(), added.end(),
+             titleOrder.begin(), less);
+  mTitleOrder.assign(std::move(titleOrder));
+  return true;
+}
+
+const Video* Catalog::getVideo(std::string_view videoId) const {
+  std::uint32_t position = mVideoIndex.find(videoId, mVideos);
+  return position == VideoIndex::npos ? nullptr : &mVideos[position];
+}
+
+VideoHandle Catalog::findVideo(std::string_view videoId) const {
+  static_assert(VideoIndex::npos == kNoVideo,
+                "video positions are handles");
+  return mVideoIndex.find(videoId, mVideos);
+}
+
+std::vector<std::uint32_t> Catalog::searchTitles(
+    std::string_view searchTerm, bool* complete,
+    std::uint64_t stepBudget) const {
+  std::vector<std::uint32_t> matches;
+  if (complete) {
+    *complete = true;
+  }
+
+  if (hasRegexSyntax(searchTerm)) {
+    std::optional<SearchPattern> pattern = SearchPattern::compile(searchTerm);
+    if (!pattern) {
+      return matches;
+    }
+    for (std::uint32_t position : mTitleOrder) {
+      switch (pattern->search(mVideos[position].getTitle(), stepBudget)) {
+        case SearchPattern::Result::kMatch:
+          matches.push_back(position);
+          break;
+        case SearchPattern::Result::kNoMatch:
+          break;
+        case SearchPattern::Result::kOutOfSteps:
+          if (complete) {
+            *complete = false;
+          }
+          return matches;
+      }
+    }
+    return matches;
+  }
+
+  std::string folded = stringToUpper(std::string(searchTerm));
+  if (folded.size() < TitleIndex::kGramSize) {
+    for (std::uint32_t position : mTitleOrder) {
+      if (findFolded(mVideos[position].getTitle(), folded) !=
+          std::string_view::npos) {
+        matches.push_back(position);
+      }
+    }
+    return matches;
+  }
+
+  // Every candidate holds all of the term's trigrams, but not necessarily
+  // next to each other.
+  for (std::uint32_t rank : mTitleIndex.candidates(folded)) {
+    std::uint32_t position = mTitleOrder[rank];
+    if (findFolded(mVideos[position].getTitle(), folded) !=
+        std::string_view::npos) {
+      matches.push_back(position);
+    }
+  }
+  return matches;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "catalogparser.h"
+#include "mappedfile.h"
+#include "snapshot.h"
+#include "span.h"
+#include "tagdictionary.h"
+#include "tagindex.h"
+#include "titleindex.h"
+#include "video.h"
+#include "videoindex.h"
+#include "wordarray.h"
+
+/**
+ * A class used to represent the immutable part of a video library: the
+ * videos and the index used to look them up by id. Catalogs are shared as
+ * std::shared_ptr<const Catalog>, so a new one can be swapped in while the
+ * old one is still being read.
+ *
+ * Because videos are views into the mapped file, a catalog file must be
+ * replaced (written elsewhere and renamed over it) rather than rewritten in
+ * place while a catalog loaded from it is alive.
+ */
+class Catalog {
+ private:
+  // The file every Video holds views into.
+  MappedFile mFile;
+  TagDictionary mTagDictionary;
+  std::vector<Video> mVideos;
+  VideoIndex mVideoIndex;
+  // Video positions sorted by title (ties in catalog order).
+  WordArray mTitleOrder;
+  TagIndex mTagIndex;
+  TitleIndex mTitleIndex;
+  // Reused while loading to collect the tag ids of one row.
+  std::vector<TagId> mRowTags;
+
+  void parse(std::string_view contents, unsigned parserThreads);
+  void addVideo(const CatalogRow& row);
+  void buildIndexes(const Catalog* previous);
+  bool reuseTitleOrder(const Catalog& previous);
+  bool titleLess(std::uint32_t a, std::uint32_t b) const;
+
+ public:
+  // Creates an empty catalog.
+  Catalog() = default;
+
+  // Loads the videos.txt-format file at catalogPath, parsing it on
+  // parserThreads threads. With 0, large catalogs are parsed on every
+  // hardware thread and small ones serially. Given the catalog this one
+  // replaces, the title order is updated from the previous one rather than
+  // sorted from scratch.
+  explicit Catalog(const std::string& catalogPath, unsigned parserThreads = 0,
+                   const Catalog* previous = nullptr);
+
+  // Adopts a snapshot that has already been validated. The view must be over
+  // file's contents. The id index, title order and search indexes are read
+  // from the mapping in place; only the videos and tags are rebuilt.
+  Catalog(MappedFile&& file, const SnapshotView& snapshot);
+
+  // Loads the snapshot if it exists and is newer than the text catalog, and
+  // the text catalog otherwise. Either path may be empty.
+  static std::shared_ptr<const Catalog> open(const std::string& catalogPath,
+                                             const std::string& snapshotPath,
+                                             unsigned parserThreads = 0,
+                                             const Catalog* previous = nullptr);
+
+  // This class is not copyable to avoid expensive copies.
+  Catalog(const Catalog&) = delete;
+  Catalog& operator=(const Catalog&) = delete;
+
+  // Returns whether the catalog file could be opened.
+  bool isOpen() const { return mFile.isOpen(); }
+  // Returns whether the file the catalog was loaded from has since been
+  // written in place, which the catalog's views of it do not survive.
+  bool changedOnDisk() const { return mFile.changedOnDisk(); }
+
+  const std::vector<Video>& getVideos() const { return mVideos; }
+  const Video* getVideo(std::string_view videoId) const;
+  // Returns the handle of the video with the given id, or kNoVideo.
+  VideoHandle findVideo(std::string_view videoId) const;
+  const VideoIndex& getVideoIndex() const { return mVideoIndex; }
+  const TagDictionary& getTagDictionary() const { return mTagDictionary; }
+  Span<std::uint32_t> getTitleOrder() const { return mTitleOrder.span(); }
+  const TagIndex& getTagIndex() const { return mTagIndex; }
+  const TitleIndex& getTitleIndex() const { return mTitleIndex; }
+
+  // The default number of steps a regex search may take (see
+  // SearchPattern), which bounds its latency on any catalog and pattern.
+  static constexpr std::uint64_t kSearchStepBudget = 1 << 26;
+
+  // Returns the positions of the videos whose title matches searchTerm,
+  // ignoring case, in title order. A plain term is looked up as a substring
+  // through the title index; a term with regex metacharacters is matched as
+  // a regex against every title, and an invalid or unsupported one matches
+  // nothing. A regex search stops after stepBudget steps, returning the
+  // matches found so far and setting *complete (if given) to false.
+  std::vector<std::uint32_t> searchTitles(
+      std::string_view searchTerm, bool* complete = nullptr,
+      std::uint64_t stepBudget = kSearchStepBudget) const;
+};
@@ -0,0 +1,125 @@
+#include "cataloggenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const char* const kTitleWords[] = {"Funny",   "Amazing", "Cats",    "Dogs",
+                                   "Google",  "Life",    "Video",   "Another",
+                                   "Nothing", "About",   "Music",   "Live"};
+constexpr std::size_t kTitleWordCount =
+    sizeof(kTitleWords) / sizeof(kTitleWords[0]);
+
+// Rows are built in a buffer and written out in blocks of about this size.
+constexpr std::size_t kWriteBlock = 1 << 20;
+
+enum class RowShape {
+  Plain,
+  NoTagField,
+  EmptyTagField,
+  BlankTags,
+  Padded,
+  NonAsciiTitle
+};
+constexpr unsigned kEdgeCaseShapes = 5;
+
+}  // namespace
+
+CatalogGenerator::CatalogGenerator(const CatalogOptions& options)
+    : mOptions(options), mRandom(options.seed) {
+  mOptions.maxTitleWords =
+      std::max(mOptions.minTitleWords, mOptions.maxTitleWords);
+  mTagWeights.reserve(mOptions.tagVocabulary);
+  double total = 0;
+  for (std::size_t rank = 0; rank < mOptions.tagVocabulary; ++rank) {
+    total += 1.0 / std::pow(static_cast<double>(rank + 1), mOptions.tagSkew);
+    mTagWeights.push_back(total);
+  }
+}
+
+std::size_t CatalogGenerator::drawTag() {
+  std::uniform_real_distribution<double> weight(0.0, mTagWeights.back());
+  auto found =
+      std::upper_bound(mTagWeights.begin(), mTagWeights.end(), weight(mRandom));
+  // Rounding can put the draw on the very last total.
+  return std::min(static_cast<std::size_t>(found - mTagWeights.begin()),
+                  mTagWeights.size() - 1);
+}
+
+void CatalogGenerator::appendRow(std::string& out, std::size_t row) {
+  RowShape shape = RowShape::Plain;
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+  if (mOptions.edgeCaseRate > 0 && chance(mRandom) < mOptions.edgeCaseRate) {
+    shape = static_cast<RowShape>(1 + mRandom() % kEdgeCaseShapes);
+  }
+  bool padded = shape == RowShape::Padded;
+  if (padded) {
+    out += " \t ";
+  }
+  if (shape == RowShape::NonAsciiTitle) {
+    out += "Caf\xC3\xA9 \xC3\x9C" "ber ";
+  }
+  std::size_t words =
+      mOptions.minTitleWords +
+      mRandom() % (mOptions.maxTitleWords - mOptions.minTitleWords + 1);
+  for (std::size_t word = 0; word < words; ++word) {
+    out += kTitleWords[mRandom() % kTitleWordCount];
+    out += ' ';
+  }
+  out += std::to_string(row);
+  out += padded ? "\t  |  video_" : " | video_";
+  out += std::to_string(row);
+  out += "_id";
+  if (shape == RowShape::NoTagField) {
+    out += '\n';
+    return;
+  }
+  out += padded ? " \t|" : " |";
+
+  mRowTags.clear();
+  if (shape != RowShape::EmptyTagField && !mTagWeights.empty()) {
+    // Drawing the same tag twice leaves the video with one fewer.
+    std::size_t draws = mRandom() % (mOptions.maxTagsPerVideo + 1);
+    for (std::size_t draw = 0; draw < draws; ++draw) {
+      std::size_t tag = drawTag();
+      if (std::find(mRowTags.begin(), mRowTags.end(), tag) ==
+          mRowTags.end()) {
+        mRowTags.push_back(tag);
+      }
+    }
+  }
+  const char* separator = padded ? "\t,  " : " , ";
+  if (shape == RowShape::BlankTags) {
+    separator = " ,, ";
+  }
+  for (std::size_t tag = 0; tag < mRowTags.size(); ++tag) {
+    out += tag ? separator : (padded ? "\t" : " ");
+    out += "#tag";
+    out += std::to_string(mRowTags[tag]);
+  }
+  if (shape == RowShape::BlankTags) {
+    out += " ,";
+  } else if (padded) {
+    out += "  ";
+  }
+  out += '\n';
+}
+
+bool CatalogGenerator::write(std::ostream& out) {
+  std::string block;
+  block.reserve(kWriteBlock + 256);
+  for (std::size_t row = 0; row < mOptions.rows; ++row) {
+    if (block.size() >= kWriteBlock) {
+      out.write(block.data(), static_cast<std::streamsize>(block.size()));
+      block.clear();
+    }
+    appendRow(block, row);
+  }
+  if (mOptions.edgeCaseRate > 0 && !block.empty()) {
+    block.pop_back();
+  }
+  out.write(block.data(), static_cast<std::streamsize>(block.size()));
+  out.flush();
+  return static_cast<bool>(out);
+}
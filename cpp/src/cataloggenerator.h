@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// The shape of a synthetic catalog.
+struct CatalogOptions {
+  std::size_t rows = 1000;
+  // Each title has between minTitleWords and maxTitleWords words, drawn
+  // uniformly, followed by its row number.
+  std::size_t minTitleWords = 2;
+  std::size_t maxTitleWords = 5;
+  // Tags are "#tag0" to "#tagN-1" for a vocabulary of N.
+  std::size_t tagVocabulary = 1000;
+  // Each video has up to this many distinct tags, the count drawn
+  // uniformly from zero up.
+  std::size_t maxTagsPerVideo = 3;
+  // The Zipf exponent of tag popularity: "#tagK" is drawn with weight
+  // 1 / (K + 1)^tagSkew, so 0 makes every tag equally likely.
+  double tagSkew = 1.0;
+  // The share of rows, from 0 to 1, written in one of the awkward forms the
+  // parser accepts: no tag field, an empty one, empty tags between commas,
+  // extra spaces and tabs around every field, or non-ASCII title words.
+  // With any, the last row also goes without its newline.
+  double edgeCaseRate = 0.0;
+  std::uint32_t seed = 42;
+};
+
+/**
+ * A class used to write synthetic videos.txt-format catalogs for scale
+ * testing. Row N always has the id "video_N_id", whatever its shape, so
+ * scripts and benchmarks can name videos in a catalog of any size; the
+ * same options and seed always give the same file.
+ */
+class CatalogGenerator {
+ private:
+  CatalogOptions mOptions;
+  std::mt19937 mRandom;
+  // The running total of each tag's weight, for drawing tags by rank.
+  std::vector<double> mTagWeights;
+  std::vector<std::size_t> mRowTags;
+
+  std::size_t drawTag();
+  void appendRow(std::string& out, std::size_t row);
+
+ public:
+  explicit CatalogGenerator(const CatalogOptions& options);
+
+  // Writes options.rows rows to out. Returns false if writing failed.
+  bool write(std::ostream& out);
+};
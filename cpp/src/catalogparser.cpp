@@ -0,0 +1,82 @@
+#include "catalogparser.h"
+
+#include <thread>
+
+CatalogRow parseCatalogLine(std::string_view line) {
+  CatalogRow row;
+  std::size_t titleEnd = line.find('|');
+  row.title = trimView(line.substr(0, titleEnd));
+  if (titleEnd == std::string_view::npos) {
+    return row;
+  }
+  std::string_view rest = line.substr(titleEnd + 1);
+  std::size_t idEnd = rest.find('|');
+  row.videoId = trimView(rest.substr(0, idEnd));
+  if (idEnd != std::string_view::npos) {
+    row.tags = rest.substr(idEnd + 1);
+  }
+  return row;
+}
+
+std::size_t countCatalogLines(std::string_view buffer) {
+  std::size_t lines = 0;
+  forEachCatalogLine(buffer, [&lines](std::string_view) { ++lines; });
+  return lines;
+}
+
+std::vector<std::string_view> splitCatalogChunks(std::string_view buffer,
+                                                 std::size_t chunkCount) {
+  std::vector<std::string_view> chunks;
+  if (chunkCount == 0) {
+    chunkCount = 1;
+  }
+  std::size_t target = buffer.size() / chunkCount + 1;
+  while (!buffer.empty()) {
+    std::size_t end = buffer.size();
+    if (chunks.size() + 1 < chunkCount && target < buffer.size()) {
+      std::size_t newline = buffer.find('\n', target - 1);
+      if (newline != std::string_view::npos) {
+        end = newline + 1;
+      }
+    }
+    chunks.push_back(buffer.substr(0, end));
+    buffer.remove_prefix(end);
+  }
+  return chunks;
+}
+
+std::vector<CatalogRow> parseCatalog(std::string_view buffer,
+                                     unsigned threadCount) {
+  std::vector<std::string_view> chunks =
+      splitCatalogChunks(buffer, threadCount);
+  // First count the lines of each chunk so that every thread can then parse
+  // straight into its own slice of a single result vector.
+  std::vector<std::size_t> offsets(chunks.size() + 1, 0);
+  std::vector<std::thread> workers;
+  for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    workers.emplace_back([&chunks, &offsets, chunk] {
+      offsets[chunk + 1] = countCatalogLines(chunks[chunk]);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    offsets[chunk + 1] += offsets[chunk];
+  }
+
+  std::vector<CatalogRow> rows(offsets.back());
+  for (std::size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+    workers.emplace_back([&chunks, &offsets, &rows, chunk] {
+      CatalogRow* out = rows.data() + offsets[chunk];
+      forEachCatalogLine(chunks[chunk], [&out](std::string_view line) {
+        *out++ = parseCatalogLine(line);
+      });
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return rows;
+}
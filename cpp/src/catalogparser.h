@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "helper.h"
+
+/**
+ * A single row of a videos.txt catalog, in the form
+ * "title | video_id | tag1, tag2, ...". Every field is a view into the
+ * catalog buffer, so parsing a row never allocates.
+ */
+struct CatalogRow {
+  std::string_view title;
+  std::string_view videoId;
+  // The raw, untrimmed comma-separated tag field; empty if the row has none.
+  std::string_view tags;
+};
+
+// Splits one catalog line (without its trailing newline) into its fields,
+// trimming the title and id exactly like the original stream-based parser.
+CatalogRow parseCatalogLine(std::string_view line);
+
+// Returns the number of lines in the buffer, counting a final line that is not
+// terminated by a newline.
+std::size_t countCatalogLines(std::string_view buffer);
+
+// Splits the buffer into at most chunkCount pieces of roughly equal size. Every
+// piece but the last ends just after a newline, so no line is split.
+std::vector<std::string_view> splitCatalogChunks(std::string_view buffer,
+                                                 std::size_t chunkCount);
+
+// Parses every line of the buffer on threadCount threads, one chunk per
+// thread. The rows are returned in file order.
+std::vector<CatalogRow> parseCatalog(std::string_view buffer,
+                                     unsigned threadCount);
+
+// Calls visitor with every trimmed tag of a row's tag field. Like
+// std::getline(stream, tag, ','), a comma that ends the field does not start
+// another (empty) tag, and an empty field has no tags.
+template <typename Visitor>
+void forEachCatalogTag(std::string_view field, Visitor&& visitor) {
+  std::size_t pos = 0;
+  while (pos < field.size()) {
+    std::size_t comma = field.find(',', pos);
+    std::size_t end = comma == std::string_view::npos ? field.size() : comma;
+    visitor(trimView(field.substr(pos, end - pos)));
+    pos = end + 1;
+  }
+}
+
+// Calls visitor with every line of the buffer, without its newline.
+template <typename Visitor>
+void forEachCatalogLine(std::string_view buffer, Visitor&& visitor) {
+  const char* pos = buffer.data();
+  const char* end = pos + buffer.size();
+  while (pos < end) {
+    const char* newline = static_cast<const char*>(
+        std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+    const char* lineEnd = newline ? newline : end;
+    visitor(std::string_view(pos, static_cast<std::size_t>(lineEnd - pos)));
+    pos = newline ? newline + 1 : end;
+  }
+}
@@ -0,0 +1,94 @@
+#include "catalogreloader.h"
+
+#include <utility>
+
+CatalogReloader::CatalogReloader(std::string catalogPath,
+                                 std::string snapshotPath,
+                                 unsigned parserThreads)
+    : mCatalogPath(std::move(catalogPath)),
+      mSnapshotPath(std::move(snapshotPath)),
+      mParserThreads(parserThreads) {}
+
+CatalogReloader::~CatalogReloader() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mRerun = false;
+  if (mWorker.joinable()) {
+    std::thread worker = std::move(mWorker);
+    lock.unlock();
+    worker.join();
+  }
+}
+
+std::uint64_t CatalogReloader::setCurrent(
+    std::shared_ptr<const Catalog> catalog) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (catalog != mCurrent) {
+    mCurrent = std::move(catalog);
+    mGeneration.fetch_add(1, std::memory_order_release);
+  }
+  return mGeneration.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<const Catalog> CatalogReloader::current(
+    std::uint64_t* generation, std::chrono::microseconds* loadTime) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  *generation = mGeneration.load(std::memory_order_relaxed);
+  if (loadTime) {
+    *loadTime = mLoadTime;
+  }
+  return mCurrent;
+}
+
+bool CatalogReloader::request() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mInProgress) {
+    mRerun = true;
+    return false;
+  }
+  // The previous worker has finished by now, it only needs reaping.
+  if (mWorker.joinable()) {
+    mWorker.join();
+  }
+  mInProgress = true;
+  mWorker = std::thread([this] {
+    std::unique_lock<std::mutex> lock(mMutex);
+    do {
+      mRerun = false;
+      std::shared_ptr<const Catalog> previous = mCurrent;
+      lock.unlock();
+      auto start = std::chrono::steady_clock::now();
+      std::shared_ptr<const Catalog> catalog = Catalog::open(
+          mCatalogPath, mSnapshotPath, mParserThreads, previous.get());
+      auto loadTime = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+      lock.lock();
+      // A newer build supersedes one nobody has picked up yet.
+      mPending = std::move(catalog);
+      mLoadTime = loadTime;
+    } while (mRerun);
+    mInProgress = false;
+    mDone.notify_all();
+  });
+  return true;
+}
+
+std::shared_ptr<const Catalog> CatalogReloader::takePending(
+    std::chrono::microseconds* loadTime) {
+  std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+  if (!lock.owns_lock() || !mPending) {
+    return nullptr;
+  }
+  if (loadTime) {
+    *loadTime = mLoadTime;
+  }
+  if (mPending->isOpen()) {
+    mCurrent = mPending;
+    mGeneration.fetch_add(1, std::memory_order_release);
+  }
+  return std::move(mPending);
+}
+
+void CatalogReloader::wait() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDone.wait(lock, [this] { return !mInProgress; });
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "catalog.h"
+
+/**
+ * A class used to build a fresh Catalog on a background thread. request() may
+ * be called from any thread (for instance a file watcher); the thread that
+ * owns the library picks the result up with takePending() at a command
+ * boundary, so commands never wait for a reload. Libraries sharing a
+ * reloader, one per session, notice that another has taken a new catalog
+ * through generation() and adopt it with current().
+ */
+class CatalogReloader {
+ private:
+  std::string mCatalogPath;
+  std::string mSnapshotPath;
+  unsigned mParserThreads;
+
+  std::mutex mMutex;
+  std::condition_variable mDone;
+  std::thread mWorker;
+  bool mInProgress = false;
+  // Set when the files change again during a build, which then runs once
+  // more so the result is never older than the last change.
+  bool mRerun = false;
+  std::shared_ptr<const Catalog> mPending;
+  std::chrono::microseconds mLoadTime{0};
+  // The catalog being served, which new builds are diffed against.
+  std::shared_ptr<const Catalog> mCurrent;
+  // Counts the catalogs served, so a library can check for a new one
+  // without locking.
+  std::atomic<std::uint64_t> mGeneration{0};
+
+ public:
+  CatalogReloader(std::string catalogPath, std::string snapshotPath,
+                  unsigned parserThreads);
+  ~CatalogReloader();
+
+  // This class is neither copyable nor movable, it is shared by pointer.
+  CatalogReloader(const CatalogReloader&) = delete;
+  CatalogReloader& operator=(const CatalogReloader&) = delete;
+
+  const std::string& getCatalogPath() const { return mCatalogPath; }
+  const std::string& getSnapshotPath() const { return mSnapshotPath; }
+
+  // Records the catalog being served. takePending() keeps it up to date
+  // afterwards. Returns the generation of the catalog.
+  std::uint64_t setCurrent(std::shared_ptr<const Catalog> catalog);
+
+  // Returns the generation of the catalog being served, which changes
+  // whenever a different one is.
+  std::uint64_t generation() const {
+    return mGeneration.load(std::memory_order_acquire);
+  }
+
+  // Returns the catalog being served, with its generation and how long it
+  // took to load.
+  std::shared_ptr<const Catalog> current(std::uint64_t* generation,
+                                         std::chrono::microseconds* loadTime);
+
+  // Starts building a new catalog, which replaces one still waiting to be
+  // picked up. Returns false if one is already being built; that build then
+  // runs again once it finishes, so it reads the files as they are now.
+  bool request();
+
+  // Returns the finished catalog, and how long it took to load, if there is
+  // one. Never blocks on the build itself.
+  std::shared_ptr<const Catalog> takePending(
+      std::chrono::microseconds* loadTime);
+
+  // Blocks until the current build, if any, has finished, including any
+  // reruns requested meanwhile.
+  void wait();
+};
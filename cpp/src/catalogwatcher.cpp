@@ -0,0 +1,118 @@
+#include "catalogwatcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+CatalogWatcher::CatalogWatcher(std::function<void()> onChange)
+    : mOnChange(std::move(onChange)) {}
+
+#if defined(__linux__)
+
+CatalogWatcher::~CatalogWatcher() {
+  if (mThread.joinable()) {
+    char stop = 0;
+    (void)::write(mStopPipe[1], &stop, 1);
+    mThread.join();
+  }
+  for (int fd : {mInotifyFd, mStopPipe[0], mStopPipe[1]}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+}
+
+bool CatalogWatcher::start(const std::vector<std::string>& paths) {
+  if (mThread.joinable() || ::pipe(mStopPipe) != 0) {
+    return false;
+  }
+  mInotifyFd = ::inotify_init1(IN_CLOEXEC);
+  if (mInotifyFd < 0) {
+    return false;
+  }
+  std::vector<std::string> fileNames;
+  for (const auto& path : paths) {
+    std::filesystem::path file(path);
+    std::filesystem::path directory = file.parent_path();
+    if (directory.empty()) {
+      directory = ".";
+    }
+    // Watching the directory catches a new file renamed over the old one,
+    // the only safe way to change a catalog that is mapped. Writes in place
+    // are watched only to warn about them.
+    if (::inotify_add_watch(mInotifyFd, directory.c_str(),
+                            IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+      fileNames.push_back(file.filename().string());
+    }
+  }
+  if (fileNames.empty()) {
+    return false;
+  }
+  mThread = std::thread(&CatalogWatcher::run, this, std::move(fileNames));
+  return true;
+}
+
+void CatalogWatcher::run(std::vector<std::string> fileNames) {
+  alignas(inotify_event) char buffer[4096];
+  pollfd fds[2] = {{mInotifyFd, POLLIN, 0}, {mStopPipe[0], POLLIN, 0}};
+  for (;;) {
+    if (::poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "Stopped watching the catalog: " << std::strerror(errno)
+                << std::endl;
+      return;
+    }
+    if (fds[1].revents & POLLIN) {
+      return;
+    }
+    ssize_t length = ::read(mInotifyFd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      continue;
+    }
+    bool changed = false;
+    for (char* pos = buffer; pos < buffer + length;) {
+      auto* event = reinterpret_cast<inotify_event*>(pos);
+      for (const auto& fileName : fileNames) {
+        if (!event->len || fileName != event->name) {
+          continue;
+        }
+        if (event->mask & IN_MOVED_TO) {
+          changed = true;
+        } else {
+          // The loaded catalog may already be reading the new bytes, or
+          // pages past a truncated end; a reload would not undo that.
+          std::cerr << "Warning: " << fileName
+                    << " was written in place; replace it by renaming a new "
+                       "file over it"
+                    << std::endl;
+        }
+      }
+      pos += sizeof(inotify_event) + event->len;
+    }
+    if (changed) {
+      mOnChange();
+    }
+  }
+}
+
+#else
+
+CatalogWatcher::~CatalogWatcher() {}
+
+bool CatalogWatcher::start(const std::vector<std::string>& paths) {
+  return false;
+}
+
+void CatalogWatcher::run(std::vector<std::string> fileNames) {}
+
+#endif
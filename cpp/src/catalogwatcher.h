@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * A class used to watch catalog files for changes. On Linux it uses inotify
+ * on the files' directories and calls onChange from its own thread whenever
+ * one of the files is replaced by renaming another over it; a file written
+ * in place only draws a warning on std::cerr, since the loaded catalog maps
+ * it. Elsewhere start() fails.
+ */
+class CatalogWatcher {
+ private:
+  std::function<void()> mOnChange;
+  std::thread mThread;
+  int mInotifyFd = -1;
+  // Written to by the destructor to wake the watch thread up.
+  int mStopPipe[2] = {-1, -1};
+
+  void run(std::vector<std::string> fileNames);
+
+ public:
+  explicit CatalogWatcher(std::function<void()> onChange);
+  ~CatalogWatcher();
+
+  // This class is neither copyable nor movable, its thread refers to it.
+  CatalogWatcher(const CatalogWatcher&) = delete;
+  CatalogWatcher& operator=(const CatalogWatcher&) = delete;
+
+  // Starts watching the given (non-empty) paths. Returns false if watching is
+  // not supported or none of the paths' directories can be watched.
+  bool start(const std::vector<std::string>& paths);
+};
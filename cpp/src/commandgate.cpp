@@ -0,0 +1,45 @@
+#include "commandgate.h"
+
+#include <thread>
+
+std::size_t CommandGate::threadSlot() {
+  static std::atomic<std::size_t> next{0};
+  thread_local std::size_t slot =
+      next.fetch_add(1, std::memory_order_relaxed) % kSlots;
+  return slot;
+}
+
+void CommandGate::enter() {
+  std::atomic<std::uint32_t>& active = mSlots[threadSlot()].active;
+  for (;;) {
+    // Announce the command before checking the gate; lockExclusive closes
+    // the gate before checking the counters, so one of them sees the other.
+    active.fetch_add(1, std::memory_order_seq_cst);
+    if (!mClosed.load(std::memory_order_seq_cst)) {
+      return;
+    }
+    active.fetch_sub(1, std::memory_order_release);
+    while (mClosed.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void CommandGate::leave() {
+  mSlots[threadSlot()].active.fetch_sub(1, std::memory_order_release);
+}
+
+void CommandGate::lockExclusive() {
+  mExclusive.lock();
+  mClosed.store(true, std::memory_order_seq_cst);
+  for (Slot& slot : mSlots) {
+    while (slot.active.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void CommandGate::unlockExclusive() {
+  mClosed.store(false, std::memory_order_release);
+  mExclusive.unlock();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * A class used to let many threads run commands on a library at once while
+ * one of them sometimes needs it to itself, to swap in a reloaded catalog.
+ * Entering and leaving only touch a counter on the calling thread's own
+ * cache line, so commands never contend with each other; taking the gate
+ * exclusively closes it and waits for every counter to drain.
+ *
+ * A thread must not enter the gate again before leaving it, nor take it
+ * exclusively while inside.
+ */
+class CommandGate {
+ private:
+  static constexpr std::size_t kSlots = 64;
+
+  struct alignas(64) Slot {
+    std::atomic<std::uint32_t> active{0};
+  };
+
+  Slot mSlots[kSlots];
+  std::atomic<bool> mClosed{false};
+  std::mutex mExclusive;
+
+  // Returns the slot of the calling thread, handed out round robin.
+  static std::size_t threadSlot();
+
+ public:
+  CommandGate() = default;
+
+  // This class is neither copyable nor movable, it is shared by pointer.
+  CommandGate(const CommandGate&) = delete;
+  CommandGate& operator=(const CommandGate&) = delete;
+
+  // Marks a command in progress on the calling thread, first waiting for
+  // the gate to open if it is taken exclusively.
+  void enter();
+  void leave();
+
+  // Waits until no command is in progress and keeps new ones out until
+  // unlockExclusive.
+  void lockExclusive();
+  void unlockExclusive();
+};
@@ -1,158 +1,354 @@
 #include "commandparser.h"
 
-#include <iostream>
-#include <sstream>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string>
 #include <utility>
-#include <vector>
 
-CommandParser::CommandParser(VideoPlayer&& vp) : mVideoPlayer(std::move(vp)) {}
+#include "casefold.h"
 
-void CommandParser::executeCommand(const std::vector<std::string>& command) {
-  if (command.empty()) {
-    std::cout << "No commands passed in to executeCommand, that is unexpected"
-              << std::endl;
-    return;
-  }
-
-  if (command[0] == "NUMBER_OF_VIDEOS") {
-    mVideoPlayer.numberOfVideos();
-  } else if (command[0] == "SHOW_ALL_VIDEOS") {
-    mVideoPlayer.showAllVideos();
-  } else if (command[0] == "PLAY") {
-    if (command.size() != 2) {
-      std::cout << "Please enter PLAY command followed by video_id."
-                << std::endl;
-    } else {
-      mVideoPlayer.playVideo(command[1]);
-    }
-  } else if (command[0] == "PLAY_RANDOM") {
-    mVideoPlayer.playRandomVideo();
-  } else if (command[0] == "STOP") {
-    mVideoPlayer.stopVideo();
-  } else if (command[0] == "PAUSE") {
-    mVideoPlayer.pauseVideo();
-  } else if (command[0] == "CONTINUE") {
-    mVideoPlayer.continueVideo();
-  } else if (command[0] == "SHOW_PLAYING") {
-    mVideoPlayer.showPlaying();
-  } else if (command[0] == "CREATE_PLAYLIST") {
-    if (command.size() != 2) {
-      std::cout << "Please enter CREATE_PLAYLIST command followed by video_id."
-                << std::endl;
-    } else {
-      mVideoPlayer.createPlaylist(command[1]);
-    }
-  } else if (command[0] == "ADD_TO_PLAYLIST") {
-    if (command.size() != 3) {
-      std::cout << "Please enter ADD_TO_PLAYLIST command followed by playlist "
-                   "name and video_id."
-                << std::endl;
-    } else {
-      mVideoPlayer.addVideoToPlaylist(command[1], command[2]);
-    }
-  } else if (command[0] == "REMOVE_FROM_PLAYLIST") {
-    if (command.size() != 3) {
-      std::cout << "Please enter REMOVE_FROM_PLAYLIST command followed by "
-                   "playlist name and video_id."
-                << std::endl;
-    } else {
-      mVideoPlayer.removeFromPlaylist(command[1], command[2]);
+namespace {
+
+/**
+ * A command the parser understands: its name, the arguments it takes, the
+ * help line describing it and how to run it on a player.
+ */
+struct CommandSpec {
+  std::string_view name;
+  // The names of the arguments, as shown in help.
+  std::array<std::string_view, 2> args;
+  // How usage messages describe the arguments.
+  std::array<std::string_view, 2> usage;
+  // Arguments past minArgs are optional. Commands without arguments ignore
+  // any they are given.
+  std::size_t minArgs;
+  std::size_t maxArgs;
+  std::string_view help;
+  // Runs the command, whose arguments are command[1] onwards. EXIT has none.
+  void (*run)(VideoPlayer& player, const CommandTokens& command);
+};
+
+void printHelp(VideoPlayer& player, const CommandTokens& command);
+
+constexpr CommandSpec kCommands[] = {
+    {"NUMBER_OF_VIDEOS", {}, {}, 0, 0,
+     "Shows how many videos are in the library.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.numberOfVideos();
+     }},
+    {"SHOW_ALL_VIDEOS", {}, {}, 0, 0, "Lists all videos from the library.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.showAllVideos();
+     }},
+    {"PLAY", {"video_id"}, {"video_id"}, 1, 1, "Plays specified video.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.playVideo(command[1]);
+     }},
+    {"PLAY_RANDOM", {}, {}, 0, 0, "Plays a random video from the library.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.playRandomVideo();
+     }},
+    {"STOP", {}, {}, 0, 0, "Stop the current video.",
+     [](VideoPlayer& player, const CommandTokens&) { player.stopVideo(); }},
+    {"PAUSE", {}, {}, 0, 0, "Pause the current video.",
+     [](VideoPlayer& player, const CommandTokens&) { player.pauseVideo(); }},
+    {"CONTINUE", {}, {}, 0, 0, "Resume the current paused video.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.continueVideo();
+     }},
+    {"SHOW_PLAYING", {}, {}, 0, 0,
+     "Displays the title, url and paused status of the video that is "
+     "currently playing (or paused).",
+     [](VideoPlayer& player, const CommandTokens&) { player.showPlaying(); }},
+    {"CREATE_PLAYLIST", {"playlist_name"}, {"video_id"}, 1, 1,
+     "Creates a new (empty) playlist with the provided name.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.createPlaylist(command[1]);
+     }},
+    {"ADD_TO_PLAYLIST",
+     {"playlist_name", "video_id"},
+     {"playlist name", "video_id"},
+     2,
+     2,
+     "Adds the requested video to the playlist.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.addVideoToPlaylist(command[1], command[2]);
+     }},
+    {"REMOVE_FROM_PLAYLIST",
+     {"playlist_name", "video_id"},
+     {"playlist name", "video_id"},
+     2,
+     2,
+     "Removes the specified video from the specified playlist",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.removeFromPlaylist(command[1], command[2]);
+     }},
+    {"CLEAR_PLAYLIST", {"playlist_name"}, {"a playlist name"}, 1, 1,
+     "Removes all the videos from the playlist.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.clearPlaylist(command[1]);
+     }},
+    {"DELETE_PLAYLIST", {"playlist_name"}, {"a playlist name"}, 1, 1,
+     "Deletes the playlist.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.deletePlaylist(command[1]);
+     }},
+    {"SHOW_PLAYLIST", {"playlist_name"}, {"a playlist name"}, 1, 1,
+     "List all the videos in this playlist.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.showPlaylist(command[1]);
+     }},
+    {"SHOW_ALL_PLAYLISTS", {}, {}, 0, 0, "Display all the available playlists.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.showAllPlaylists();
+     }},
+    {"SEARCH_VIDEOS",
+     {"search_term", "number"},
+     {"a search term", "result number"},
+     1,
+     2,
+     "Display all the videos whose titles contain the search_term, and play "
+     "result number if given.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       if (command.size() == 3) {
+         player.searchVideos(command[1], command[2]);
+       } else {
+         player.searchVideos(command[1]);
+       }
+     }},
+    {"SEARCH_VIDEOS_WITH_TAG",
+     {"tag_name", "number"},
+     {"a video tag", "result number"},
+     1,
+     2,
+     "Display all videos whose tags contains the provided tag, and play "
+     "result number if given.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       if (command.size() == 3) {
+         player.searchVideosWithTag(command[1], command[2]);
+       } else {
+         player.searchVideosWithTag(command[1]);
+       }
+     }},
+    {"FLAG_VIDEO",
+     {"video_id", "flag_reason"},
+     {"a video_id", "flag reason"},
+     1,
+     2,
+     "Mark a video as flagged.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       if (command.size() == 3) {
+         player.flagVideo(command[1], command[2]);
+       } else {
+         player.flagVideo(command[1]);
+       }
+     }},
+    {"ALLOW_VIDEO", {"video_id"}, {"a video_id"}, 1, 1,
+     "Removes a flag from a video.",
+     [](VideoPlayer& player, const CommandTokens& command) {
+       player.allowVideo(command[1]);
+     }},
+    {"RELOAD_LIBRARY", {}, {}, 0, 0,
+     "Reloads the video library from disk without stopping playback.",
+     [](VideoPlayer& player, const CommandTokens&) {
+       player.reloadLibrary();
+     }},
+    {"HELP", {}, {}, 0, 0, "Displays help.", printHelp},
+    {"EXIT", {}, {}, 0, 0, "Terminates the program execution.", nullptr},
+};
+
+constexpr std::size_t kCommandCount = std::size(kCommands);
+
+constexpr bool hasValidArity() {
+  for (const CommandSpec& spec : kCommands) {
+    if (spec.minArgs > spec.maxArgs || spec.maxArgs > spec.args.size() ||
+        spec.maxArgs + 1 > CommandTokens::kMaxTokens) {
+      return false;
     }
-  } else if (command[0] == "CLEAR_PLAYLIST") {
-    if (command.size() != 2) {
-      std::cout
-          << "Please enter CLEAR_PLAYLIST command followed by a playlist name."
-          << std::endl;
-    } else {
-      mVideoPlayer.clearPlaylist(command[1]);
+    for (std::size_t arg = 0; arg < spec.maxArgs; ++arg) {
+      if (spec.args[arg].empty() || spec.usage[arg].empty()) {
+        return false;
+      }
     }
-  } else if (command[0] == "DELETE_PLAYLIST") {
-    if (command.size() != 2) {
-      std::cout
-          << "Please enter DELETE_PLAYLIST command followed by a playlist name."
-          << std::endl;
-    } else {
-      mVideoPlayer.deletePlaylist(command[1]);
+  }
+  return true;
+}
+static_assert(hasValidArity(), "every argument a command takes needs a name");
+
+constexpr std::size_t longestName() {
+  std::size_t longest = 0;
+  for (const CommandSpec& spec : kCommands) {
+    longest = spec.name.size() > longest ? spec.name.size() : longest;
+  }
+  return longest;
+}
+
+constexpr std::size_t kLongestName = longestName();
+
+// Commands are found through a perfect hash: a seeded FNV-1a of the
+// upper-cased name, with the seed picked at compile time so that no two
+// commands share a slot. A lookup is one hash, one table load and one
+// comparison.
+constexpr unsigned kHashBits = 6;
+constexpr std::size_t kSlotCount = std::size_t{1} << kHashBits;
+constexpr std::uint8_t kEmptySlot = 0xFF;
+static_assert(kCommandCount < kEmptySlot && kCommandCount <= kSlotCount,
+              "too many commands for the dispatch table");
+
+constexpr std::size_t hashName(std::string_view name, std::uint32_t seed) {
+  std::uint32_t hash = seed;
+  for (char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(foldChar(c))) * 16777619u;
+  }
+  return hash >> (32 - kHashBits);
+}
+
+constexpr bool isPerfectSeed(std::uint32_t seed) {
+  std::array<bool, kSlotCount> used{};
+  for (const CommandSpec& spec : kCommands) {
+    std::size_t slot = hashName(spec.name, seed);
+    if (used[slot]) {
+      return false;
     }
-  } else if (command[0] == "SHOW_PLAYLIST") {
-    if (command.size() != 2) {
-      std::cout
-          << "Please enter SHOW_PLAYLIST command followed by a playlist name."
-          << std::endl;
-    } else {
-      mVideoPlayer.showPlaylist(command[1]);
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr std::uint32_t findPerfectSeed() {
+  constexpr std::uint32_t kFnvOffset = 2166136261u;
+  for (std::uint32_t seed = kFnvOffset; seed != kFnvOffset + 100000; ++seed) {
+    if (isPerfectSeed(seed)) {
+      return seed;
     }
-  } else if (command[0] == "SHOW_ALL_PLAYLISTS") {
-    mVideoPlayer.showAllPlaylists();
-  } else if (command[0] == "SEARCH_VIDEOS") {
-    if (command.size() != 2) {
-      std::cout
-          << "Please enter SEARCH_VIDEOS command followed by a search term."
-          << std::endl;
-    } else {
-      mVideoPlayer.searchVideos(command[1]);
+  }
+  return 0;
+}
+
+constexpr std::uint32_t kSeed = findPerfectSeed();
+static_assert(isPerfectSeed(kSeed), "no perfect hash seed for the commands");
+
+constexpr std::array<std::uint8_t, kSlotCount> buildSlots() {
+  std::array<std::uint8_t, kSlotCount> slots{};
+  for (std::size_t slot = 0; slot < kSlotCount; ++slot) {
+    slots[slot] = kEmptySlot;
+  }
+  for (std::size_t command = 0; command < kCommandCount; ++command) {
+    slots[hashName(kCommands[command].name, kSeed)] =
+        static_cast<std::uint8_t>(command);
+  }
+  return slots;
+}
+
+constexpr std::array<std::uint8_t, kSlotCount> kSlots = buildSlots();
+
+// Returns the command named name, ignoring case, or nullptr.
+const CommandSpec* findCommand(std::string_view name) {
+  if (name.size() > kLongestName) {
+    return nullptr;
+  }
+  std::uint8_t slot = kSlots[hashName(name, kSeed)];
+  if (slot == kEmptySlot) {
+    return nullptr;
+  }
+  const CommandSpec& spec = kCommands[slot];
+  if (spec.name.size() != name.size()) {
+    return nullptr;
+  }
+  for (std::size_t i = 0; i < name.size(); ++i) {
+    if (foldChar(name[i]) != spec.name[i]) {
+      return nullptr;
     }
-  } else if (command[0] == "SEARCH_VIDEOS_WITH_TAG") {
-    if (command.size() != 2) {
-      std::cout << "Please enter SEARCH_VIDEOS_WITH_TAG command followed by a "
-                   "video tag."
-                << std::endl;
-    } else {
-      mVideoPlayer.searchVideosWithTag(command[1]);
+  }
+  return &spec;
+}
+
+void printUsage(OutputSink& output, const CommandSpec& spec) {
+  output << "Please enter " << spec.name << " command followed by ";
+  for (std::size_t arg = 0; arg < spec.maxArgs; ++arg) {
+    if (arg > 0) {
+      output << " and ";
     }
-  } else if (command[0] == "FLAG_VIDEO") {
-    switch (command.size()) {
-      case 2:
-        mVideoPlayer.flagVideo(command[1]);
-        break;
-      case 3:
-        mVideoPlayer.flagVideo(command[1], command[2]);
-        break;
-      default:
-        std::cout << "Please enter FLAG_VIDEO command followed by a video_id "
-                     "and an optional flag reason."
-                  << std::endl;
+    if (arg >= spec.minArgs) {
+      output << "an optional ";
     }
-  } else if (command[0] == "ALLOW_VIDEO") {
-    if (command.size() != 2) {
-      std::cout << "Please enter ALLOW_VIDEO command followed by a video_id."
-                << std::endl;
-    } else {
-      mVideoPlayer.allowVideo(command[1]);
+    output << spec.usage[arg];
+  }
+  output << '.' << '\n';
+}
+
+void printHelp(VideoPlayer& player, const CommandTokens&) {
+  OutputSink& output = player.getOutput();
+  output << '\n' << "Available commands:" << '\n';
+  for (const CommandSpec& spec : kCommands) {
+    output << "    " << spec.name;
+    for (std::size_t arg = 0; arg < spec.maxArgs; ++arg) {
+      if (arg < spec.minArgs) {
+        output << " <" << spec.args[arg] << '>';
+      } else {
+        output << " [<" << spec.args[arg] << ">]";
+      }
     }
-  } else if (command[0] == "HELP") {
-    getHelp();
+    output << " - " << spec.help << '\n';
+  }
+  output << '\n';
+}
+
+void printInvalidCommand(OutputSink& output) {
+  output << "Please enter a valid command, type HELP for a list of "
+            "available commands."
+         << '\n';
+}
+
+}  // namespace
+
+CommandParser::CommandParser(VideoPlayer&& vp) : mVideoPlayer(std::move(vp)) {}
+
+bool CommandParser::executeCommand(const CommandTokens& command) {
+  if (command.empty()) {
+    printInvalidCommand(mVideoPlayer.getOutput());
+    return true;
+  }
+  const CommandSpec* spec = findCommand(command[0]);
+  if (spec && !spec->run) {
+    // EXIT, whatever follows it.
+    return false;
+  }
+
+  auto scope = mVideoPlayer.beginCommand();
+
+  if (!spec) {
+    printInvalidCommand(mVideoPlayer.getOutput());
+  } else if (spec->maxArgs > 0 && (command.size() - 1 < spec->minArgs ||
+                                   command.size() - 1 > spec->maxArgs)) {
+    printUsage(mVideoPlayer.getOutput(), *spec);
   } else {
-    std::cout << "Please enter a valid command, type HELP for a list of "
-                 "available commands."
-              << std::endl;
+    spec->run(mVideoPlayer, command);
   }
+  return true;
+}
+
+bool CommandParser::executeLine(std::string_view line) {
+  return executeCommand(CommandTokens(line));
 }
 
-void CommandParser::getHelp() const {
-  static const char* const helpText = R"(
-Available commands:
-    NUMBER_OF_VIDEOS - Shows how many videos are in the library.
-    SHOW_ALL_VIDEOS - Lists all videos from the library.
-    PLAY <video_id> - Plays specified video.
-    PLAY_RANDOM - Plays a random video from the library.
-    STOP - Stop the current video.
-    PAUSE - Pause the current video.
-    CONTINUE - Resume the current paused video.
-    SHOW_PLAYING - Displays the title, url and paused status of the video that is currently playing (or paused).
-    CREATE_PLAYLIST <playlist_name> - Creates a new (empty) playlist with the provided name.
-    ADD_TO_PLAYLIST <playlist_name> <video_id> - Adds the requested video to the playlist.
-    REMOVE_FROM_PLAYLIST <playlist_name> <video_id> - Removes the specified video from the specified playlist
-    CLEAR_PLAYLIST <playlist_name> - Removes all the videos from the playlist.
-    DELETE_PLAYLIST <playlist_name> - Deletes the playlist.
-    SHOW_PLAYLIST <playlist_name> - List all the videos in this playlist.
-    SHOW_ALL_PLAYLISTS - Display all the available playlists.
-    SEARCH_VIDEOS <search_term> - Display all the videos whose titles contain the search_term.
-    SEARCH_VIDEOS_WITH_TAG <tag_name> -Display all videos whose tags contains the provided tag.
-    FLAG_VIDEO <video_id> <flag_reason> - Mark a video as flagged.
-    ALLOW_VIDEO <video_id> - Removes a flag from a video.
-    HELP - Displays help.
-    EXIT - Terminates the program execution.
-)";
-  std::cout << helpText << std::endl;
+std::size_t CommandParser::executeBatch(std::istream& input) {
+  // Every line is a command, so a search must not read its answer from the
+  // input.
+  mVideoPlayer.setInteractive(false);
+  std::size_t executed = 0;
+  std::string line;
+  while (std::getline(input, line)) {
+    CommandTokens command(line);
+    if (command.empty()) {
+      continue;
+    }
+    if (!executeCommand(command)) {
+      break;
+    }
+    ++executed;
+  }
+  mVideoPlayer.setInteractive(true);
+  return executed;
 }
@@ -1,8 +1,10 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <istream>
+#include <string_view>
 
+#include "commandtokens.h"
 #include "videoplayer.h"
 
 /**
@@ -12,8 +14,6 @@ class CommandParser {
  private:
   VideoPlayer mVideoPlayer;
 
-  void getHelp() const;
-
  public:
   CommandParser(VideoPlayer&& vp);
 
@@ -25,6 +25,16 @@ class CommandParser {
   CommandParser(CommandParser&&) = default;
   CommandParser& operator=(CommandParser&&) = default;
 
-  // Executes the given user command.
-  void executeCommand(const std::vector<std::string>& command);
+  // Executes the given user command, whose name is matched ignoring case.
+  // Returns false if it was EXIT.
+  bool executeCommand(const CommandTokens& command);
+
+  // Splits a line of user input into a command and its arguments and
+  // executes it. Returns false if the line was EXIT.
+  bool executeLine(std::string_view line);
+
+  // Executes every line of input as a command, without prompts or questions,
+  // until the input ends or a line is EXIT. Blank lines are skipped. Returns
+  // the number of commands executed.
+  std::size_t executeBatch(std::istream& input);
 };
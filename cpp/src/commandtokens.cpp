@@ -0,0 +1,29 @@
+#include "commandtokens.h"
+
+namespace {
+
+bool isSeparator(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+}  // namespace
+
+CommandTokens::CommandTokens(std::string_view line) {
+  const char* cursor = line.data();
+  const char* end = cursor + line.size();
+  for (;;) {
+    while (cursor != end && isSeparator(*cursor)) {
+      ++cursor;
+    }
+    if (cursor == end) {
+      return;
+    }
+    const char* start = cursor;
+    while (cursor != end && !isSeparator(*cursor)) {
+      ++cursor;
+    }
+    if (mSize < kMaxTokens) {
+      mTokens[mSize] =
+          std::string_view(start, static_cast<std::size_t>(cursor - start));
+    }
+    ++mSize;
+  }
+}
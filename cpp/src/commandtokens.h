@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+/**
+ * A class used to split a line of user input into its command and arguments
+ * without copying. Tokens are separated by runs of spaces and tabs, and each
+ * one is a view into the line, which must outlive them.
+ */
+class CommandTokens {
+ public:
+  // No command takes more than two arguments, so only the first few tokens
+  // are kept; size() still counts the rest.
+  static constexpr std::size_t kMaxTokens = 4;
+
+ private:
+  std::array<std::string_view, kMaxTokens> mTokens;
+  std::size_t mSize = 0;
+
+ public:
+  explicit CommandTokens(std::string_view line);
+
+  // Returns the number of tokens in the line.
+  std::size_t size() const { return mSize; }
+  bool empty() const { return mSize == 0; }
+
+  // Returns token i, which must be less than both size() and kMaxTokens.
+  std::string_view operator[](std::size_t i) const { return mTokens[i]; }
+};
@@ -0,0 +1,99 @@
+#include "concurrentflagstore.h"
+
+#include <cstdint>
+
+ConcurrentFlagStore::ConcurrentFlagStore(std::size_t videoCount)
+    : mVideoCount(videoCount),
+      mReasons(new std::atomic<Reason*>[videoCount]) {
+  for (std::size_t video = 0; video < videoCount; ++video) {
+    mReasons[video].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+ConcurrentFlagStore::~ConcurrentFlagStore() {
+  for (std::size_t video = 0; video < mVideoCount; ++video) {
+    delete mReasons[video].load(std::memory_order_relaxed);
+  }
+}
+
+const std::string* ConcurrentFlagStore::reason(VideoHandle video) const {
+  const Reason* reason = load(video);
+  return reason ? &reason->text : nullptr;
+}
+
+bool ConcurrentFlagStore::flag(VideoHandle video, std::string_view reason) {
+  if (video >= mVideoCount || isFlagged(video)) {
+    return false;
+  }
+  auto* created = new Reason(reason);
+  Reason* expected = nullptr;
+  // Release: a reader that sees the pointer sees the whole reason.
+  if (!mReasons[video].compare_exchange_strong(expected, created,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    // Another thread flagged it first.
+    delete created;
+    return false;
+  }
+  mSize.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ConcurrentFlagStore::allow(VideoHandle video) {
+  if (video >= mVideoCount) {
+    return false;
+  }
+  Reason* removed =
+      mReasons[video].exchange(nullptr, std::memory_order_acq_rel);
+  if (!removed) {
+    return false;
+  }
+  mSize.fetch_sub(1, std::memory_order_relaxed);
+  // Readers may still hold it.
+  EpochReclaimer::global().retire(removed);
+  return true;
+}
+
+VideoHandle ConcurrentFlagStore::randomPlayable(
+    std::minstd_rand& random) const {
+  if (mVideoCount == 0) {
+    return kNoVideo;
+  }
+  // Scale a 31-bit draw to the catalog, as VideoLibrary does for FlagStore.
+  auto draw = [&] {
+    std::uint64_t value = random() - std::minstd_rand::min();
+    return static_cast<VideoHandle>((value * mVideoCount) >> 31);
+  };
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    VideoHandle video = draw();
+    if (!isFlagged(video)) {
+      return video;
+    }
+  }
+  // Nearly everything is flagged: scan for the few playable videos, keeping
+  // each with probability 1/(playable seen so far), so every one is equally
+  // likely to be the one left (reservoir sampling).
+  VideoHandle picked = kNoVideo;
+  std::size_t seen = 0;
+  for (std::size_t video = 0; video < mVideoCount; ++video) {
+    if (isFlagged(static_cast<VideoHandle>(video))) {
+      continue;
+    }
+    ++seen;
+    if (std::uniform_int_distribution<std::size_t>(0, seen - 1)(random) ==
+        0) {
+      picked = static_cast<VideoHandle>(video);
+    }
+  }
+  return picked;
+}
+
+std::vector<VideoHandle> ConcurrentFlagStore::flaggedVideos() const {
+  std::vector<VideoHandle> result;
+  for (std::size_t video = 0; video < mVideoCount; ++video) {
+    if (isFlagged(static_cast<VideoHandle>(video))) {
+      result.push_back(static_cast<VideoHandle>(video));
+    }
+  }
+  return result;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "epochreclaimer.h"
+#include "video.h"
+
+/**
+ * A class used to hold the flags of the videos in one catalog when many
+ * threads flag, allow and check videos at once, without locks. Each video
+ * has an atomic pointer to an immutable reason, null when it is not
+ * flagged: flagging installs one with a compare-and-swap and allowing swaps
+ * it out and retires it to the EpochReclaimer. Readers pin the epoch while
+ * they look at a reason, so it is never freed under them, and never wait
+ * for a writer.
+ */
+class ConcurrentFlagStore {
+ private:
+  struct Reason : EpochReclaimer::Retired {
+    explicit Reason(std::string_view reason) : text(reason) {}
+    const std::string text;
+  };
+
+  std::size_t mVideoCount;
+  std::unique_ptr<std::atomic<Reason*>[]> mReasons;
+  std::atomic<std::size_t> mSize{0};
+
+  const Reason* load(VideoHandle video) const {
+    return video < mVideoCount
+               ? mReasons[video].load(std::memory_order_acquire)
+               : nullptr;
+  }
+
+ public:
+  // Creates a store for a catalog of videoCount videos, none flagged.
+  explicit ConcurrentFlagStore(std::size_t videoCount);
+  // Frees the reasons still installed; no reader may be using the store.
+  ~ConcurrentFlagStore();
+
+  // This class is not copyable, it owns the reasons.
+  ConcurrentFlagStore(const ConcurrentFlagStore&) = delete;
+  ConcurrentFlagStore& operator=(const ConcurrentFlagStore&) = delete;
+
+  bool isFlagged(VideoHandle video) const { return load(video) != nullptr; }
+
+  // Calls visit with the reason a video was flagged, pinning the epoch so it
+  // cannot be freed meanwhile. Returns false, without calling it, if the
+  // video is not flagged.
+  template <typename Visitor>
+  bool withReason(VideoHandle video, Visitor&& visit) const {
+    EpochReclaimer::Guard guard;
+    const Reason* reason = load(video);
+    if (!reason) {
+      return false;
+    }
+    visit(reason->text);
+    return true;
+  }
+
+  // Returns the reason a video was flagged, or nullptr if it is not. The
+  // reason is only safe to read while the caller holds an
+  // EpochReclaimer::Guard, or no other thread allows the video.
+  const std::string* reason(VideoHandle video) const;
+
+  // Flags a video. Returns false if it was already flagged, or is not in
+  // the catalog.
+  bool flag(VideoHandle video, std::string_view reason);
+
+  // Removes the flag from a video. Returns false if it was not flagged.
+  bool allow(VideoHandle video);
+
+  // Returns the number of flagged videos.
+  std::size_t size() const { return mSize.load(std::memory_order_relaxed); }
+
+  // Returns a random video that is not flagged, each equally likely, or
+  // kNoVideo if there is none. Draws until it finds one, so it stays fast
+  // while most videos are playable, and scans once they are not.
+  VideoHandle randomPlayable(std::minstd_rand& random) const;
+
+  // Returns the flagged videos, in catalog order.
+  std::vector<VideoHandle> flaggedVideos() const;
+
+  // Calls visit with each flagged video and its reason, in catalog order.
+  template <typename Visitor>
+  void forEachFlag(Visitor&& visit) const {
+    EpochReclaimer::Guard guard;
+    for (std::size_t video = 0; video < mVideoCount; ++video) {
+      if (const Reason* reason = load(static_cast<VideoHandle>(video))) {
+        visit(static_cast<VideoHandle>(video), reason->text);
+      }
+    }
+  }
+};
@@ -0,0 +1,135 @@
+#include "epochreclaimer.h"
+
+class EpochReclaimer::Registration {
+ private:
+  Participant* mParticipant;
+
+ public:
+  explicit Registration(Participant* participant)
+      : mParticipant(participant) {}
+  ~Registration() {
+    mParticipant->epoch.store(kQuiescent);
+    mParticipant->inUse.store(false);
+  }
+  Participant& get() const { return *mParticipant; }
+};
+
+EpochReclaimer::~EpochReclaimer() {
+  // Every thread has exited, so nothing can be pinned.
+  for (Retired* object = mRetired.exchange(nullptr); object;) {
+    Retired* next = object->mNext;
+    delete object;
+    object = next;
+  }
+  for (Participant* record = mParticipants.load(); record;) {
+    Participant* next = record->next;
+    delete record;
+    record = next;
+  }
+}
+
+EpochReclaimer& EpochReclaimer::global() {
+  static EpochReclaimer reclaimer;
+  return reclaimer;
+}
+
+EpochReclaimer::Participant& EpochReclaimer::participant() {
+  thread_local Registration registration(acquireParticipant());
+  return registration.get();
+}
+
+EpochReclaimer::Participant* EpochReclaimer::acquireParticipant() {
+  for (Participant* record = mParticipants.load(); record;
+       record = record->next) {
+    bool expected = false;
+    if (!record->inUse.load() &&
+        record->inUse.compare_exchange_strong(expected, true)) {
+      return record;
+    }
+  }
+  auto* record = new Participant;
+  record->inUse.store(true);
+  record->next = mParticipants.load();
+  while (!mParticipants.compare_exchange_weak(record->next, record)) {
+  }
+  return record;
+}
+
+void EpochReclaimer::pin() {
+  Participant& self = participant();
+  if (self.depth++ == 0) {
+    // Publish the epoch before reading anything it protects; tryAdvance
+    // reads the records after the epoch, so one of them sees the other.
+    self.epoch.store(mEpoch.load());
+  }
+}
+
+void EpochReclaimer::unpin() {
+  Participant& self = participant();
+  if (--self.depth == 0) {
+    self.epoch.store(kQuiescent);
+  }
+}
+
+void EpochReclaimer::pushRetired(Retired* first, Retired* last) {
+  last->mNext = mRetired.load();
+  while (!mRetired.compare_exchange_weak(last->mNext, first)) {
+  }
+}
+
+void EpochReclaimer::retire(Retired* object) {
+  // Read after the object was unlinked: a reader pinned at a later epoch
+  // cannot have found it.
+  object->mEpoch = mEpoch.load();
+  pushRetired(object, object);
+  mRetiredCount.fetch_add(1, std::memory_order_relaxed);
+  if (mSinceReclaim.fetch_add(1, std::memory_order_relaxed) + 1 >=
+      kReclaimBatch) {
+    reclaim();
+  }
+}
+
+void EpochReclaimer::tryAdvance() {
+  std::uint64_t epoch = mEpoch.load();
+  for (Participant* record = mParticipants.load(); record;
+       record = record->next) {
+    std::uint64_t pinned = record->epoch.load();
+    if (pinned != kQuiescent && pinned != epoch) {
+      return;
+    }
+  }
+  mEpoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+std::size_t EpochReclaimer::reclaim() {
+  std::unique_lock<std::mutex> lock(mReclaiming, std::try_to_lock);
+  if (!lock) {
+    return pendingCount();
+  }
+  mSinceReclaim.store(0, std::memory_order_relaxed);
+  tryAdvance();
+  // Two advances past an object's epoch mean every reader pinned when it
+  // was retired has since unpinned.
+  std::uint64_t epoch = mEpoch.load();
+  Retired* keepFirst = nullptr;
+  Retired* keepLast = nullptr;
+  std::size_t freed = 0;
+  for (Retired* object = mRetired.exchange(nullptr); object;) {
+    Retired* next = object->mNext;
+    if (object->mEpoch + 2 <= epoch) {
+      delete object;
+      ++freed;
+    } else {
+      object->mNext = keepFirst;
+      keepFirst = object;
+      if (!keepLast) {
+        keepLast = object;
+      }
+    }
+    object = next;
+  }
+  if (keepFirst) {
+    pushRetired(keepFirst, keepLast);
+  }
+  return mRetiredCount.fetch_sub(freed, std::memory_order_relaxed) - freed;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * A class used to free objects that lock-free readers may still be looking
+ * at. A reader pins the current epoch while it reads; a writer that unlinks
+ * an object retires it instead of deleting it, and the object is only freed
+ * once the epoch has advanced twice, which cannot happen while any reader
+ * that could have seen it is still pinned. Pinning is two stores to the
+ * calling thread's own record, so readers never wait for writers.
+ *
+ * There is one reclaimer per process, shared by every lock-free structure,
+ * so a thread registers once however many structures it reads.
+ */
+class EpochReclaimer {
+ public:
+  /**
+   * A base for objects that can be retired. The reclaimer links them
+   * through it, so retiring allocates nothing.
+   */
+  class Retired {
+   private:
+    friend class EpochReclaimer;
+    Retired* mNext = nullptr;
+    std::uint64_t mEpoch = 0;
+
+   public:
+    virtual ~Retired() = default;
+  };
+
+  /**
+   * A class used to pin the epoch for as long as it is in scope. Guards
+   * nest, so a thread that already holds one pays nothing for another.
+   */
+  class Guard {
+   public:
+    Guard() { global().pin(); }
+    ~Guard() { global().unpin(); }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+  };
+
+ private:
+  static constexpr std::uint64_t kQuiescent = 0;
+  // Try to free retired objects once this many have been retired since the
+  // last attempt.
+  static constexpr std::size_t kReclaimBatch = 64;
+
+  struct alignas(64) Participant {
+    std::atomic<std::uint64_t> epoch{kQuiescent};
+    std::atomic<bool> inUse{false};
+    // Only touched by the owning thread.
+    unsigned depth = 0;
+    Participant* next = nullptr;
+  };
+
+  // A thread's registration, released when the thread exits.
+  class Registration;
+
+  std::atomic<std::uint64_t> mEpoch{1};
+  // Never shrinks; records of exited threads are reused.
+  std::atomic<Participant*> mParticipants{nullptr};
+  std::atomic<Retired*> mRetired{nullptr};
+  std::atomic<std::size_t> mRetiredCount{0};
+  std::atomic<std::size_t> mSinceReclaim{0};
+  // Only one thread frees at a time; the others skip rather than wait.
+  std::mutex mReclaiming;
+
+  EpochReclaimer() = default;
+  ~EpochReclaimer();
+
+  Participant& participant();
+  Participant* acquireParticipant();
+  void pushRetired(Retired* first, Retired* last);
+  // Advances the epoch if every pinned thread has seen the current one.
+  void tryAdvance();
+
+ public:
+  EpochReclaimer(const EpochReclaimer&) = delete;
+  EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+  // Returns the process's reclaimer.
+  static EpochReclaimer& global();
+
+  // Pins the current epoch on the calling thread; prefer Guard.
+  void pin();
+  void unpin();
+
+  // Hands an object that no new reader can reach to the reclaimer, which
+  // deletes it once no pinned reader can still hold it.
+  void retire(Retired* object);
+
+  // Advances the epoch and frees what it can. Returns the number of objects
+  // still waiting. Writers call it every so often; tests call it to drain.
+  std::size_t reclaim();
+
+  // Returns the number of retired objects not yet freed.
+  std::size_t pendingCount() const {
+    return mRetiredCount.load(std::memory_order_relaxed);
+  }
+};
@@ -0,0 +1,67 @@
+#include "flagstore.h"
+
+FlagStore::FlagStore(std::size_t videoCount) : mVideoCount(videoCount) {}
+
+void FlagStore::buildArrays() {
+  mFlagged.assign((mVideoCount + 63) / 64, 0);
+  mPlayable.resize(mVideoCount);
+  mPlayableIndex.resize(mVideoCount);
+  for (std::size_t video = 0; video < mVideoCount; ++video) {
+    mPlayable[video] = static_cast<VideoHandle>(video);
+    mPlayableIndex[video] = static_cast<std::uint32_t>(video);
+  }
+}
+
+const std::string* FlagStore::reason(VideoHandle video) const {
+  if (video >= mVideoCount || !isFlagged(video)) {
+    return nullptr;
+  }
+  return &mReasons.find(video)->second;
+}
+
+bool FlagStore::flag(VideoHandle video, std::string_view reason) {
+  if (video >= mVideoCount || isFlagged(video)) {
+    return false;
+  }
+  if (mFlagged.empty()) {
+    buildArrays();
+  }
+  mFlagged[video / 64] |= std::uint64_t{1} << (video % 64);
+  // Move the last playable video into this one's slot.
+  std::uint32_t index = mPlayableIndex[video];
+  VideoHandle last = mPlayable.back();
+  mPlayable[index] = last;
+  mPlayableIndex[last] = index;
+  mPlayable.pop_back();
+  mReasons.emplace(video, std::string(reason));
+  return true;
+}
+
+bool FlagStore::allow(VideoHandle video) {
+  // isFlagged refuses a video outside the catalog.
+  if (!isFlagged(video)) {
+    return false;
+  }
+  mFlagged[video / 64] &= ~(std::uint64_t{1} << (video % 64));
+  mPlayableIndex[video] = static_cast<std::uint32_t>(mPlayable.size());
+  mPlayable.push_back(video);
+  mReasons.erase(video);
+  return true;
+}
+
+std::vector<VideoHandle> FlagStore::playable() const {
+  std::vector<VideoHandle> result(playableCount());
+  for (std::size_t index = 0; index < result.size(); ++index) {
+    result[index] = playableAt(index);
+  }
+  return result;
+}
+
+std::vector<VideoHandle> FlagStore::flaggedVideos() const {
+  std::vector<VideoHandle> result;
+  result.reserve(mReasons.size());
+  for (const auto& flag : mReasons) {
+    result.push_back(flag.first);
+  }
+  return result;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "video.h"
+
+/**
+ * A class used to hold the flags of the videos in one catalog. A bitmap
+ * answers whether a video is flagged without hashing, and the videos that
+ * are not flagged are kept in an array, with each one's index in it, so a
+ * random playable video is a single draw and flagging or allowing a video
+ * is a swap-remove or an append. Only the reasons live in a hash table.
+ * The arrays are only built when the first video is flagged, so a store
+ * nobody flags in, like most sessions' own, costs nothing per video.
+ */
+class FlagStore {
+ private:
+  std::size_t mVideoCount = 0;
+  // Empty, like mPlayable and mPlayableIndex, until a video is flagged.
+  std::vector<std::uint64_t> mFlagged;
+  std::vector<VideoHandle> mPlayable;
+  // The index of each playable video in mPlayable; stale for flagged ones.
+  std::vector<std::uint32_t> mPlayableIndex;
+  std::unordered_map<VideoHandle, std::string> mReasons;
+
+  void buildArrays();
+
+ public:
+  FlagStore() = default;
+  // Creates a store for a catalog of videoCount videos, none flagged.
+  explicit FlagStore(std::size_t videoCount);
+
+  // Returns whether a video is flagged; one not in the catalog is not.
+  bool isFlagged(VideoHandle video) const {
+    return video < mVideoCount && !mFlagged.empty() &&
+           (mFlagged[video / 64] >> (video % 64)) & 1;
+  }
+
+  // Returns the reason a video was flagged, or nullptr if it is not.
+  const std::string* reason(VideoHandle video) const;
+
+  // Flags a video. Returns false if it was already flagged, or is not in
+  // the catalog.
+  bool flag(VideoHandle video, std::string_view reason);
+
+  // Removes the flag from a video. Returns false if it was not flagged, or
+  // is not in the catalog.
+  bool allow(VideoHandle video);
+
+  // Returns the number of flagged videos.
+  std::size_t size() const { return mReasons.size(); }
+
+  // Returns the number of videos that are not flagged.
+  std::size_t playableCount() const {
+    return mFlagged.empty() ? mVideoCount : mPlayable.size();
+  }
+
+  // Returns one of the videos that are not flagged; each index below
+  // playableCount() gives a different one.
+  VideoHandle playableAt(std::size_t index) const {
+    return mFlagged.empty() ? static_cast<VideoHandle>(index)
+                            : mPlayable[index];
+  }
+
+  // Returns a copy of the videos that are not flagged, in no particular
+  // order.
+  std::vector<VideoHandle> playable() const;
+
+  // Returns the flagged videos, in no particular order.
+  std::vector<VideoHandle> flaggedVideos() const;
+
+  // Returns a store for a catalog of videoCount videos with the flags moved
+  // onto it: each flagged video becomes remap(video), and those it maps to
+  // kNoVideo are dropped and counted in *dropped.
+  template <typename Remap>
+  FlagStore remapped(std::size_t videoCount, Remap remap,
+                     std::size_t* dropped) const {
+    FlagStore result(videoCount);
+    for (const auto& flag : mReasons) {
+      VideoHandle video = remap(flag.first);
+      if (video == kNoVideo) {
+        ++*dropped;
+      } else {
+        result.flag(video, flag.second);
+      }
+    }
+    return result;
+  }
+};
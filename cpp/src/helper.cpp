@@ -1,5 +1,5 @@
 #include "helper.h"
-#include "Video.h"
+#include "casefold.h"
 
 #include <iostream>
 #include <sstream>
@@ -16,6 +16,16 @@ std::string trim(std::string toTrim) {
   return toTrim;
 }
 
+std::string_view trimView(std::string_view toTrim) {
+  size_t trimPos = toTrim.find_first_not_of(" \t");
+  if (std::string_view::npos == trimPos) {
+    return toTrim.substr(toTrim.size());
+  }
+  toTrim.remove_prefix(trimPos);
+  toTrim.remove_suffix(toTrim.size() - toTrim.find_last_not_of(" \t") - 1);
+  return toTrim;
+}
+
 std::vector<std::string> splitlines(std::string output) {
   std::vector<std::string> commandOutput;
   std::stringstream ss(output);
@@ -30,7 +40,6 @@ std::vector<std::string> splitlines(std::string output) {
 std::string stringToUpper(const std::string input)
 {
   std::string output(input);
-  std::transform(output.begin(), output.end(), output.begin(), [](char c)
-                 { return static_cast<char>(std::toupper(c)); });
+  foldAscii(output.data(), output.size());
   return output;
 }
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 std::string trim(std::string s);
 
+// Same as trim, but returns a view into the input instead of a copy.
+std::string_view trimView(std::string_view s);
+
 std::vector<std::string> splitlines(std::string output);
 
+// Upper-cases the ASCII letters of input (see foldAscii).
 std::string stringToUpper(const std::string input);
+
@@ -0,0 +1,77 @@
+#include "latencyhistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Values below 2^kExactBits each have a bucket of their own.
+constexpr unsigned kExactBits = 6;
+constexpr std::uint64_t kExact = std::uint64_t{1} << kExactBits;
+constexpr std::uint64_t kSubBuckets = kExact / 2;
+
+unsigned highestBit(std::uint64_t value) {
+  unsigned bit = 0;
+  while (value >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+
+}  // namespace
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t value) {
+  if (value < kExact) {
+    return static_cast<std::size_t>(value);
+  }
+  // Keep the top kExactBits bits: value >> shift is in [32, 64).
+  unsigned shift = highestBit(value) - (kExactBits - 1);
+  return static_cast<std::size_t>(kExact + (shift - 1) * kSubBuckets +
+                                  ((value >> shift) - kSubBuckets));
+}
+
+std::uint64_t LatencyHistogram::bucketTop(std::size_t bucket) {
+  if (bucket < kExact) {
+    return bucket;
+  }
+  std::uint64_t shift = (bucket - kExact) / kSubBuckets + 1;
+  std::uint64_t sub = (bucket - kExact) % kSubBuckets + kSubBuckets;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t value) {
+  ++mCounts[bucketOf(value)];
+  ++mCount;
+  mMax = std::max(mMax, value);
+  mTotal += value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+  for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+    mCounts[bucket] += other.mCounts[bucket];
+  }
+  mCount += other.mCount;
+  mMax = std::max(mMax, other.mMax);
+  mTotal += other.mTotal;
+}
+
+double LatencyHistogram::mean() const {
+  return mCount ? static_cast<double>(mTotal / mCount) : 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double quantile) const {
+  if (mCount == 0) {
+    return 0;
+  }
+  auto rank = static_cast<std::uint64_t>(
+      std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(mCount)));
+  rank = std::max<std::uint64_t>(rank, 1);
+  std::uint64_t seen = 0;
+  for (std::size_t bucket = 0; bucket < kBucketCount; ++bucket) {
+    seen += mCounts[bucket];
+    if (seen >= rank) {
+      return std::min(bucketTop(bucket), mMax);
+    }
+  }
+  return mMax;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A class used to collect latencies and read percentiles off them without
+ * keeping every sample. Values below 64 are counted exactly; above that,
+ * each power of two is split into 32 buckets, so a percentile is never more
+ * than 1/32 above the true value. Recording is a few instructions and
+ * never allocates, and histograms from different threads can be merged.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr std::size_t kBucketCount = 64 + 58 * 32;
+
+ private:
+  std::array<std::uint64_t, kBucketCount> mCounts{};
+  std::uint64_t mCount = 0;
+  std::uint64_t mMax = 0;
+  // The sum of every value, for the mean.
+  long double mTotal = 0;
+
+  static std::size_t bucketOf(std::uint64_t value);
+  // Returns the largest value that falls in a bucket.
+  static std::uint64_t bucketTop(std::size_t bucket);
+
+ public:
+  void record(std::uint64_t value);
+
+  // Adds every value recorded in other to this histogram.
+  void merge(const LatencyHistogram& other);
+
+  std::uint64_t count() const { return mCount; }
+  std::uint64_t max() const { return mMax; }
+  double mean() const;
+
+  // Returns the value that a quantile, from 0 to 1, of the recorded values
+  // are at or below, rounded up to the top of its bucket; 0 if nothing was
+  // recorded.
+  std::uint64_t percentile(double quantile) const;
+};
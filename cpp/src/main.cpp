@@ -1,53 +1,126 @@
-#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <sstream>
-#include <unordered_map>
+#include <memory>
+#include <string>
 #include <utility>
-#include <vector>
 
 #include "commandparser.h"
-#include "helper.h"
+#include "outputsink.h"
 #include "videolibrary.h"
 #include "videoplayer.h"
 
-int main() {
-  std::cout << "Hello and welcome to YouTube, what would you like to do? "
-               "Enter HELP for list of available commands or EXIT to terminate."
+namespace {
+
+// Runs the commands in input without prompts and reports how fast they ran
+// on std::cerr, keeping std::cout to the commands' own output.
+void runBatch(CommandParser& cp, std::istream& input, OutputSink& output) {
+  auto start = std::chrono::steady_clock::now();
+  std::size_t executed = cp.executeBatch(input);
+  output.flush();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  double perSecond =
+      elapsed.count() > 0 ? static_cast<double>(executed) / elapsed.count() : 0;
+  std::cerr << "Ran " << executed << " commands in " << std::fixed
+            << std::setprecision(3) << elapsed.count() * 1000 << " ms ("
+            << std::setprecision(0) << perSecond << " commands/sec)"
             << std::endl;
+}
 
-  std::string userInput;
-  std::string command;
-  std::vector<std::string> commandList;
-  VideoPlayer vp;
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  bool watch = false;
+  bool batch = false;
+  std::string batchPath = "-";
+  std::string logPath;
+  std::string catalogPath = VideoLibrary::defaultCatalogPath();
+  for (int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    if (option == "--watch") {
+      watch = true;
+    } else if (option == "--batch") {
+      batch = true;
+      // The file is optional; without one, or with -, commands come from
+      // std::cin.
+      if (arg + 1 < argc && (argv[arg + 1][0] != '-' ||
+                             std::string(argv[arg + 1]) == "-")) {
+        batchPath = argv[++arg];
+      }
+    } else if (option == "--log" && arg + 1 < argc) {
+      logPath = argv[++arg];
+    } else if (option == "--catalog" && arg + 1 < argc) {
+      catalogPath = argv[++arg];
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--catalog <file>] [--watch] [--batch [<file>|-]]"
+                << " [--log <file>]" << std::endl;
+      return 2;
+    }
+  }
+
+  std::ifstream batchFile;
+  if (batch && batchPath != "-") {
+    batchFile.open(batchPath);
+    if (!batchFile) {
+      std::cerr << "Cannot open " << batchPath << std::endl;
+      return 1;
+    }
+  }
+
+  // Output is buffered and only flushed when the next command is read, so a
+  // piped script costs a write per prompt rather than per line. A batch run
+  // has no prompts and only writes when the buffer fills.
+  auto output = std::make_shared<StdoutSink>();
+  if (!batch) {
+    *output << "Hello and welcome to YouTube, what would you like to do? "
+               "Enter HELP for list of available commands or EXIT to "
+               "terminate."
+            << '\n';
+  }
+
+  // Prefer a snapshot built by youtube_snapshot when it is up to date.
+  VideoLibrary library = VideoLibrary::open(
+      catalogPath, VideoLibrary::snapshotPathFor(catalogPath));
+  if (!library.catalog()->isOpen()) {
+    // A batch run keeps std::cout to the commands' own output.
+    if (batch) {
+      std::cerr << "Couldn't find " << catalogPath << std::endl;
+    } else {
+      *output << "Couldn't find " << catalogPath << '\n';
+    }
+  }
+  if (!logPath.empty() && !library.openLog(logPath)) {
+    std::cerr << "Cannot open " << logPath << std::endl;
+    return 1;
+  }
+  VideoPlayer vp(std::move(library), output);
+  if (watch && !vp.watchLibrary()) {
+    *output << "Cannot watch " << catalogPath
+            << " for changes on this platform" << '\n';
+  }
   CommandParser cp = CommandParser(std::move(vp));
 
+  if (batch) {
+    runBatch(cp, batchFile.is_open() ? batchFile : std::cin, *output);
+    return 0;
+  }
+
+  std::string userInput;
   for (;;) {
-    std::cout << "YT> ";
+    *output << "YT> ";
+    output->flush();
     if (!std::getline(std::cin, userInput)) {
       break;
     }
-    if (userInput.empty()) {
-      std::cout << "Please enter a valid command, type HELP for a list of "
-                   "available commands."
-                << std::endl;
-    } else {
-      std::stringstream test(userInput);
-      while (std::getline(test, command, ' ')) {
-        command = trim(command);
-        commandList.push_back(command);
-      }
-      std::transform(commandList[0].begin(), commandList[0].end(),
-                     commandList[0].begin(),
-                     [](char c) { return static_cast<char>(std::toupper(c)); });
-      if (commandList[0] == "EXIT") {
-        break;
-      }
-      cp.executeCommand(commandList);
-      commandList.clear();
+    if (!cp.executeLine(userInput)) {
+      break;
     }
   }
-  std::cout
+  *output
       << "YouTube has now terminated it's execution. Thank you and goodbye!"
-      << std::endl;
+      << '\n';
+  output->flush();
 }
@@ -0,0 +1,144 @@
+#include "mappedfile.h"
+
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32)
+namespace {
+
+std::int64_t modifiedNanos(const struct stat& info) {
+#if defined(__APPLE__)
+  const timespec& modified = info.st_mtimespec;
+#else
+  const timespec& modified = info.st_mtim;
+#endif
+  return static_cast<std::int64_t>(modified.tv_sec) * 1000000000 +
+         modified.tv_nsec;
+}
+
+}  // namespace
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#if !defined(_WIN32)
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat info;
+  if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+    mOpen = true;
+    mSize = static_cast<std::size_t>(info.st_size);
+    if (mSize == 0) {
+      ::close(fd);
+      return;
+    }
+    void* addr = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      ::madvise(addr, mSize, MADV_WILLNEED);
+      mData = static_cast<const char*>(addr);
+      mMapped = true;
+      mFd = fd;
+      mModified = modifiedNanos(info);
+      return;
+    }
+    mOpen = false;
+    mSize = 0;
+  }
+  ::close(fd);
+#endif
+  // mmap is unavailable (or the file is not a regular file), so fall back to
+  // reading the whole file in one go.
+  mOpen = readIntoBuffer(path);
+}
+
+MappedFile::~MappedFile() { release(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mData(other.mData),
+      mSize(other.mSize),
+      mOpen(other.mOpen),
+      mMapped(other.mMapped),
+      mBuffer(std::move(other.mBuffer)),
+      mFd(other.mFd),
+      mModified(other.mModified) {
+  other.mData = nullptr;
+  other.mSize = 0;
+  other.mOpen = false;
+  other.mMapped = false;
+  other.mFd = -1;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    release();
+    mData = other.mData;
+    mSize = other.mSize;
+    mOpen = other.mOpen;
+    mMapped = other.mMapped;
+    mBuffer = std::move(other.mBuffer);
+    mFd = other.mFd;
+    mModified = other.mModified;
+    other.mData = nullptr;
+    other.mSize = 0;
+    other.mOpen = false;
+    other.mMapped = false;
+    other.mFd = -1;
+  }
+  return *this;
+}
+
+void MappedFile::release() {
+#if !defined(_WIN32)
+  if (mMapped) {
+    ::munmap(const_cast<char*>(mData), mSize);
+  }
+  if (mFd >= 0) {
+    ::close(mFd);
+  }
+#endif
+  mFd = -1;
+  mBuffer.reset();
+  mData = nullptr;
+  mSize = 0;
+  mOpen = false;
+  mMapped = false;
+}
+
+bool MappedFile::changedOnDisk() const {
+#if !defined(_WIN32)
+  struct stat info;
+  if (mMapped && ::fstat(mFd, &info) == 0) {
+    return static_cast<std::size_t>(info.st_size) != mSize ||
+           modifiedNanos(info) != mModified;
+  }
+#endif
+  return false;
+}
+
+bool MappedFile::readIntoBuffer(const std::string& path) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::streamsize size = file.tellg();
+  if (size < 0) {
+    return false;
+  }
+  file.seekg(0);
+  mBuffer.reset(new char[static_cast<std::size_t>(size)]);
+  if (size > 0 && !file.read(mBuffer.get(), size)) {
+    mBuffer.reset();
+    return false;
+  }
+  mData = mBuffer.get();
+  mSize = static_cast<std::size_t>(size);
+  return true;
+}
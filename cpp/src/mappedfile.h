@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * A class used to represent the read-only contents of a file. Where the
+ * platform supports it the file is memory mapped, so no copy of the contents
+ * is made; otherwise the file is read into a single heap buffer. A mapped
+ * file must not be written in place while it is open: the contents would
+ * change underneath their readers, and reading past a truncated end raises
+ * SIGBUS. changedOnDisk() detects such a write after the fact.
+ */
+class MappedFile {
+ private:
+  const char* mData = nullptr;
+  std::size_t mSize = 0;
+  bool mOpen = false;
+  bool mMapped = false;
+  std::unique_ptr<char[]> mBuffer;
+  // Kept open while mapped, to check the file for writes in place.
+  int mFd = -1;
+  // The file's modification time, in nanoseconds, when it was mapped.
+  std::int64_t mModified = 0;
+
+  void release();
+  bool readIntoBuffer(const std::string& path);
+
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  // This class is not copyable, it uniquely owns the mapping.
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // This class is movable. Views into the contents stay valid across moves.
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  // Returns whether the file could be opened.
+  bool isOpen() const { return mOpen; }
+
+  // Returns a view of the whole file.
+  std::string_view contents() const { return std::string_view(mData, mSize); }
+
+  // Returns whether a mapped file has been written or truncated in place
+  // since it was mapped, leaving the contents unreliable. A file replaced
+  // by renaming another over it is not changed: the mapping keeps the old
+  // one.
+  bool changedOnDisk() const;
+};
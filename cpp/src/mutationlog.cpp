@@ -0,0 +1,337 @@
+#include "mutationlog.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "mappedfile.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kLogMagic[8] = {'Y', 'T', 'W', 'A', 'L', '\0', '\0', '\0'};
+constexpr std::uint32_t kLogVersion = 1;
+constexpr std::uint32_t kLogByteOrderMark = 0x01020304;
+constexpr std::size_t kHeaderSize = sizeof(kLogMagic) + 8;
+// Payload size and checksum.
+constexpr std::size_t kFrameSize = 8;
+
+constexpr std::array<std::uint32_t, 256> makeCrcTable() {
+  std::array<std::uint32_t, 256> table{};
+  for (std::uint32_t byte = 0; byte < 256; ++byte) {
+    std::uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+    }
+    table[byte] = crc;
+  }
+  return table;
+}
+
+constexpr std::array<std::uint32_t, 256> kCrcTable = makeCrcTable();
+
+// The CRC-32 used by zlib and PNG.
+std::uint32_t crc32(std::string_view data) {
+  std::uint32_t crc = 0xFFFFFFFFu;
+  for (char c : data) {
+    crc = kCrcTable[(crc ^ static_cast<unsigned char>(c)) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+void appendWord(std::string& out, std::uint32_t word) {
+  out.append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+std::uint32_t readWord(const char* data) {
+  std::uint32_t word;
+  std::memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+std::string header() {
+  std::string out(kLogMagic, sizeof(kLogMagic));
+  appendWord(out, kLogVersion);
+  appendWord(out, kLogByteOrderMark);
+  return out;
+}
+
+// Reads the string at payload[*offset], a u32 size and that many bytes, and
+// moves *offset past it. Returns false if it overruns the payload.
+bool readString(std::string_view payload, std::size_t* offset,
+                std::string_view* out) {
+  if (payload.size() - *offset < 4) {
+    return false;
+  }
+  std::uint32_t size = readWord(payload.data() + *offset);
+  *offset += 4;
+  if (payload.size() - *offset < size) {
+    return false;
+  }
+  *out = payload.substr(*offset, size);
+  *offset += size;
+  return true;
+}
+
+// Decodes a payload checked by its CRC. Returns false if it does not hold
+// exactly one mutation of a known type.
+bool decode(std::string_view payload, Mutation* mutation) {
+  if (payload.empty()) {
+    return false;
+  }
+  auto type = static_cast<std::uint8_t>(payload[0]);
+  if (type < static_cast<std::uint8_t>(MutationType::CreatePlaylist) ||
+      type > static_cast<std::uint8_t>(MutationType::Allow)) {
+    return false;
+  }
+  mutation->type = static_cast<MutationType>(type);
+  std::size_t offset = 1;
+  return readString(payload, &offset, &mutation->first) &&
+         readString(payload, &offset, &mutation->second) &&
+         offset == payload.size();
+}
+
+bool syncFile(std::FILE* file) {
+  if (std::fflush(file) != 0) {
+    return false;
+  }
+#if defined(_WIN32)
+  return _commit(_fileno(file)) == 0;
+#else
+  return ::fdatasync(::fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename in the directory holding path durable.
+void syncDirectory(const std::string& path) {
+#if !defined(_WIN32)
+  std::filesystem::path directory =
+      std::filesystem::path(path).parent_path();
+  int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+#endif
+}
+
+// Calls replay with each intact record in data, counting them in *count,
+// and sets *validBytes to the length of the intact prefix, or 0 if it does
+// not even hold a header. Returns false if data is not a mutation log.
+bool replayRecords(std::string_view data,
+                   const std::function<void(const Mutation&)>& replay,
+                   std::uint64_t* count, std::uint64_t* validBytes) {
+  // A crash while creating the log can leave less than a header.
+  if (data.size() < kHeaderSize) {
+    *validBytes = 0;
+    return true;
+  }
+  if (data.substr(0, kHeaderSize) != header()) {
+    return false;
+  }
+  std::size_t offset = kHeaderSize;
+  Mutation mutation{};
+  while (data.size() - offset >= kFrameSize) {
+    std::uint32_t size = readWord(data.data() + offset);
+    std::uint32_t checksum = readWord(data.data() + offset + 4);
+    if (data.size() - offset - kFrameSize < size) {
+      break;
+    }
+    std::string_view payload = data.substr(offset + kFrameSize, size);
+    if (crc32(payload) != checksum || !decode(payload, &mutation)) {
+      break;
+    }
+    replay(mutation);
+    ++*count;
+    offset += kFrameSize + size;
+  }
+  *validBytes = offset;
+  return true;
+}
+
+}  // namespace
+
+MutationLog::MutationLog(std::string path, std::FILE* file,
+                         std::uint64_t fileBytes)
+    : mPath(std::move(path)),
+      mFile(file),
+      mFileBytes(fileBytes),
+      mCompactedBytes(fileBytes) {}
+
+std::unique_ptr<MutationLog> MutationLog::open(
+    const std::string& path,
+    const std::function<void(const Mutation&)>& replay,
+    std::uint64_t* replayed) {
+  std::uint64_t count = 0;
+  std::uint64_t validBytes = 0;
+  std::error_code error;
+  bool exists = std::filesystem::exists(path, error);
+  if (exists) {
+    std::uint64_t fileBytes = 0;
+    {
+      MappedFile file(path);
+      if (!file.isOpen() || !replayRecords(file.contents(), replay, &count,
+                                           &validBytes)) {
+        return nullptr;
+      }
+      fileBytes = file.contents().size();
+    }
+    if (validBytes != fileBytes) {
+      // Cut off the torn record so new ones follow the last good one.
+      std::filesystem::resize_file(path, validBytes, error);
+      if (error) {
+        return nullptr;
+      }
+    }
+  }
+  std::FILE* file = std::fopen(path.c_str(), "ab");
+  if (!file) {
+    return nullptr;
+  }
+  if (validBytes == 0) {
+    std::string start = header();
+    if (std::fwrite(start.data(), 1, start.size(), file) != start.size() ||
+        !syncFile(file)) {
+      std::fclose(file);
+      return nullptr;
+    }
+    validBytes = start.size();
+    if (!exists) {
+      syncDirectory(path);
+    }
+  }
+  if (replayed) {
+    *replayed = count;
+  }
+  return std::unique_ptr<MutationLog>(
+      new MutationLog(path, file, validBytes));
+}
+
+MutationLog::~MutationLog() {
+  sync();
+  if (mFile) {
+    std::fclose(mFile);
+  }
+}
+
+void MutationLog::encode(std::string& out, const Mutation& mutation) {
+  std::size_t frame = out.size();
+  out.append(kFrameSize, '\0');
+  out += static_cast<char>(mutation.type);
+  for (std::string_view field : {mutation.first, mutation.second}) {
+    appendWord(out, static_cast<std::uint32_t>(field.size()));
+    out.append(field);
+  }
+  std::string_view payload(out.data() + frame + kFrameSize,
+                           out.size() - frame - kFrameSize);
+  std::uint32_t words[2] = {static_cast<std::uint32_t>(payload.size()),
+                            crc32(payload)};
+  std::memcpy(&out[frame], words, sizeof(words));
+}
+
+void MutationLog::append(const Mutation& mutation) {
+  std::size_t before = mPending.size();
+  encode(mPending, mutation);
+  mFileBytes += mPending.size() - before;
+  ++mAppended;
+}
+
+bool MutationLog::sync() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  std::uint64_t target = mAppended;
+  while (mDurable < target && !mFailed) {
+    if (mSyncing) {
+      // Someone else is writing; what is appended meanwhile goes out with
+      // the next write, made by whichever waiter wakes first.
+      mSynced.wait(lock);
+      continue;
+    }
+    mSyncing = true;
+    std::string batch;
+    batch.swap(mPending);
+    std::uint64_t upTo = mAppended;
+    lock.unlock();
+    bool written =
+        std::fwrite(batch.data(), 1, batch.size(), mFile) == batch.size() &&
+        syncFile(mFile);
+    lock.lock();
+    mSyncing = false;
+    ++mSyncCount;
+    if (written) {
+      mDurable = upTo;
+    } else {
+      mFailed = true;
+    }
+    mSynced.notify_all();
+  }
+  return !mFailed;
+}
+
+bool MutationLog::failed() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFailed;
+}
+
+bool MutationLog::shouldCompact() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFileBytes >= kMinCompactBytes && mFileBytes > 4 * mCompactedBytes;
+}
+
+bool MutationLog::compact(const std::string& state) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  mSynced.wait(lock, [this] { return !mSyncing; });
+  if (mFailed) {
+    return false;
+  }
+  std::string tempPath = mPath + ".compact";
+  std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  std::string start = header();
+  bool written =
+      std::fwrite(start.data(), 1, start.size(), file) == start.size() &&
+      std::fwrite(state.data(), 1, state.size(), file) == state.size() &&
+      syncFile(file);
+  std::fclose(file);
+  std::error_code error;
+  if (written) {
+    std::filesystem::rename(tempPath, mPath, error);
+  }
+  if (!written || error) {
+    std::filesystem::remove(tempPath, error);
+    return false;
+  }
+  syncDirectory(mPath);
+  // The old file is gone; carry on appending to the new one. The state
+  // covers every record appended so far, so none are still pending.
+  std::fclose(mFile);
+  mFile = std::fopen(mPath.c_str(), "ab");
+  if (!mFile) {
+    mFailed = true;
+    return false;
+  }
+  mPending.clear();
+  mDurable = mAppended;
+  mFileBytes = start.size() + state.size();
+  mCompactedBytes = mFileBytes;
+  return true;
+}
+
+std::uint64_t MutationLog::size() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mFileBytes;
+}
+
+std::uint64_t MutationLog::syncCount() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mSyncCount;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+/**
+ * The changes to a library's playlists and flags that a MutationLog
+ * records. Videos are named by id, so a log outlives catalog reloads.
+ */
+enum class MutationType : std::uint8_t {
+  CreatePlaylist = 1,
+  DeletePlaylist,
+  AddToPlaylist,
+  RemoveFromPlaylist,
+  ClearPlaylist,
+  Flag,
+  Allow,
+};
+
+/**
+ * One change: first is the playlist name, or the video id for Flag and
+ * Allow; second is the video id for playlist entries, or the flag reason.
+ */
+struct Mutation {
+  MutationType type;
+  std::string_view first;
+  std::string_view second;
+};
+
+/**
+ * A class used to make a library's playlists and flags durable. Every
+ * change is appended to a log file as a checksummed record:
+ *
+ *   header (8-byte magic, version, byte order mark) |
+ *   { u32 payload size | u32 CRC-32 of payload |
+ *     u8 type | u32 size | first | u32 size | second }...
+ *
+ * Records are buffered in memory and written by sync(). Threads that sync
+ * while another thread is already writing wait for it and then share one
+ * write and fsync for everything buffered meanwhile, so many changes cost
+ * one fsync (group commit). When the log has grown well past the state it
+ * describes, compact() replaces it with just that state.
+ *
+ * On open, the log is replayed up to the first record that is incomplete or
+ * fails its checksum, which is where a crash interrupted a write, and the
+ * file is cut back to that point before anything is appended.
+ */
+class MutationLog {
+ public:
+  // The log is only compacted once it is at least this large.
+  static constexpr std::uint64_t kMinCompactBytes = 1 << 20;
+
+ private:
+  std::string mPath;
+  std::FILE* mFile;
+  std::mutex mMutex;
+  std::condition_variable mSynced;
+  // Records appended but not yet handed to a sync.
+  std::string mPending;
+  std::uint64_t mAppended = 0;
+  std::uint64_t mDurable = 0;
+  bool mSyncing = false;
+  bool mFailed = false;
+  std::uint64_t mFileBytes = 0;
+  std::uint64_t mCompactedBytes = 0;
+  std::uint64_t mSyncCount = 0;
+
+  MutationLog(std::string path, std::FILE* file, std::uint64_t fileBytes);
+
+  void append(const Mutation& mutation);
+
+ public:
+  // Opens the log at path, creating it if it does not exist, and calls
+  // replay with every intact record in order. Returns nullptr if the file
+  // cannot be opened or is not a mutation log. *replayed, if given, is set
+  // to the number of records replayed.
+  static std::unique_ptr<MutationLog> open(
+      const std::string& path,
+      const std::function<void(const Mutation&)>& replay,
+      std::uint64_t* replayed = nullptr);
+
+  // Writes whatever is still buffered.
+  ~MutationLog();
+
+  // This class is not copyable, it owns the file.
+  MutationLog(const MutationLog&) = delete;
+  MutationLog& operator=(const MutationLog&) = delete;
+
+  // Appends the record for mutation encoded to out, for building the state
+  // passed to compact().
+  static void encode(std::string& out, const Mutation& mutation);
+
+  // Makes a change and records it, if it changed anything, with no other
+  // change recorded in between, so the log holds changes in the order they
+  // were made. Returns what change returns. Once the log has failed, the
+  // change is refused: it is not made and false is returned.
+  template <typename Change>
+  bool record(const Mutation& mutation, Change&& change) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFailed || !change()) {
+      return false;
+    }
+    append(mutation);
+    return true;
+  }
+
+  // Blocks until every record appended so far is on disk. Returns false if
+  // a write or fsync failed; the log stops syncing after a failure.
+  bool sync();
+  // Returns whether a write or fsync has failed, after which nothing more is
+  // recorded.
+  bool failed();
+
+  // Returns whether the log has grown past four times its size when last
+  // compacted, and past kMinCompactBytes.
+  bool shouldCompact();
+
+  // Replaces the log with state, records encoded with encode() that
+  // rebuild everything recorded so far. The new log is written beside the
+  // old one and renamed over it, so a crash leaves one or the other. No
+  // change may be recorded while state is built and compacted.
+  bool compact(const std::string& state);
+
+  const std::string& getPath() const { return mPath; }
+  // Returns the size of the log file, including records not yet synced.
+  std::uint64_t size();
+  // Returns the number of writes sync() has made, each with one fsync.
+  std::uint64_t syncCount();
+};
@@ -0,0 +1,36 @@
+#include "outputsink.h"
+
+#include <utility>
+
+StdoutSink::StdoutSink(std::ostream& stream, std::size_t capacity)
+    : mStream(stream), mCapacity(capacity) {
+  mBuffer.reserve(capacity);
+}
+
+StdoutSink::~StdoutSink() { flush(); }
+
+void StdoutSink::write(std::string_view text) {
+  if (mBuffer.size() + text.size() > mCapacity) {
+    flush();
+    // Text larger than the whole buffer goes straight through.
+    if (text.size() > mCapacity) {
+      mStream.write(text.data(), static_cast<std::streamsize>(text.size()));
+      return;
+    }
+  }
+  mBuffer.append(text);
+}
+
+void StdoutSink::flush() {
+  if (!mBuffer.empty()) {
+    mStream.write(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+    mBuffer.clear();
+  }
+  mStream.flush();
+}
+
+std::string MemorySink::take() {
+  std::string text = std::move(mText);
+  mText.clear();
+  return text;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * A class used to represent where a VideoPlayer writes its output. Text is
+ * written with operator<< like a std::ostream, but nothing is flushed until
+ * flush() is called, which the player and the command loop do before
+ * waiting for input.
+ */
+class OutputSink {
+ public:
+  virtual ~OutputSink() = default;
+
+  // Appends text to the output.
+  virtual void write(std::string_view text) = 0;
+
+  // Makes everything written so far visible.
+  virtual void flush() {}
+
+  OutputSink& operator<<(std::string_view text) {
+    write(text);
+    return *this;
+  }
+  OutputSink& operator<<(char c) {
+    write(std::string_view(&c, 1));
+    return *this;
+  }
+  template <typename Integer,
+            typename = std::enable_if_t<std::is_integral_v<Integer> &&
+                                        !std::is_same_v<Integer, char> &&
+                                        !std::is_same_v<Integer, bool>>>
+  OutputSink& operator<<(Integer value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    write(std::string_view(digits, static_cast<std::size_t>(end - digits)));
+    return *this;
+  }
+};
+
+/**
+ * A class used to write output to a stream, std::cout by default, through a
+ * buffer. The stream is only written and flushed when the buffer fills or
+ * flush() is called, so a long run of commands costs a write per prompt
+ * rather than one per line.
+ */
+class StdoutSink : public OutputSink {
+ private:
+  std::ostream& mStream;
+  std::string mBuffer;
+  std::size_t mCapacity;
+
+ public:
+  static constexpr std::size_t kDefaultCapacity = 64 * 1024;
+
+  explicit StdoutSink(std::ostream& stream = std::cout,
+                      std::size_t capacity = kDefaultCapacity);
+  ~StdoutSink() override;
+
+  // This class is not copyable, it owns unwritten output.
+  StdoutSink(const StdoutSink&) = delete;
+  StdoutSink& operator=(const StdoutSink&) = delete;
+
+  void write(std::string_view text) override;
+  void flush() override;
+};
+
+/**
+ * A class used to collect output in memory, for tests and benchmarks.
+ */
+class MemorySink : public OutputSink {
+ private:
+  std::string mText;
+
+ public:
+  void write(std::string_view text) override { mText.append(text); }
+
+  // Returns everything written so far.
+  const std::string& str() const { return mText; }
+
+  // Returns everything written since the last call and clears it.
+  std::string take();
+};
+
+/**
+ * A class used to discard output, for benchmarks.
+ */
+class NullSink : public OutputSink {
+ public:
+  void write(std::string_view) override {}
+};
@@ -0,0 +1,746 @@
+#include "searchpattern.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "casefold.h"
+
+namespace {
+
+bool isWordByte(unsigned char c) {
+  return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') ||
+         (c >= 'a' && c <= 'z') || c == '_';
+}
+
+using ByteSet = std::bitset<256>;
+
+ByteSet digitSet() {
+  ByteSet set;
+  for (int c = '0'; c <= '9'; ++c) {
+    set.set(c);
+  }
+  return set;
+}
+
+ByteSet wordSet() {
+  ByteSet set;
+  for (int c = 0; c < 256; ++c) {
+    set[c] = isWordByte(static_cast<unsigned char>(c));
+  }
+  return set;
+}
+
+ByteSet spaceSet() {
+  ByteSet set;
+  for (char c : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+    set.set(static_cast<unsigned char>(c));
+  }
+  return set;
+}
+
+// Adds the other case of every ASCII letter in set, so that it matches
+// regardless of case, and in particular matches folded input.
+ByteSet caseClosed(ByteSet set) {
+  for (int c = 'a'; c <= 'z'; ++c) {
+    if (set[c] || set[c - 'a' + 'A']) {
+      set.set(c);
+      set.set(c - 'a' + 'A');
+    }
+  }
+  return set;
+}
+
+// A parsed pattern. Repeats keep their operand so that it can be copied as
+// many times as the bounds require.
+struct Node {
+  enum class Kind {
+    kEmpty,
+    kSet,
+    kConcat,
+    kAlternate,
+    kRepeat,
+    kAssertBegin,
+    kAssertEnd,
+    kWordBoundary,
+    kNotWordBoundary
+  };
+  Kind kind = Kind::kEmpty;
+  ByteSet set;
+  std::size_t min = 0;
+  // kUnbounded for * and +.
+  std::size_t max = 0;
+  std::vector<Node> children;
+};
+
+constexpr std::size_t kUnbounded = SIZE_MAX;
+
+/**
+ * A class used to parse a pattern into Nodes. Parsing stops at the first
+ * error, after which the result is meaningless and failed() is true.
+ */
+class Parser {
+ private:
+  std::string_view mPattern;
+  std::size_t mPos = 0;
+  std::size_t mDepth = 0;
+  bool mFailed = false;
+
+  bool atEnd() const { return mPos >= mPattern.size(); }
+  char peek() const { return mPattern[mPos]; }
+
+  Node fail() {
+    mFailed = true;
+    mPos = mPattern.size();
+    return Node();
+  }
+
+  static Node setNode(const ByteSet& set) {
+    Node node;
+    node.kind = Node::Kind::kSet;
+    node.set = set;
+    return node;
+  }
+
+  Node parseAlternation();
+  Node parseConcatenation();
+  bool parseQuantifier(Node& atom);
+  bool parseBound(std::size_t& value);
+  Node parseAtom();
+  Node parseClass();
+  // Parses the escape after a backslash. Sets isSet and fills set for class
+  // escapes such as \d, and returns the byte otherwise.
+  int parseEscape(bool inClass, bool& isSet, ByteSet& set);
+  int parseHex(std::size_t digits);
+
+ public:
+  explicit Parser(std::string_view pattern) : mPattern(pattern) {}
+
+  Node parse() {
+    Node root = parseAlternation();
+    if (!atEnd()) {
+      // Only an unmatched ')' stops the top-level alternation early.
+      return fail();
+    }
+    return root;
+  }
+
+  bool failed() const { return mFailed; }
+};
+
+Node Parser::parseAlternation() {
+  if (++mDepth > SearchPattern::kMaxNesting) {
+    return fail();
+  }
+  Node first = parseConcatenation();
+  if (atEnd() || peek() != '|') {
+    --mDepth;
+    return first;
+  }
+  Node alternation;
+  alternation.kind = Node::Kind::kAlternate;
+  alternation.children.push_back(std::move(first));
+  while (!atEnd() && peek() == '|') {
+    ++mPos;
+    alternation.children.push_back(parseConcatenation());
+  }
+  --mDepth;
+  return alternation;
+}
+
+Node Parser::parseConcatenation() {
+  Node concatenation;
+  concatenation.kind = Node::Kind::kConcat;
+  while (!atEnd() && peek() != '|' && peek() != ')') {
+    Node atom = parseAtom();
+    if (!parseQuantifier(atom)) {
+      return fail();
+    }
+    concatenation.children.push_back(std::move(atom));
+  }
+  return concatenation;
+}
+
+// Applies a quantifier following atom, if there is one. Returns false if the
+// quantifier is malformed or has nothing it may repeat.
+bool Parser::parseQuantifier(Node& atom) {
+  if (atEnd()) {
+    return true;
+  }
+  std::size_t min = 0;
+  std::size_t max = 0;
+  switch (peek()) {
+    case '*':
+      min = 0;
+      max = kUnbounded;
+      ++mPos;
+      break;
+    case '+':
+      min = 1;
+      max = kUnbounded;
+      ++mPos;
+      break;
+    case '?':
+      min = 0;
+      max = 1;
+      ++mPos;
+      break;
+    case '{':
+      ++mPos;
+      if (!parseBound(min)) {
+        return false;
+      }
+      max = min;
+      if (!atEnd() && peek() == ',') {
+        ++mPos;
+        max = kUnbounded;
+        if (!atEnd() && peek() != '}' && !parseBound(max)) {
+          return false;
+        }
+      }
+      if (atEnd() || peek() != '}' || max < min) {
+        return false;
+      }
+      ++mPos;
+      break;
+    default:
+      return true;
+  }
+  if (atom.kind != Node::Kind::kSet && atom.kind != Node::Kind::kConcat &&
+      atom.kind != Node::Kind::kAlternate) {
+    return false;
+  }
+  // A lazy quantifier finds the same titles as a greedy one.
+  if (!atEnd() && peek() == '?') {
+    ++mPos;
+  }
+  if (!atEnd() &&
+      (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{')) {
+    return false;
+  }
+  Node repeat;
+  repeat.kind = Node::Kind::kRepeat;
+  repeat.min = min;
+  repeat.max = max;
+  repeat.children.push_back(std::move(atom));
+  atom = std::move(repeat);
+  return true;
+}
+
+bool Parser::parseBound(std::size_t& value) {
+  std::size_t start = mPos;
+  value = 0;
+  while (!atEnd() && peek() >= '0' && peek() <= '9') {
+    value = value * 10 + static_cast<std::size_t>(peek() - '0');
+    if (value > SearchPattern::kMaxRepeat) {
+      return false;
+    }
+    ++mPos;
+  }
+  return mPos != start;
+}
+
+Node Parser::parseAtom() {
+  char c = peek();
+  ++mPos;
+  switch (c) {
+    case '(': {
+      if (!atEnd() && peek() == '?') {
+        // Only non-capturing groups; lookarounds are not supported.
+        if (mPos + 1 >= mPattern.size() || mPattern[mPos + 1] != ':') {
+          return fail();
+        }
+        mPos += 2;
+      }
+      Node group = parseAlternation();
+      if (atEnd() || peek() != ')') {
+        return fail();
+      }
+      ++mPos;
+      return group;
+    }
+    case '[':
+      return parseClass();
+    case '.': {
+      ByteSet set;
+      set.set();
+      set.reset('\n');
+      set.reset('\r');
+      return setNode(set);
+    }
+    case '^': {
+      Node node;
+      node.kind = Node::Kind::kAssertBegin;
+      return node;
+    }
+    case '$': {
+      Node node;
+      node.kind = Node::Kind::kAssertEnd;
+      return node;
+    }
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      // Nothing to repeat.
+      return fail();
+    case '\\': {
+      if (atEnd()) {
+        return fail();
+      }
+      if (peek() == 'b' || peek() == 'B') {
+        Node node;
+        node.kind = peek() == 'b' ? Node::Kind::kWordBoundary
+                                  : Node::Kind::kNotWordBoundary;
+        ++mPos;
+        return node;
+      }
+      bool isSet = false;
+      ByteSet set;
+      int byte = parseEscape(false, isSet, set);
+      if (byte < 0) {
+        return fail();
+      }
+      if (!isSet) {
+        set.set(static_cast<std::size_t>(byte));
+      }
+      return setNode(caseClosed(set));
+    }
+    default: {
+      ByteSet set;
+      set.set(static_cast<unsigned char>(c));
+      return setNode(caseClosed(set));
+    }
+  }
+}
+
+Node Parser::parseClass() {
+  bool negated = !atEnd() && peek() == '^';
+  if (negated) {
+    ++mPos;
+  }
+  ByteSet set;
+  while (!atEnd() && peek() != ']') {
+    bool lowIsSet = false;
+    ByteSet lowSet;
+    int low = static_cast<unsigned char>(peek());
+    ++mPos;
+    if (low == '\\') {
+      if (atEnd()) {
+        return fail();
+      }
+      low = parseEscape(true, lowIsSet, lowSet);
+      if (low < 0) {
+        return fail();
+      }
+    }
+    if (mPos + 1 < mPattern.size() && peek() == '-' &&
+        mPattern[mPos + 1] != ']') {
+      ++mPos;
+      bool highIsSet = false;
+      ByteSet highSet;
+      int high = static_cast<unsigned char>(peek());
+      ++mPos;
+      if (high == '\\') {
+        if (atEnd()) {
+          return fail();
+        }
+        high = parseEscape(true, highIsSet, highSet);
+      }
+      if (lowIsSet || highIsSet || high < low) {
+        return fail();
+      }
+      for (int byte = low; byte <= high; ++byte) {
+        set.set(static_cast<std::size_t>(byte));
+      }
+    } else if (lowIsSet) {
+      set |= lowSet;
+    } else {
+      set.set(static_cast<std::size_t>(low));
+    }
+  }
+  if (atEnd()) {
+    return fail();
+  }
+  ++mPos;
+  // Close under case before negating, so [^a] rejects 'A' as well.
+  set = caseClosed(set);
+  if (negated) {
+    set.flip();
+  }
+  return setNode(set);
+}
+
+int Parser::parseEscape(bool inClass, bool& isSet, ByteSet& set) {
+  char c = peek();
+  ++mPos;
+  switch (c) {
+    case 'd':
+    case 'D':
+    case 'w':
+    case 'W':
+    case 's':
+    case 'S':
+      isSet = true;
+      set = c == 'd' || c == 'D' ? digitSet()
+            : c == 'w' || c == 'W' ? wordSet()
+                                   : spaceSet();
+      if (c == 'D' || c == 'W' || c == 'S') {
+        set.flip();
+      }
+      return 0;
+    case 'b':
+      // Only reached inside a class, where \b is a backspace.
+      return inClass ? '\b' : -1;
+    case 't':
+      return '\t';
+    case 'n':
+      return '\n';
+    case 'v':
+      return '\v';
+    case 'f':
+      return '\f';
+    case 'r':
+      return '\r';
+    case '0':
+      return atEnd() || peek() < '0' || peek() > '9' ? 0 : -1;
+    case 'x':
+      return parseHex(2);
+    case 'u':
+      return parseHex(4);
+    case 'c':
+      if (atEnd() || !((peek() >= 'a' && peek() <= 'z') ||
+                       (peek() >= 'A' && peek() <= 'Z'))) {
+        return -1;
+      }
+      return mPattern[mPos++] % 32;
+    default:
+      // Backreferences need backtracking, which this engine exists to avoid.
+      if (c >= '1' && c <= '9') {
+        return -1;
+      }
+      return static_cast<unsigned char>(c);
+  }
+}
+
+// Parses exactly digits hex digits. Only values that fit in a byte are
+// accepted, as titles are matched byte by byte.
+int Parser::parseHex(std::size_t digits) {
+  int value = 0;
+  for (std::size_t i = 0; i < digits; ++i) {
+    if (atEnd()) {
+      return -1;
+    }
+    char c = peek();
+    ++mPos;
+    int digit = c >= '0' && c <= '9'   ? c - '0'
+                : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                       : -1;
+    if (digit < 0) {
+      return -1;
+    }
+    value = value * 16 + digit;
+  }
+  return value < 256 ? value : -1;
+}
+
+}  // namespace
+
+/**
+ * A class used to turn parsed Nodes into a SearchPattern's program.
+ */
+class SearchPatternCompiler {
+ private:
+  using Op = SearchPattern::Op;
+
+  SearchPattern& mPattern;
+  bool mTooLarge = false;
+
+  std::uint32_t emit(Op op, std::uint32_t x = 0, std::uint32_t y = 0) {
+    if (mPattern.mProgram.size() >= SearchPattern::kMaxProgramSize) {
+      mTooLarge = true;
+    }
+    mPattern.mProgram.push_back({op, x, y});
+    return static_cast<std::uint32_t>(mPattern.mProgram.size() - 1);
+  }
+
+  std::uint32_t here() const {
+    return static_cast<std::uint32_t>(mPattern.mProgram.size());
+  }
+
+  std::uint32_t byteSet(const ByteSet& set) {
+    mPattern.mByteSets.push_back(set);
+    return static_cast<std::uint32_t>(mPattern.mByteSets.size() - 1);
+  }
+
+ public:
+  explicit SearchPatternCompiler(SearchPattern& pattern) : mPattern(pattern) {}
+
+  bool tooLarge() const { return mTooLarge; }
+
+  void compile(const Node& node) {
+    if (mTooLarge) {
+      return;
+    }
+    switch (node.kind) {
+      case Node::Kind::kEmpty:
+        break;
+      case Node::Kind::kSet:
+        emit(Op::kByteSet, byteSet(node.set));
+        break;
+      case Node::Kind::kAssertBegin:
+        emit(Op::kAssertBegin);
+        break;
+      case Node::Kind::kAssertEnd:
+        emit(Op::kAssertEnd);
+        break;
+      case Node::Kind::kWordBoundary:
+        emit(Op::kWordBoundary);
+        break;
+      case Node::Kind::kNotWordBoundary:
+        emit(Op::kNotWordBoundary);
+        break;
+      case Node::Kind::kConcat:
+        for (const auto& child : node.children) {
+          compile(child);
+        }
+        break;
+      case Node::Kind::kAlternate: {
+        // split L1, next; L1: child; jump end; next: split L2, ...
+        std::vector<std::uint32_t> jumps;
+        for (std::size_t i = 0; i < node.children.size(); ++i) {
+          if (i + 1 == node.children.size()) {
+            compile(node.children[i]);
+            break;
+          }
+          std::uint32_t split = emit(Op::kSplit);
+          mPattern.mProgram[split].x = here();
+          compile(node.children[i]);
+          jumps.push_back(emit(Op::kJump));
+          mPattern.mProgram[split].y = here();
+        }
+        for (std::uint32_t jump : jumps) {
+          mPattern.mProgram[jump].x = here();
+        }
+        break;
+      }
+      case Node::Kind::kRepeat: {
+        const Node& child = node.children.front();
+        for (std::size_t i = 0; i < node.min && !mTooLarge; ++i) {
+          compile(child);
+        }
+        if (node.max == kUnbounded) {
+          // loop: split body, end; body: child; jump loop; end:
+          std::uint32_t loop = emit(Op::kSplit);
+          mPattern.mProgram[loop].x = here();
+          compile(child);
+          emit(Op::kJump, loop);
+          mPattern.mProgram[loop].y = here();
+          break;
+        }
+        // Each optional copy may be skipped straight to the end.
+        std::vector<std::uint32_t> splits;
+        for (std::size_t i = node.min; i < node.max && !mTooLarge; ++i) {
+          std::uint32_t split = emit(Op::kSplit);
+          mPattern.mProgram[split].x = here();
+          splits.push_back(split);
+          compile(child);
+        }
+        for (std::uint32_t split : splits) {
+          mPattern.mProgram[split].y = here();
+        }
+        break;
+      }
+    }
+  }
+};
+
+std::optional<SearchPattern> SearchPattern::compile(std::string_view pattern) {
+  Parser parser(pattern);
+  Node root = parser.parse();
+  if (parser.failed()) {
+    return std::nullopt;
+  }
+
+  SearchPattern result;
+  SearchPatternCompiler compiler(result);
+  // Searching is unanchored: the program starts with a loop that lets a
+  // match begin at any byte.
+  ByteSet any;
+  any.set();
+  result.mByteSets.push_back(any);
+  result.mProgram.push_back({Op::kSplit, 3, 1});
+  result.mProgram.push_back({Op::kByteSet, 0, 0});
+  result.mProgram.push_back({Op::kJump, 0, 0});
+  compiler.compile(root);
+  result.mProgram.push_back({Op::kMatch, 0, 0});
+  if (compiler.tooLarge()) {
+    return std::nullopt;
+  }
+  result.mMarks.assign(result.mProgram.size(), 0);
+  return result;
+}
+
+// Collects the instructions reachable from seeds without consuming a byte.
+// Without a context, assertions are kept unresolved in out; with one, they
+// are followed if they hold. Returns the number of instructions visited.
+std::uint64_t SearchPattern::closure(const std::vector<std::uint32_t>& seeds,
+                                     const Context* context,
+                                     std::vector<std::uint32_t>& out) {
+  if (++mMarkGeneration == 0) {
+    std::fill(mMarks.begin(), mMarks.end(), 0);
+    mMarkGeneration = 1;
+  }
+  out.clear();
+  mStack.assign(seeds.rbegin(), seeds.rend());
+  std::uint64_t visited = 0;
+  while (!mStack.empty()) {
+    std::uint32_t pc = mStack.back();
+    mStack.pop_back();
+    if (mMarks[pc] == mMarkGeneration) {
+      continue;
+    }
+    mMarks[pc] = mMarkGeneration;
+    ++visited;
+    const Instruction& instruction = mProgram[pc];
+    bool holds = false;
+    switch (instruction.op) {
+      case Op::kSplit:
+        mStack.push_back(instruction.y);
+        mStack.push_back(instruction.x);
+        continue;
+      case Op::kJump:
+        mStack.push_back(instruction.x);
+        continue;
+      case Op::kByteSet:
+      case Op::kMatch:
+        out.push_back(pc);
+        continue;
+      case Op::kAssertBegin:
+        holds = context && context->atBegin;
+        break;
+      case Op::kAssertEnd:
+        holds = context && context->atEnd;
+        break;
+      case Op::kWordBoundary:
+        holds = context && context->prevWord != context->nextWord;
+        break;
+      case Op::kNotWordBoundary:
+        holds = context && context->prevWord == context->nextWord;
+        break;
+    }
+    if (!context) {
+      out.push_back(pc);
+    } else if (holds) {
+      mStack.push_back(pc + 1);
+    }
+  }
+  std::sort(out.begin(), out.end());
+  return visited;
+}
+
+std::int32_t SearchPattern::intern(std::vector<std::uint32_t>&& pcs,
+                                   bool atBegin, bool prevWord) {
+  std::string key(1, static_cast<char>(atBegin << 1 | prevWord));
+  key.append(reinterpret_cast<const char*>(pcs.data()),
+             pcs.size() * sizeof(std::uint32_t));
+  auto found = mStateIds.find(key);
+  if (found != mStateIds.end()) {
+    return found->second;
+  }
+  DfaState state;
+  state.pcs = std::move(pcs);
+  state.atBegin = atBegin;
+  state.prevWord = prevWord;
+  state.next.assign(256, kUnknown);
+  mStates.push_back(std::move(state));
+  std::int32_t id = static_cast<std::int32_t>(mStates.size() - 1);
+  mStateIds.emplace(std::move(key), id);
+  return id;
+}
+
+std::int32_t SearchPattern::start(std::uint64_t& cost) {
+  if (mStart == kUnknown) {
+    std::vector<std::uint32_t> pcs;
+    cost += closure({0}, nullptr, pcs);
+    mStart = intern(std::move(pcs), true, false);
+  }
+  return mStart;
+}
+
+std::int32_t SearchPattern::step(std::int32_t state, unsigned char byte,
+                                 std::uint64_t& cost) {
+  std::int32_t cached = mStates[state].next[byte];
+  if (cached != kUnknown) {
+    return cached;
+  }
+  // Resolve the assertions now that the next byte is known, then advance
+  // every byte set that accepts it.
+  Context context = {mStates[state].atBegin, false, mStates[state].prevWord,
+                     isWordByte(byte)};
+  std::vector<std::uint32_t> live;
+  cost += closure(mStates[state].pcs, &context, live);
+  std::vector<std::uint32_t> seeds;
+  for (std::uint32_t pc : live) {
+    if (mProgram[pc].op == Op::kMatch) {
+      mStates[state].next[byte] = kMatched;
+      return kMatched;
+    }
+    if (mProgram[pc].op == Op::kByteSet && mByteSets[mProgram[pc].x][byte]) {
+      seeds.push_back(pc + 1);
+    }
+  }
+  std::vector<std::uint32_t> pcs;
+  cost += closure(seeds, nullptr, pcs);
+
+  // Rather than grow without bound, start the cache over. Only the state
+  // being stepped to is needed to carry on.
+  if (mStates.size() >= kMaxCachedStates) {
+    mStates.clear();
+    mStateIds.clear();
+    mStart = kUnknown;
+    return intern(std::move(pcs), false, isWordByte(byte));
+  }
+  std::int32_t next = intern(std::move(pcs), false, isWordByte(byte));
+  mStates[state].next[byte] = next;
+  return next;
+}
+
+bool SearchPattern::matchesAtEnd(std::int32_t state, std::uint64_t& cost) {
+  if (mStates[state].matchesAtEnd < 0) {
+    Context context = {mStates[state].atBegin, true, mStates[state].prevWord,
+                       false};
+    std::vector<std::uint32_t> live;
+    cost += closure(mStates[state].pcs, &context, live);
+    mStates[state].matchesAtEnd =
+        std::any_of(live.begin(), live.end(), [this](std::uint32_t pc) {
+          return mProgram[pc].op == Op::kMatch;
+        });
+  }
+  return mStates[state].matchesAtEnd;
+}
+
+SearchPattern::Result SearchPattern::search(std::string_view text,
+                                            std::uint64_t& steps) {
+  std::uint64_t cost = 0;
+  std::int32_t state = start(cost);
+  for (char c : text) {
+    cost += 1;
+    if (cost > steps) {
+      steps = 0;
+      return Result::kOutOfSteps;
+    }
+    state = step(state, static_cast<unsigned char>(foldChar(c)), cost);
+    if (state == kMatched) {
+      steps -= std::min(cost, steps);
+      return Result::kMatch;
+    }
+  }
+  bool matched = matchesAtEnd(state, cost);
+  if (cost > steps) {
+    steps = 0;
+    return Result::kOutOfSteps;
+  }
+  steps -= cost;
+  return matched ? Result::kMatch : Result::kNoMatch;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A class used to match SEARCH_VIDEOS regexes against titles in linear time.
+ * A pattern in the ECMAScript subset without backreferences or lookaround is
+ * compiled into an NFA program, which is then run as a lazily built DFA: each
+ * DFA state is the set of NFA instructions alive at a point in the text, and
+ * its transitions are only worked out the first time a byte is seen in that
+ * state. Text is examined one byte at a time and never revisited, so nothing
+ * a user types can make matching backtrack.
+ *
+ * Matching ignores ASCII case. Every search is charged against a step budget
+ * (one step per byte, plus the work of building each new DFA state), so the
+ * cost of a query is bounded no matter the pattern.
+ */
+class SearchPattern {
+ public:
+  enum class Result { kMatch, kNoMatch, kOutOfSteps };
+
+  // Returns nothing if pattern is not valid or uses unsupported syntax, or
+  // if its program would exceed kMaxProgramSize instructions.
+  static std::optional<SearchPattern> compile(std::string_view pattern);
+
+  // Returns whether text contains a match for the pattern, deducting the
+  // steps taken from steps. If steps runs out first, returns kOutOfSteps.
+  Result search(std::string_view text, std::uint64_t& steps);
+
+  // Limits on the size of a compiled pattern, which also bound the cost of
+  // building one DFA state.
+  static constexpr std::size_t kMaxProgramSize = 10000;
+  static constexpr std::size_t kMaxNesting = 100;
+  static constexpr std::size_t kMaxRepeat = 1000;
+
+ private:
+  enum class Op : std::uint8_t {
+    kByteSet,
+    kSplit,
+    kJump,
+    kAssertBegin,
+    kAssertEnd,
+    kWordBoundary,
+    kNotWordBoundary,
+    kMatch
+  };
+
+  struct Instruction {
+    Op op;
+    // kByteSet: index into mByteSets. kSplit, kJump: the targets.
+    std::uint32_t x = 0;
+    std::uint32_t y = 0;
+  };
+
+  // What the assertions may look at: the position in the text and whether
+  // the bytes on either side of it are word characters.
+  struct Context {
+    bool atBegin;
+    bool atEnd;
+    bool prevWord;
+    bool nextWord;
+  };
+
+  struct DfaState {
+    // The live instructions: byte sets, kMatch and assertions not yet
+    // resolved.
+    std::vector<std::uint32_t> pcs;
+    bool atBegin;
+    bool prevWord;
+    // Indexes into mStates, or kUnknown or kMatched, by folded input byte.
+    std::vector<std::int32_t> next;
+    // -1 until worked out, then whether the state matches at end of text.
+    std::int8_t matchesAtEnd = -1;
+  };
+
+  static constexpr std::int32_t kUnknown = -1;
+  static constexpr std::int32_t kMatched = -2;
+  static constexpr std::size_t kMaxCachedStates = 1024;
+
+  std::vector<Instruction> mProgram;
+  // Byte sets over folded input (see foldChar); a set holding a letter holds
+  // its upper-case form.
+  std::vector<std::bitset<256>> mByteSets;
+
+  std::vector<DfaState> mStates;
+  std::unordered_map<std::string, std::int32_t> mStateIds;
+  std::int32_t mStart = kUnknown;
+  // Scratch space for closures, reused across steps.
+  std::vector<std::uint32_t> mMarks;
+  std::uint32_t mMarkGeneration = 0;
+  std::vector<std::uint32_t> mStack;
+
+  SearchPattern() = default;
+
+  friend class SearchPatternCompiler;
+
+  std::uint64_t closure(const std::vector<std::uint32_t>& seeds,
+                        const Context* context,
+                        std::vector<std::uint32_t>& out);
+  std::int32_t intern(std::vector<std::uint32_t>&& pcs, bool atBegin,
+                      bool prevWord);
+  std::int32_t start(std::uint64_t& cost);
+  std::int32_t step(std::int32_t state, unsigned char byte,
+                    std::uint64_t& cost);
+  bool matchesAtEnd(std::int32_t state, std::uint64_t& cost);
+};
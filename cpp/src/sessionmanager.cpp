@@ -0,0 +1,51 @@
+#include "sessionmanager.h"
+
+#include <utility>
+
+#include "videoplayer.h"
+
+SessionManager::SessionManager(VideoLibrary&& library)
+    : mSharedLibrary(std::make_shared<VideoLibrary>(std::move(library))) {}
+
+SessionManager::SessionId SessionManager::open(
+    SessionScope scope, std::shared_ptr<OutputSink> output) {
+  std::shared_ptr<VideoLibrary> library =
+      scope == SessionScope::Shared
+          ? mSharedLibrary
+          : std::make_shared<VideoLibrary>(mSharedLibrary->shareCatalog());
+  SessionId session;
+  std::lock_guard<std::mutex> lock(mFreeIdsMutex);
+  if (mFreeIds.empty()) {
+    session = static_cast<SessionId>(mSessions.size());
+    mSessions.emplace_back();
+  } else {
+    session = mFreeIds.back();
+    mFreeIds.pop_back();
+  }
+  mSessions[session].emplace(
+      VideoPlayer(std::move(library), std::move(output)));
+  ++mOpenCount;
+  return session;
+}
+
+bool SessionManager::close(SessionId session) {
+  if (session >= mSessions.size() || !mSessions[session]) {
+    return false;
+  }
+  mSessions[session].reset();
+  std::lock_guard<std::mutex> lock(mFreeIdsMutex);
+  mFreeIds.push_back(session);
+  --mOpenCount;
+  return true;
+}
+
+bool SessionManager::executeLine(SessionId session, std::string_view line) {
+  if (session >= mSessions.size() || !mSessions[session]) {
+    return false;
+  }
+  if (!mSessions[session]->executeLine(line)) {
+    close(session);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "commandparser.h"
+#include "outputsink.h"
+#include "videolibrary.h"
+
+/**
+ * Whether a session keeps playlists and flags of its own or uses the ones
+ * every shared session does.
+ */
+enum class SessionScope { Private, Shared };
+
+/**
+ * A class used to serve many users from one process. The catalog is loaded
+ * once and every session plays from it; a session only adds its own player
+ * state and, if it is private, its own playlists and flags. Reloading the
+ * catalog from any session moves all of them onto the new one.
+ *
+ * Once enableConcurrency is called, different sessions' commands may run on
+ * different threads at once, as long as every session is opened before the
+ * threads start and each session is only used by one thread at a time.
+ */
+class SessionManager {
+ public:
+  using SessionId = std::uint32_t;
+
+ private:
+  std::shared_ptr<VideoLibrary> mSharedLibrary;
+  // Indexed by id; a closed session leaves its slot for the next one.
+  std::vector<std::optional<CommandParser>> mSessions;
+  // Guards mFreeIds, which sessions closing on different threads return
+  // their ids to.
+  std::mutex mFreeIdsMutex;
+  std::vector<SessionId> mFreeIds;
+  std::atomic<std::size_t> mOpenCount{0};
+
+ public:
+  // Serves sessions from library, whose playlists and flags are the shared
+  // ones.
+  explicit SessionManager(VideoLibrary&& library);
+
+  // This class is not copyable, it owns the sessions.
+  SessionManager(const SessionManager&) = delete;
+  SessionManager& operator=(const SessionManager&) = delete;
+
+  // Opens a session that writes its output to output and returns its id.
+  SessionId open(SessionScope scope, std::shared_ptr<OutputSink> output);
+
+  // Closes a session. Returns false if there is no session with the id.
+  bool close(SessionId session);
+
+  // Executes a line of input in a session, like CommandParser::executeLine.
+  // EXIT closes the session. Returns false if there is no session with the
+  // id or it was closed.
+  bool executeLine(SessionId session, std::string_view line);
+
+  // Returns the number of open sessions.
+  std::size_t size() const { return mOpenCount.load(); }
+
+  // Lets shared sessions run commands on many threads at once; see
+  // VideoLibrary::enableConcurrency. Must be called before they do.
+  void enableConcurrency(std::size_t shardCount = 64) {
+    mSharedLibrary->enableConcurrency(shardCount);
+  }
+
+  // Returns the library shared sessions play from.
+  VideoLibrary& getSharedLibrary() { return *mSharedLibrary; }
+};
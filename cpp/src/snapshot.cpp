@@ -0,0 +1,517 @@
+#include "snapshot.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+#include "casefold.h"
+#include "catalog.h"
+
+namespace {
+
+std::uint64_t alignUp(std::uint64_t offset) { return (offset + 7) & ~7ull; }
+
+// Hands out consecutive offsets into the string blob, in the same order the
+// strings are later written.
+class StringAllocator {
+ private:
+  std::uint64_t mSize = 0;
+
+ public:
+  SnapshotString add(std::string_view s) {
+    SnapshotString ref{mSize, static_cast<std::uint32_t>(s.size()), 0};
+    mSize += s.size();
+    return ref;
+  }
+  std::uint64_t size() const { return mSize; }
+};
+
+template <typename Record>
+void writeRecord(std::ofstream& out, const Record& record) {
+  out.write(reinterpret_cast<const char*>(&record), sizeof(Record));
+}
+
+void writeWords(std::ofstream& out, Span<std::uint32_t> words) {
+  out.write(reinterpret_cast<const char*>(words.data()),
+            static_cast<std::streamsize>(words.size() * sizeof(std::uint32_t)));
+}
+
+void padTo(std::ofstream& out, std::uint64_t offset) {
+  static const char zeros[8] = {};
+  std::uint64_t position = static_cast<std::uint64_t>(out.tellp());
+  out.write(zeros, static_cast<std::streamsize>(offset - position));
+}
+
+}  // namespace
+
+bool writeSnapshot(const std::string& path, const SnapshotContents& contents) {
+  static const Catalog emptyCatalog;
+  const Catalog& catalog = contents.catalog ? *contents.catalog : emptyCatalog;
+  const std::vector<Video>& videos = catalog.getVideos();
+  Span<std::uint32_t> slots = catalog.getVideoIndex().slots();
+  const TagDictionary& tags = catalog.getTagDictionary();
+  const std::vector<TagId>& overflow = tags.getOverflow();
+  Span<std::uint32_t> titleOrder = catalog.getTitleOrder();
+  Span<std::uint32_t> postingOffsets = catalog.getTagIndex().offsets();
+  Span<std::uint32_t> postings = catalog.getTagIndex().postings();
+  const TitleIndex& titleIndex = catalog.getTitleIndex();
+  std::size_t entryCount = 0;
+  for (const auto& playlist : contents.playlists) {
+    entryCount += playlist.second.size();
+  }
+
+  SnapshotHeader header = {};
+  std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.version = kSnapshotVersion;
+  header.byteOrderMark = kSnapshotByteOrderMark;
+  header.videoCount = videos.size();
+  header.indexSlotCount = slots.size();
+  header.tagCount = tags.size();
+  header.tagOverflowCount = overflow.size();
+  header.tagPostingOffsetCount = postingOffsets.size();
+  header.tagPostingCount = postings.size();
+  header.titleTrigramCount = titleIndex.trigrams().size();
+  header.titlePostingCount = titleIndex.postings().size();
+  header.flagCount = contents.flags.size();
+  header.playlistCount = contents.playlists.size();
+  header.playlistEntryCount = entryCount;
+  header.videosOffset = alignUp(sizeof(SnapshotHeader));
+  header.indexOffset =
+      alignUp(header.videosOffset + header.videoCount * sizeof(SnapshotVideo));
+  header.titleOrderOffset = alignUp(
+      header.indexOffset + header.indexSlotCount * sizeof(std::uint32_t));
+  header.tagsOffset = alignUp(header.titleOrderOffset +
+                              header.videoCount * sizeof(std::uint32_t));
+  header.tagOverflowOffset =
+      alignUp(header.tagsOffset + header.tagCount * sizeof(SnapshotString));
+  header.tagPostingOffsetsOffset = alignUp(
+      header.tagOverflowOffset + header.tagOverflowCount * sizeof(TagId));
+  header.tagPostingsOffset =
+      alignUp(header.tagPostingOffsetsOffset +
+              header.tagPostingOffsetCount * sizeof(std::uint32_t));
+  header.titleTrigramsOffset = alignUp(
+      header.tagPostingsOffset + header.tagPostingCount * sizeof(std::uint32_t));
+  header.titlePostingOffsetsOffset =
+      alignUp(header.titleTrigramsOffset +
+              header.titleTrigramCount * sizeof(std::uint32_t));
+  header.titlePostingsOffset =
+      alignUp(header.titlePostingOffsetsOffset +
+              (header.titleTrigramCount + 1) * sizeof(std::uint32_t));
+  header.flagsOffset =
+      alignUp(header.titlePostingsOffset +
+              header.titlePostingCount * sizeof(std::uint32_t));
+  header.playlistsOffset =
+      alignUp(header.flagsOffset + header.flagCount * sizeof(SnapshotFlag));
+  header.playlistEntriesOffset = alignUp(
+      header.playlistsOffset + header.playlistCount * sizeof(SnapshotPlaylist));
+  header.stringsOffset = alignUp(header.playlistEntriesOffset +
+                                 entryCount * sizeof(SnapshotString));
+
+  std::string tempPath = path + ".tmp";
+  std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    return false;
+  }
+  // The header is rewritten once the size of the string blob is known.
+  writeRecord(out, header);
+
+  StringAllocator strings;
+  padTo(out, header.videosOffset);
+  for (const auto& video : videos) {
+    SnapshotVideo record = {};
+    record.title = strings.add(video.getTitle());
+    record.videoId = strings.add(video.getVideoId());
+    record.tags = video.getTagSet();
+    writeRecord(out, record);
+  }
+  padTo(out, header.indexOffset);
+  writeWords(out, slots);
+  padTo(out, header.titleOrderOffset);
+  writeWords(out, titleOrder);
+  padTo(out, header.tagsOffset);
+  for (std::size_t tag = 0; tag < tags.size(); ++tag) {
+    writeRecord(out, strings.add(tags.getTag(static_cast<TagId>(tag))));
+  }
+  padTo(out, header.tagOverflowOffset);
+  writeWords(out, Span<TagId>(overflow.data(), overflow.size()));
+  padTo(out, header.tagPostingOffsetsOffset);
+  writeWords(out, postingOffsets);
+  padTo(out, header.tagPostingsOffset);
+  writeWords(out, postings);
+  padTo(out, header.titleTrigramsOffset);
+  writeWords(out, titleIndex.trigrams());
+  padTo(out, header.titlePostingOffsetsOffset);
+  writeWords(out, titleIndex.offsets());
+  padTo(out, header.titlePostingsOffset);
+  writeWords(out, titleIndex.postings());
+  padTo(out, header.flagsOffset);
+  for (const auto& flag : contents.flags) {
+    SnapshotFlag record;
+    record.videoId = strings.add(flag.first);
+    record.reason = strings.add(flag.second);
+    writeRecord(out, record);
+  }
+  padTo(out, header.playlistsOffset);
+  std::uint64_t firstEntry = 0;
+  for (const auto& playlist : contents.playlists) {
+    SnapshotPlaylist record;
+    record.name = strings.add(playlist.first);
+    record.firstEntry = firstEntry;
+    record.entryCount = playlist.second.size();
+    firstEntry += playlist.second.size();
+    writeRecord(out, record);
+  }
+  padTo(out, header.playlistEntriesOffset);
+  for (const auto& playlist : contents.playlists) {
+    for (const auto& videoId : playlist.second) {
+      writeRecord(out, strings.add(videoId));
+    }
+  }
+
+  // Write the blob in exactly the order the strings were allocated above.
+  padTo(out, header.stringsOffset);
+  for (const auto& video : videos) {
+    out << video.getTitle() << video.getVideoId();
+  }
+  for (std::size_t tag = 0; tag < tags.size(); ++tag) {
+    out << tags.getTag(static_cast<TagId>(tag));
+  }
+  for (const auto& flag : contents.flags) {
+    out << flag.first << flag.second;
+  }
+  for (const auto& playlist : contents.playlists) {
+    out << playlist.first;
+  }
+  for (const auto& playlist : contents.playlists) {
+    for (const auto& videoId : playlist.second) {
+      out << videoId;
+    }
+  }
+
+  header.stringsSize = strings.size();
+  out.seekp(0);
+  writeRecord(out, header);
+  out.close();
+  if (!out) {
+    std::remove(tempPath.c_str());
+    return false;
+  }
+  return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+bool snapshotIsFresh(const std::string& snapshotPath,
+                     const std::string& catalogPath) {
+  std::error_code error;
+  auto snapshotTime = std::filesystem::last_write_time(snapshotPath, error);
+  if (error) {
+    return false;
+  }
+  auto catalogTime = std::filesystem::last_write_time(catalogPath, error);
+  return error || snapshotTime > catalogTime;
+}
+
+template <typename Record>
+Record SnapshotView::record(std::uint64_t sectionOffset,
+                            std::size_t index) const {
+  Record result;
+  std::memcpy(&result, mData.data() + sectionOffset + index * sizeof(Record),
+              sizeof(Record));
+  return result;
+}
+
+std::string_view SnapshotView::string(const SnapshotString& ref) const {
+  return mData.substr(mHeader.stringsOffset + ref.offset, ref.length);
+}
+
+bool SnapshotView::validString(const SnapshotString& ref) const {
+  return ref.offset <= mHeader.stringsSize &&
+         ref.length <= mHeader.stringsSize - ref.offset;
+}
+
+bool SnapshotView::open(std::string_view data) {
+  // The index sections are read in place as words.
+  if (data.size() < sizeof(SnapshotHeader) ||
+      reinterpret_cast<std::uintptr_t>(data.data()) % 8 != 0) {
+    return false;
+  }
+  std::memcpy(&mHeader, data.data(), sizeof(SnapshotHeader));
+  if (std::memcmp(mHeader.magic, kSnapshotMagic, sizeof(mHeader.magic)) != 0 ||
+      mHeader.version != kSnapshotVersion ||
+      mHeader.byteOrderMark != kSnapshotByteOrderMark) {
+    return false;
+  }
+
+  // Check that every section lies inside the file, in layout order.
+  const std::uint64_t sections[][3] = {
+      {mHeader.videosOffset, mHeader.videoCount, sizeof(SnapshotVideo)},
+      {mHeader.indexOffset, mHeader.indexSlotCount, sizeof(std::uint32_t)},
+      {mHeader.titleOrderOffset, mHeader.videoCount, sizeof(std::uint32_t)},
+      {mHeader.tagsOffset, mHeader.tagCount, sizeof(SnapshotString)},
+      {mHeader.tagOverflowOffset, mHeader.tagOverflowCount, sizeof(TagId)},
+      {mHeader.tagPostingOffsetsOffset, mHeader.tagPostingOffsetCount,
+       sizeof(std::uint32_t)},
+      {mHeader.tagPostingsOffset, mHeader.tagPostingCount,
+       sizeof(std::uint32_t)},
+      {mHeader.titleTrigramsOffset, mHeader.titleTrigramCount,
+       sizeof(std::uint32_t)},
+      {mHeader.titlePostingOffsetsOffset, mHeader.titleTrigramCount + 1,
+       sizeof(std::uint32_t)},
+      {mHeader.titlePostingsOffset, mHeader.titlePostingCount,
+       sizeof(std::uint32_t)},
+      {mHeader.flagsOffset, mHeader.flagCount, sizeof(SnapshotFlag)},
+      {mHeader.playlistsOffset, mHeader.playlistCount,
+       sizeof(SnapshotPlaylist)},
+      {mHeader.playlistEntriesOffset, mHeader.playlistEntryCount,
+       sizeof(SnapshotString)},
+      {mHeader.stringsOffset, mHeader.stringsSize, 1}};
+  std::uint64_t end = sizeof(SnapshotHeader);
+  for (const auto& section : sections) {
+    if (section[0] < end || section[0] % 8 != 0 ||
+        section[0] > data.size() ||
+        section[1] > (data.size() - section[0]) / section[2]) {
+      return false;
+    }
+    end = section[0] + section[1] * section[2];
+  }
+  if (mHeader.videoCount >= UINT32_MAX ||
+      (mHeader.indexSlotCount & (mHeader.indexSlotCount - 1)) != 0 ||
+      (mHeader.indexSlotCount != 0 &&
+       mHeader.indexSlotCount <= mHeader.videoCount)) {
+    return false;
+  }
+  mData = data;
+
+  if (mHeader.tagCount >= TagDictionary::npos ||
+      mHeader.tagOverflowCount >= UINT32_MAX ||
+      mHeader.titlePostingCount >= UINT32_MAX) {
+    return false;
+  }
+  for (std::size_t i = 0; i < mHeader.videoCount; ++i) {
+    auto video = record<SnapshotVideo>(mHeader.videosOffset, i);
+    if (!validString(video.title) || !validString(video.videoId)) {
+      return false;
+    }
+    if (video.tags.count <= TagSet::kInlineTags) {
+      for (std::uint32_t tag = 0; tag < video.tags.count; ++tag) {
+        if (video.tags.ids[tag] >= mHeader.tagCount) {
+          return false;
+        }
+      }
+    } else if (video.tags.ids[0] > mHeader.tagOverflowCount ||
+               video.tags.count >
+                   mHeader.tagOverflowCount - video.tags.ids[0]) {
+      return false;
+    }
+  }
+  // The tags must be distinct, so that re-interning them gives the same ids.
+  std::unordered_set<std::string_view> distinctTags;
+  for (std::size_t i = 0; i < mHeader.tagCount; ++i) {
+    auto tag = record<SnapshotString>(mHeader.tagsOffset, i);
+    if (!validString(tag) || !distinctTags.insert(string(tag)).second) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < mHeader.tagOverflowCount; ++i) {
+    if (record<TagId>(mHeader.tagOverflowOffset, i) >= mHeader.tagCount) {
+      return false;
+    }
+  }
+  // Every video must be indexed exactly once, which also guarantees the free
+  // slots that lookups rely on to terminate.
+  std::uint64_t usedSlots = 0;
+  std::vector<bool> seen(mHeader.videoCount, false);
+  for (std::size_t i = 0; i < mHeader.indexSlotCount; ++i) {
+    std::uint32_t slot = record<std::uint32_t>(mHeader.indexOffset, i);
+    if (slot == 0) {
+      continue;
+    }
+    // A slot holds its video's position plus one.
+    if (slot > mHeader.videoCount || seen[slot - 1]) {
+      return false;
+    }
+    seen[slot - 1] = true;
+    ++usedSlots;
+  }
+  if (usedSlots != (mHeader.indexSlotCount ? mHeader.videoCount : 0) ||
+      (mHeader.indexSlotCount == 0 && mHeader.videoCount != 0)) {
+    return false;
+  }
+  if (!validIndexes()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < mHeader.flagCount; ++i) {
+    auto flag = record<SnapshotFlag>(mHeader.flagsOffset, i);
+    if (!validString(flag.videoId) || !validString(flag.reason)) {
+      return false;
+    }
+  }
+  // Playlist names are unique ignoring case, as in a library.
+  std::unordered_set<std::string_view, FoldedHash, FoldedEqual> playlistNames;
+  for (std::size_t i = 0; i < mHeader.playlistCount; ++i) {
+    auto playlist = record<SnapshotPlaylist>(mHeader.playlistsOffset, i);
+    if (!validString(playlist.name) ||
+        !playlistNames.insert(string(playlist.name)).second ||
+        playlist.firstEntry > mHeader.playlistEntryCount ||
+        playlist.entryCount > mHeader.playlistEntryCount - playlist.firstEntry) {
+      return false;
+    }
+  }
+  for (std::size_t i = 0; i < mHeader.playlistEntryCount; ++i) {
+    if (!validString(
+            record<SnapshotString>(mHeader.playlistEntriesOffset, i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+// Checks that offsets delimit postingCount postings in order.
+bool validPostingOffsets(Span<std::uint32_t> offsets,
+                         std::uint64_t postingCount) {
+  if (offsets.empty() ? postingCount != 0
+                      : offsets[0] != 0 ||
+                            offsets[offsets.size() - 1] != postingCount) {
+    return false;
+  }
+  for (std::size_t i = 1; i < offsets.size(); ++i) {
+    if (offsets[i] < offsets[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+// Checks that the title order is a permutation of the videos and that the
+// tag and title posting lists are well formed.
+bool SnapshotView::validIndexes() const {
+  std::vector<bool> seen(mHeader.videoCount, false);
+  for (std::uint32_t position :
+       words(mHeader.titleOrderOffset, mHeader.videoCount)) {
+    if (position >= mHeader.videoCount || seen[position]) {
+      return false;
+    }
+    seen[position] = true;
+  }
+  if (!validPostingOffsets(words(mHeader.tagPostingOffsetsOffset,
+                                 mHeader.tagPostingOffsetCount),
+                           mHeader.tagPostingCount)) {
+    return false;
+  }
+  for (std::uint32_t position :
+       words(mHeader.tagPostingsOffset, mHeader.tagPostingCount)) {
+    if (position >= mHeader.videoCount) {
+      return false;
+    }
+  }
+  // Trigrams are binary searched, so they must be sorted and distinct.
+  Span<std::uint32_t> trigrams = titleTrigrams();
+  for (std::size_t i = 1; i < trigrams.size(); ++i) {
+    if (trigrams[i] <= trigrams[i - 1]) {
+      return false;
+    }
+  }
+  // Each posting list is intersected with others, so ranks must ascend.
+  Span<std::uint32_t> titleOffsets = titlePostingOffsets();
+  if (!validPostingOffsets(titleOffsets, mHeader.titlePostingCount)) {
+    return false;
+  }
+  Span<std::uint32_t> ranks = titlePostings();
+  for (std::size_t list = 0; list + 1 < titleOffsets.size(); ++list) {
+    for (std::uint32_t i = titleOffsets[list]; i < titleOffsets[list + 1];
+         ++i) {
+      if (ranks[i] >= mHeader.videoCount ||
+          (i > titleOffsets[list] && ranks[i] <= ranks[i - 1])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+Span<std::uint32_t> SnapshotView::words(std::uint64_t sectionOffset,
+                                        std::size_t count) const {
+  // open() checked that the data and every section are aligned.
+  return Span<std::uint32_t>(
+      reinterpret_cast<const std::uint32_t*>(mData.data() + sectionOffset),
+      count);
+}
+
+std::string_view SnapshotView::videoTitle(std::size_t index) const {
+  return string(record<SnapshotVideo>(mHeader.videosOffset, index).title);
+}
+
+std::string_view SnapshotView::videoId(std::size_t index) const {
+  return string(record<SnapshotVideo>(mHeader.videosOffset, index).videoId);
+}
+
+TagSet SnapshotView::videoTags(std::size_t index) const {
+  return record<SnapshotVideo>(mHeader.videosOffset, index).tags;
+}
+
+Span<std::uint32_t> SnapshotView::indexSlots() const {
+  return words(mHeader.indexOffset, mHeader.indexSlotCount);
+}
+
+Span<std::uint32_t> SnapshotView::titleOrder() const {
+  return words(mHeader.titleOrderOffset, mHeader.videoCount);
+}
+
+std::string_view SnapshotView::tag(std::size_t index) const {
+  return string(record<SnapshotString>(mHeader.tagsOffset, index));
+}
+
+std::vector<TagId> SnapshotView::tagOverflow() const {
+  Span<TagId> overflow =
+      words(mHeader.tagOverflowOffset, mHeader.tagOverflowCount);
+  return std::vector<TagId>(overflow.begin(), overflow.end());
+}
+
+Span<std::uint32_t> SnapshotView::tagPostingOffsets() const {
+  return words(mHeader.tagPostingOffsetsOffset, mHeader.tagPostingOffsetCount);
+}
+
+Span<std::uint32_t> SnapshotView::tagPostings() const {
+  return words(mHeader.tagPostingsOffset, mHeader.tagPostingCount);
+}
+
+Span<std::uint32_t> SnapshotView::titleTrigrams() const {
+  return words(mHeader.titleTrigramsOffset, mHeader.titleTrigramCount);
+}
+
+Span<std::uint32_t> SnapshotView::titlePostingOffsets() const {
+  return words(mHeader.titlePostingOffsetsOffset,
+               mHeader.titleTrigramCount + 1);
+}
+
+Span<std::uint32_t> SnapshotView::titlePostings() const {
+  return words(mHeader.titlePostingsOffset, mHeader.titlePostingCount);
+}
+
+std::pair<std::string_view, std::string_view> SnapshotView::flag(
+    std::size_t index) const {
+  auto flag = record<SnapshotFlag>(mHeader.flagsOffset, index);
+  return {string(flag.videoId), string(flag.reason)};
+}
+
+std::string_view SnapshotView::playlistName(std::size_t index) const {
+  return string(record<SnapshotPlaylist>(mHeader.playlistsOffset, index).name);
+}
+
+std::vector<std::string_view> SnapshotView::playlistEntries(
+    std::size_t index) const {
+  auto playlist = record<SnapshotPlaylist>(mHeader.playlistsOffset, index);
+  std::vector<std::string_view> entries;
+  entries.reserve(playlist.entryCount);
+  for (std::uint64_t i = 0; i < playlist.entryCount; ++i) {
+    entries.push_back(string(record<SnapshotString>(
+        mHeader.playlistEntriesOffset, playlist.firstEntry + i)));
+  }
+  return entries;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "span.h"
+#include "tagdictionary.h"
+
+/**
+ * The on-disk layout of a VideoLibrary snapshot:
+ *
+ *   SnapshotHeader | videos | id index slots | title order | tags |
+ *   tag overflow | tag posting offsets | tag postings | title trigrams |
+ *   title posting offsets | title postings | flags | playlists |
+ *   playlist entries | string blob
+ *
+ * Every section starts on an 8-byte boundary and every string is a
+ * SnapshotString into the blob. Integers are stored in host byte order;
+ * kSnapshotByteOrderMark rejects snapshots written on another architecture.
+ * Bump kSnapshotVersion whenever the layout or the id hash changes.
+ */
+constexpr char kSnapshotMagic[8] = {'Y', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint32_t kSnapshotVersion = 4;
+constexpr std::uint32_t kSnapshotByteOrderMark = 0x01020304;
+
+struct SnapshotHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrderMark;
+  std::uint64_t videoCount;
+  std::uint64_t indexSlotCount;
+  std::uint64_t tagCount;
+  std::uint64_t tagOverflowCount;
+  std::uint64_t tagPostingOffsetCount;
+  std::uint64_t tagPostingCount;
+  // The title posting offsets section holds titleTrigramCount + 1 entries.
+  std::uint64_t titleTrigramCount;
+  std::uint64_t titlePostingCount;
+  std::uint64_t flagCount;
+  std::uint64_t playlistCount;
+  std::uint64_t playlistEntryCount;
+  std::uint64_t stringsSize;
+  std::uint64_t videosOffset;
+  std::uint64_t indexOffset;
+  std::uint64_t titleOrderOffset;
+  std::uint64_t tagsOffset;
+  std::uint64_t tagOverflowOffset;
+  std::uint64_t tagPostingOffsetsOffset;
+  std::uint64_t tagPostingsOffset;
+  std::uint64_t titleTrigramsOffset;
+  std::uint64_t titlePostingOffsetsOffset;
+  std::uint64_t titlePostingsOffset;
+  std::uint64_t flagsOffset;
+  std::uint64_t playlistsOffset;
+  std::uint64_t playlistEntriesOffset;
+  std::uint64_t stringsOffset;
+};
+
+struct SnapshotString {
+  std::uint64_t offset;
+  std::uint32_t length;
+  std::uint32_t reserved;
+};
+
+struct SnapshotVideo {
+  SnapshotString title;
+  SnapshotString videoId;
+  // Ids into the tags section, stored exactly as the catalog holds them.
+  TagSet tags;
+  std::uint32_t reserved;
+};
+
+struct SnapshotFlag {
+  SnapshotString videoId;
+  SnapshotString reason;
+};
+
+struct SnapshotPlaylist {
+  SnapshotString name;
+  std::uint64_t firstEntry;
+  std::uint64_t entryCount;
+};
+
+class Catalog;
+
+/**
+ * Everything a snapshot holds, as views into the library being saved.
+ */
+struct SnapshotContents {
+  const Catalog* catalog = nullptr;
+  std::vector<std::pair<std::string_view, std::string_view>> flags;
+  std::vector<std::pair<std::string_view, std::vector<std::string_view>>>
+      playlists;
+};
+
+// Writes contents to a snapshot at path. The file is written next to path and
+// renamed into place, so readers never see a partial snapshot.
+bool writeSnapshot(const std::string& path, const SnapshotContents& contents);
+
+// Returns whether the snapshot exists and was written after the text catalog
+// (or the text catalog does not exist).
+bool snapshotIsFresh(const std::string& snapshotPath,
+                     const std::string& catalogPath);
+
+/**
+ * A class used to read a snapshot held in memory. open() validates every
+ * section and string up front, so the accessors can trust the data.
+ */
+class SnapshotView {
+ private:
+  std::string_view mData;
+  SnapshotHeader mHeader;
+
+  template <typename Record>
+  Record record(std::uint64_t sectionOffset, std::size_t index) const;
+  Span<std::uint32_t> words(std::uint64_t sectionOffset,
+                            std::size_t count) const;
+  bool validIndexes() const;
+  std::string_view string(const SnapshotString& ref) const;
+  bool validString(const SnapshotString& ref) const;
+
+ public:
+  // Returns false if data is not a complete snapshot of a supported version,
+  // or does not start on a word boundary, as a mapped file always does.
+  bool open(std::string_view data);
+
+  std::size_t videoCount() const { return mHeader.videoCount; }
+  std::string_view videoTitle(std::size_t index) const;
+  std::string_view videoId(std::size_t index) const;
+  TagSet videoTags(std::size_t index) const;
+
+  std::size_t indexSlotCount() const { return mHeader.indexSlotCount; }
+  // The index sections are views into the data, valid while it is.
+  Span<std::uint32_t> indexSlots() const;
+  Span<std::uint32_t> titleOrder() const;
+
+  std::size_t tagCount() const { return mHeader.tagCount; }
+  std::string_view tag(std::size_t index) const;
+  std::vector<TagId> tagOverflow() const;
+  Span<std::uint32_t> tagPostingOffsets() const;
+  Span<std::uint32_t> tagPostings() const;
+
+  Span<std::uint32_t> titleTrigrams() const;
+  Span<std::uint32_t> titlePostingOffsets() const;
+  Span<std::uint32_t> titlePostings() const;
+
+  std::size_t flagCount() const { return mHeader.flagCount; }
+  std::pair<std::string_view, std::string_view> flag(std::size_t index) const;
+
+  std::size_t playlistCount() const { return mHeader.playlistCount; }
+  std::string_view playlistName(std::size_t index) const;
+  std::vector<std::string_view> playlistEntries(std::size_t index) const;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * A read-only view of a contiguous run of T, like C++20's std::span.
+ */
+template <typename T>
+class Span {
+ private:
+  const T* mBegin = nullptr;
+  const T* mEnd = nullptr;
+
+ public:
+  Span() = default;
+  Span(const T* begin, const T* end) : mBegin(begin), mEnd(end) {}
+  Span(const T* data, std::size_t size) : mBegin(data), mEnd(data + size) {}
+
+  const T* begin() const { return mBegin; }
+  const T* end() const { return mEnd; }
+  const T* data() const { return mBegin; }
+  std::size_t size() const { return static_cast<std::size_t>(mEnd - mBegin); }
+  bool empty() const { return mBegin == mEnd; }
+  const T& operator[](std::size_t index) const { return mBegin[index]; }
+};
@@ -0,0 +1,54 @@
+#include "tagdictionary.h"
+
+#include <utility>
+
+TagId TagDictionary::intern(std::string_view tag) {
+  auto found = mIds.find(tag);
+  if (found != mIds.end()) {
+    return found->second;
+  }
+  TagId id = static_cast<TagId>(mTags.size());
+  auto foldedFound = mFoldedLookup.find(tag);
+  if (foldedFound == mFoldedLookup.end()) {
+    std::uint32_t foldedId = static_cast<std::uint32_t>(mFoldedLookup.size());
+    foldedFound = mFoldedLookup.emplace(tag, foldedId).first;
+  }
+  mTags.push_back(tag);
+  mFoldedIds.push_back(foldedFound->second);
+  mIds.emplace(tag, id);
+  return id;
+}
+
+TagId TagDictionary::find(std::string_view tag) const {
+  auto found = mIds.find(tag);
+  return found == mIds.end() ? npos : found->second;
+}
+
+TagSet TagDictionary::makeTagSet(const TagId* ids, std::size_t count) {
+  TagSet tags;
+  tags.count = static_cast<std::uint32_t>(count);
+  if (count <= TagSet::kInlineTags) {
+    for (std::size_t i = 0; i < count; ++i) {
+      tags.ids[i] = ids[i];
+    }
+  } else {
+    tags.ids[0] = static_cast<std::uint32_t>(mOverflow.size());
+    mOverflow.insert(mOverflow.end(), ids, ids + count);
+  }
+  return tags;
+}
+
+const TagId* TagDictionary::getIds(const TagSet& tags) const {
+  return tags.count <= TagSet::kInlineTags
+             ? tags.ids
+             : mOverflow.data() + tags.ids[0];
+}
+
+std::uint32_t TagDictionary::findFolded(std::string_view tag) const {
+  auto found = mFoldedLookup.find(tag);
+  return found == mFoldedLookup.end() ? npos : found->second;
+}
+
+void TagDictionary::assignOverflow(std::vector<TagId>&& overflow) {
+  mOverflow = std::move(overflow);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "casefold.h"
+
+using TagId = std::uint32_t;
+
+/**
+ * The tag ids of one video. Up to kInlineTags ids are stored inline; longer
+ * lists live in the dictionary's overflow pool and ids[0] holds their offset.
+ */
+struct TagSet {
+  static constexpr std::uint32_t kInlineTags = 4;
+
+  std::uint32_t count = 0;
+  TagId ids[kInlineTags] = {};
+};
+
+/**
+ * A class used to intern the tags of a catalog. Every distinct spelling of a
+ * tag is stored once, as a view into the catalog, and given a dense TagId.
+ * Spellings that only differ in case share a folded id, so case-insensitive
+ * tag comparisons are integer compares.
+ */
+class TagDictionary {
+ private:
+  std::vector<std::string_view> mTags;
+  std::vector<std::uint32_t> mFoldedIds;
+  std::unordered_map<std::string_view, TagId> mIds;
+  // The first spelling of each folded tag, hashed and compared ignoring
+  // case, so lookups need no upper-cased copy.
+  std::unordered_map<std::string_view, std::uint32_t, FoldedHash, FoldedEqual>
+      mFoldedLookup;
+  std::vector<TagId> mOverflow;
+
+ public:
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+  TagDictionary() = default;
+
+  // This class is not copyable, videos point at it.
+  TagDictionary(const TagDictionary&) = delete;
+  TagDictionary& operator=(const TagDictionary&) = delete;
+
+  // Returns the id of tag, adding it if it is new. The tag's characters must
+  // outlive the dictionary.
+  TagId intern(std::string_view tag);
+
+  // Returns the id of tag, or npos if no video has it.
+  TagId find(std::string_view tag) const;
+
+  // Packs the given ids into a TagSet, spilling to the overflow pool if they
+  // do not fit inline.
+  TagSet makeTagSet(const TagId* ids, std::size_t count);
+
+  // Returns the ids held by a TagSet made by this dictionary.
+  const TagId* getIds(const TagSet& tags) const;
+
+  std::string_view getTag(TagId id) const { return mTags[id]; }
+  std::uint32_t getFoldedId(TagId id) const { return mFoldedIds[id]; }
+
+  // Returns the folded id of tag, matched case-insensitively, or npos.
+  std::uint32_t findFolded(std::string_view tag) const;
+
+  std::size_t size() const { return mTags.size(); }
+  std::size_t foldedSize() const { return mFoldedLookup.size(); }
+
+  // The overflow pool, so it can be written to and restored from a snapshot.
+  const std::vector<TagId>& getOverflow() const { return mOverflow; }
+  void assignOverflow(std::vector<TagId>&& overflow);
+};
@@ -0,0 +1,56 @@
+#include "tagindex.h"
+
+#include <utility>
+
+void TagIndex::build(const std::vector<Video>& videos,
+                     const TagDictionary& dictionary,
+                     Span<std::uint32_t> titleOrder) {
+  // A video listing the same tag twice (in any case) is posted once, so
+  // remember the last video posted for every tag.
+  const std::uint32_t none = UINT32_MAX;
+  std::vector<std::uint32_t> lastPosted(dictionary.foldedSize(), none);
+  std::vector<std::uint32_t> offsets(dictionary.foldedSize() + 1, 0);
+  for (std::uint32_t position : titleOrder) {
+    TagList tags = videos[position].getTags();
+    for (const TagId* id = tags.ids(); id != tags.ids() + tags.size(); ++id) {
+      std::uint32_t folded = dictionary.getFoldedId(*id);
+      if (lastPosted[folded] != position) {
+        lastPosted[folded] = position;
+        ++offsets[folded + 1];
+      }
+    }
+  }
+  for (std::size_t tag = 1; tag < offsets.size(); ++tag) {
+    offsets[tag] += offsets[tag - 1];
+  }
+
+  std::vector<std::uint32_t> next(offsets.begin(), offsets.end() - 1);
+  lastPosted.assign(dictionary.foldedSize(), none);
+  std::vector<std::uint32_t> postings(offsets.back());
+  for (std::uint32_t position : titleOrder) {
+    TagList tags = videos[position].getTags();
+    for (const TagId* id = tags.ids(); id != tags.ids() + tags.size(); ++id) {
+      std::uint32_t folded = dictionary.getFoldedId(*id);
+      if (lastPosted[folded] != position) {
+        lastPosted[folded] = position;
+        postings[next[folded]++] = position;
+      }
+    }
+  }
+  mOffsets.assign(std::move(offsets));
+  mPostings.assign(std::move(postings));
+}
+
+Span<std::uint32_t> TagIndex::find(std::uint32_t foldedId) const {
+  if (static_cast<std::size_t>(foldedId) + 1 >= mOffsets.size()) {
+    return Span<std::uint32_t>();
+  }
+  return Span<std::uint32_t>(mPostings.data() + mOffsets[foldedId],
+                             mPostings.data() + mOffsets[foldedId + 1]);
+}
+
+void TagIndex::assign(Span<std::uint32_t> offsets,
+                      Span<std::uint32_t> postings) {
+  mOffsets.assign(offsets);
+  mPostings.assign(postings);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "span.h"
+#include "tagdictionary.h"
+#include "video.h"
+#include "wordarray.h"
+
+/**
+ * A class used to find the videos with a given tag. For every folded tag id
+ * it holds a posting list of video positions in title order, so a tag query
+ * only touches the videos that have the tag and needs no sorting. The lists
+ * are stored back to back, with mOffsets[tag] marking where each one starts.
+ */
+class TagIndex {
+ private:
+  WordArray mOffsets;
+  WordArray mPostings;
+
+ public:
+  // Indexes videos, visiting them in the given title order.
+  void build(const std::vector<Video>& videos,
+             const TagDictionary& dictionary,
+             Span<std::uint32_t> titleOrder);
+
+  // Returns the positions of the videos with the given folded tag id, in
+  // title order.
+  Span<std::uint32_t> find(std::uint32_t foldedId) const;
+
+  // The raw lists, so they can be written to and restored from a snapshot.
+  Span<std::uint32_t> offsets() const { return mOffsets.span(); }
+  Span<std::uint32_t> postings() const { return mPostings.span(); }
+  // Uses lists stored in a snapshot in place; they must outlive the index.
+  void assign(Span<std::uint32_t> offsets, Span<std::uint32_t> postings);
+};
@@ -0,0 +1,148 @@
+#include "titleindex.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "casefold.h"
+
+namespace {
+
+std::uint32_t trigramAt(std::string_view folded, std::size_t pos) {
+  return static_cast<std::uint32_t>(static_cast<unsigned char>(folded[pos]))
+             << 16 |
+         static_cast<std::uint32_t>(static_cast<unsigned char>(folded[pos + 1]))
+             << 8 |
+         static_cast<std::uint32_t>(static_cast<unsigned char>(folded[pos + 2]));
+}
+
+}  // namespace
+
+void TitleIndex::build(const std::vector<Video>& videos,
+                       Span<std::uint32_t> titleOrder) {
+  // Two passes over the titles, in rank order: the first counts the titles
+  // holding each trigram, the second writes the ranks straight into place,
+  // so each posting list comes out ascending. Both tables are indexed by the
+  // trigram itself; calloc hands them out as untouched zero pages, so only
+  // the pages of trigrams that occur are ever backed by memory.
+  const std::size_t kTrigramSpace = std::size_t(1) << 24;
+  std::unique_ptr<std::uint32_t, decltype(&std::free)> counts(
+      static_cast<std::uint32_t*>(
+          std::calloc(kTrigramSpace, sizeof(std::uint32_t))),
+      &std::free);
+  // The last title to hold each trigram, so a title repeating one counts
+  // once: rank + 1 in the first pass, rank + 1 + titleCount in the second.
+  std::unique_ptr<std::uint32_t, decltype(&std::free)> lastSeen(
+      static_cast<std::uint32_t*>(
+          std::calloc(kTrigramSpace, sizeof(std::uint32_t))),
+      &std::free);
+  if (!counts || !lastSeen) {
+    throw std::bad_alloc();
+  }
+  const std::uint32_t titleCount =
+      static_cast<std::uint32_t>(titleOrder.size());
+  auto forEachTrigram = [&](auto&& visit) {
+    for (std::uint32_t rank = 0; rank < titleCount; ++rank) {
+      std::string_view title = videos[titleOrder[rank]].getTitle();
+      std::uint32_t gram = 0;
+      for (std::size_t pos = 0; pos < title.size(); ++pos) {
+        gram = (gram << 8 |
+                static_cast<unsigned char>(foldChar(title[pos]))) &
+               0xFFFFFF;
+        if (pos + 1 >= kGramSize) {
+          visit(gram, rank);
+        }
+      }
+    }
+  };
+
+  std::uint32_t* count = counts.get();
+  std::uint32_t* seen = lastSeen.get();
+  std::vector<std::uint32_t> trigrams;
+  forEachTrigram([&trigrams, count, seen](std::uint32_t gram,
+                                          std::uint32_t rank) {
+    if (seen[gram] != rank + 1) {
+      seen[gram] = rank + 1;
+      if (count[gram]++ == 0) {
+        trigrams.push_back(gram);
+      }
+    }
+  });
+  std::sort(trigrams.begin(), trigrams.end());
+
+  // Turn the counts into the start of each list, which the second pass uses
+  // as a write cursor.
+  std::vector<std::uint32_t> offsets;
+  offsets.reserve(trigrams.size() + 1);
+  std::uint32_t total = 0;
+  for (std::uint32_t gram : trigrams) {
+    offsets.push_back(total);
+    std::uint32_t listSize = count[gram];
+    count[gram] = total;
+    total += listSize;
+  }
+  offsets.push_back(total);
+
+  std::vector<std::uint32_t> postingList(total, 0);
+  std::uint32_t* postings = postingList.data();
+  forEachTrigram([count, seen, postings, titleCount](std::uint32_t gram,
+                                                     std::uint32_t rank) {
+    if (seen[gram] != rank + 1 + titleCount) {
+      seen[gram] = rank + 1 + titleCount;
+      postings[count[gram]++] = rank;
+    }
+  });
+  mTrigrams.assign(std::move(trigrams));
+  mOffsets.assign(std::move(offsets));
+  mPostings.assign(std::move(postingList));
+}
+
+std::vector<std::uint32_t> TitleIndex::candidates(
+    std::string_view foldedTerm) const {
+  std::vector<std::uint32_t> grams;
+  for (std::size_t pos = 0; pos + kGramSize <= foldedTerm.size(); ++pos) {
+    grams.push_back(trigramAt(foldedTerm, pos));
+  }
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+  // Find every posting list; a trigram no title has rules everything out.
+  std::vector<std::pair<const std::uint32_t*, const std::uint32_t*>> lists;
+  for (std::uint32_t gram : grams) {
+    auto found = std::lower_bound(mTrigrams.begin(), mTrigrams.end(), gram);
+    if (found == mTrigrams.end() || *found != gram) {
+      return {};
+    }
+    std::size_t index = static_cast<std::size_t>(found - mTrigrams.begin());
+    lists.emplace_back(mPostings.data() + mOffsets[index],
+                       mPostings.data() + mOffsets[index + 1]);
+  }
+  if (lists.empty()) {
+    return {};
+  }
+  // Intersect starting from the shortest list, so the running result is as
+  // small as possible.
+  std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) {
+    return a.second - a.first < b.second - b.first;
+  });
+  std::vector<std::uint32_t> result(lists.front().first, lists.front().second);
+  std::vector<std::uint32_t> next;
+  for (std::size_t list = 1; list < lists.size() && !result.empty(); ++list) {
+    next.clear();
+    std::set_intersection(result.begin(), result.end(), lists[list].first,
+                          lists[list].second, std::back_inserter(next));
+    result.swap(next);
+  }
+  return result;
+}
+
+void TitleIndex::assign(Span<std::uint32_t> trigrams,
+                        Span<std::uint32_t> offsets,
+                        Span<std::uint32_t> postings) {
+  mTrigrams.assign(trigrams);
+  mOffsets.assign(offsets);
+  mPostings.assign(postings);
+}
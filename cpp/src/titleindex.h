@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "span.h"
+#include "video.h"
+#include "wordarray.h"
+
+/**
+ * A class used to find the videos whose title contains a search term. Every
+ * case-folded title is broken into trigrams (runs of three characters); for
+ * each distinct trigram the index holds a posting list of title ranks
+ * (positions in the catalog's title order). A term of three or more
+ * characters can then only occur in titles that appear in the posting list
+ * of every one of its trigrams, and the candidates come out in title order.
+ */
+class TitleIndex {
+ private:
+  // The distinct trigrams, sorted, with mOffsets[i] marking where the posting
+  // list of mTrigrams[i] starts in mPostings.
+  WordArray mTrigrams;
+  WordArray mOffsets;
+  WordArray mPostings;
+
+ public:
+  // The shortest term the index can filter; shorter terms match everything.
+  static constexpr std::size_t kGramSize = 3;
+
+  // Indexes the titles of videos, ranked by titleOrder.
+  void build(const std::vector<Video>& videos,
+             Span<std::uint32_t> titleOrder);
+
+  // Returns the ranks, in ascending order, of the titles that contain every
+  // trigram of foldedTerm. The term must be upper-cased and at least
+  // kGramSize long; candidates still need to be verified.
+  std::vector<std::uint32_t> candidates(std::string_view foldedTerm) const;
+
+  // The raw lists, so they can be written to and restored from a snapshot.
+  Span<std::uint32_t> trigrams() const { return mTrigrams.span(); }
+  Span<std::uint32_t> offsets() const { return mOffsets.span(); }
+  Span<std::uint32_t> postings() const { return mPostings.span(); }
+  // Uses lists stored in a snapshot in place; they must outlive the index.
+  void assign(Span<std::uint32_t> trigrams, Span<std::uint32_t> offsets,
+              Span<std::uint32_t> postings);
+};
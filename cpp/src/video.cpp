@@ -1,18 +1,23 @@
 #include "video.h"
 
-#include <iostream>
-#include <utility>
-#include <vector>
-
-Video::Video(std::string&& title, std::string&& videoId,
-             std::vector<std::string>&& tags) :
-  mTitle(std::move(title)),
-  mVideoId(std::move(videoId)),
-  mTags(std::move(tags)) {
+bool TagList::containsFolded(std::uint32_t foldedId) const {
+  for (std::size_t i = 0; i < mCount; ++i) {
+    if (mDictionary->getFoldedId(mIds[i]) == foldedId) {
+      return true;
+    }
+  }
+  return false;
 }
 
-const std::string& Video::getTitle() const { return mTitle; }
+Video::Video(std::string_view title, std::string_view videoId,
+             const TagDictionary* tagDictionary, const TagSet& tags)
+    : mTitle(title),
+      mVideoId(videoId),
+      mTagDictionary(tagDictionary),
+      mTags(tags) {}
+
+std::string_view Video::getTitle() const { return mTitle; }
 
-const std::string& Video::getVideoId() const { return mVideoId; }
+std::string_view Video::getVideoId() const { return mVideoId; }
 
-const std::vector<std::string>& Video::getTags() const { return mTags; }
+TagList Video::getTags() const { return TagList(mTagDictionary, mTags); }
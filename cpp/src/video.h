@@ -1,29 +1,112 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "tagdictionary.h"
+
+// A dense id for a video: its position in the catalog it was loaded from.
+// The library, playlists, flags and player hold handles rather than id
+// strings, so an id is looked up once per command. Handles belong to one
+// catalog; VideoLibrary remaps the ones it holds when a reload swaps in
+// another.
+using VideoHandle = std::uint32_t;
+constexpr VideoHandle kNoVideo = UINT32_MAX;
 
 /**
- * A class used to represent a video.
+ * A class used to represent the tags of a video: a view of its interned tag
+ * ids that reads back the tags as they were spelled in the catalog.
+ */
+class TagList {
+ private:
+  const TagDictionary* mDictionary = nullptr;
+  const TagId* mIds = nullptr;
+  std::size_t mCount = 0;
+
+ public:
+  class const_iterator {
+   private:
+    const TagDictionary* mDictionary;
+    const TagId* mId;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    const_iterator(const TagDictionary* dictionary, const TagId* id)
+        : mDictionary(dictionary), mId(id) {}
+
+    std::string_view operator*() const { return mDictionary->getTag(*mId); }
+    const_iterator& operator++() {
+      ++mId;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator previous = *this;
+      ++mId;
+      return previous;
+    }
+    bool operator==(const const_iterator& other) const {
+      return mId == other.mId;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return mId != other.mId;
+    }
+  };
+
+  TagList() = default;
+  TagList(const TagDictionary* dictionary, const TagSet& tags)
+      : mDictionary(dictionary),
+        mIds(dictionary ? dictionary->getIds(tags) : nullptr),
+        mCount(tags.count) {}
+
+  const_iterator begin() const { return const_iterator(mDictionary, mIds); }
+  const_iterator end() const {
+    return const_iterator(mDictionary, mIds + mCount);
+  }
+  bool empty() const { return mCount == 0; }
+  std::size_t size() const { return mCount; }
+
+  // Returns the interned ids of the tags.
+  const TagId* ids() const { return mIds; }
+
+  // Returns whether any tag has the given folded id, i.e. matches it
+  // case-insensitively.
+  bool containsFolded(std::uint32_t foldedId) const;
+};
+
+/**
+ * A class used to represent a video. The title and id are views into the
+ * catalog the video was loaded from and the tags are ids in its tag
+ * dictionary; the catalog must outlive the video.
  */
 class Video {
  private:
-  std::string mTitle;
-  std::string mVideoId;
-  std::vector<std::string> mTags;
+  std::string_view mTitle;
+  std::string_view mVideoId;
+  const TagDictionary* mTagDictionary;
+  TagSet mTags;
 
  public:
-  Video(std::string&& title, std::string&& videoId,
-        std::vector<std::string>&& tags);
+  Video(std::string_view title, std::string_view videoId,
+        const TagDictionary* tagDictionary, const TagSet& tags);
 
   bool operator==(const Video& a) { return mVideoId.compare(a.getVideoId()); }
 
   // Returns the title of the video.
-  const std::string& getTitle() const;
+  std::string_view getTitle() const;
 
   // Returns the video id of the video.
-  const std::string& getVideoId() const;
+  std::string_view getVideoId() const;
 
   // Returns a readonly collection of the tags of the video.
-  const std::vector<std::string>& getTags() const;
+  TagList getTags() const;
+
+  // Returns the interned tags of the video.
+  const TagSet& getTagSet() const { return mTags; }
 };
@@ -0,0 +1,78 @@
+#include "videoindex.h"
+
+#include <utility>
+
+namespace {
+
+std::size_t slotCountFor(std::size_t count) {
+  // Keep the load factor at or below one half.
+  std::size_t slots = 16;
+  while (slots < count * 2) {
+    slots *= 2;
+  }
+  return slots;
+}
+
+}  // namespace
+
+// 64-bit FNV-1a.
+std::uint64_t VideoIndex::hash(std::string_view videoId) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : videoId) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::size_t VideoIndex::findSlot(std::string_view videoId,
+                                 const std::vector<Video>& videos) const {
+  std::size_t mask = mSlots.size() - 1;
+  std::size_t slot = static_cast<std::size_t>(hash(videoId)) & mask;
+  while (mSlots[slot] != 0 &&
+         videos[mSlots[slot] - 1].getVideoId() != videoId) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void VideoIndex::rehash(std::size_t slotCount,
+                        const std::vector<Video>& videos) {
+  WordArray old = std::move(mSlots);
+  mSlots.assign(std::vector<std::uint32_t>(slotCount, 0));
+  for (std::uint32_t entry : old) {
+    if (entry != 0) {
+      mSlots.set(findSlot(videos[entry - 1].getVideoId(), videos), entry);
+    }
+  }
+}
+
+void VideoIndex::reserve(std::size_t count, const std::vector<Video>& videos) {
+  std::size_t slots = slotCountFor(count);
+  if (slots > mSlots.size()) {
+    rehash(slots, videos);
+  }
+}
+
+std::uint32_t VideoIndex::find(std::string_view videoId,
+                               const std::vector<Video>& videos) const {
+  if (mSlots.empty()) {
+    return npos;
+  }
+  std::uint32_t entry = mSlots[findSlot(videoId, videos)];
+  return entry == 0 ? npos : entry - 1;
+}
+
+void VideoIndex::insert(std::uint32_t position,
+                        const std::vector<Video>& videos) {
+  if (mSlots.size() < slotCountFor(mCount + 1)) {
+    rehash(slotCountFor(mCount + 1), videos);
+  }
+  mSlots.set(findSlot(videos[position].getVideoId(), videos), position + 1);
+  ++mCount;
+}
+
+void VideoIndex::assign(Span<std::uint32_t> slots, std::size_t count) {
+  mSlots.assign(slots);
+  mCount = count;
+}
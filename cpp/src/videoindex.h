@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "span.h"
+#include "video.h"
+#include "wordarray.h"
+
+/**
+ * A class used to look videos up by id. It is an open-addressing hash table of
+ * positions into the library's video vector, so inserting a video does not
+ * allocate once the index has been reserved for the size of the catalog.
+ */
+class VideoIndex {
+ private:
+  // Each slot holds a position into the video vector plus one; zero is empty.
+  WordArray mSlots;
+  std::size_t mCount = 0;
+
+  std::size_t findSlot(std::string_view videoId,
+                       const std::vector<Video>& videos) const;
+  void rehash(std::size_t slotCount, const std::vector<Video>& videos);
+
+ public:
+  static constexpr std::uint32_t npos = UINT32_MAX;
+
+  // Sizes the table so that count videos can be inserted without rehashing.
+  void reserve(std::size_t count, const std::vector<Video>& videos);
+
+  // Returns the position of the video with the given id, or npos.
+  std::uint32_t find(std::string_view videoId,
+                     const std::vector<Video>& videos) const;
+
+  // Indexes videos[position]. The id must not already be indexed.
+  void insert(std::uint32_t position, const std::vector<Video>& videos);
+
+  std::size_t size() const { return mCount; }
+
+  // The raw slot table, so it can be written to and restored from a snapshot.
+  // The hash is stable across platforms and builds for that reason.
+  Span<std::uint32_t> slots() const { return mSlots.span(); }
+  // Looks ids up in a slot table stored in a snapshot, in place; the table
+  // must outlive the index, and nothing more may be inserted.
+  void assign(Span<std::uint32_t> slots, std::size_t count);
+
+  // Returns the hash used to place a video id in the table.
+  static std::uint64_t hash(std::string_view videoId);
+};
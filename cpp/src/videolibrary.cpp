@@ -1,112 +1,585 @@
 #include "videolibrary.h"
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <cstdlib>
+#include <filesystem>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "helper.h"
+#include "snapshot.h"
 #include "video.h"
 
-VideoLibrary::VideoLibrary() {
-  std::ifstream file("./src/videos.txt");
-  if (file.is_open()) {
-    std::string line;
-    while (std::getline(file, line)) {
-      std::stringstream linestream(line);
-      std::string title;
-      std::string id;
-      std::string tag;
-      std::vector<std::string> tags;
-      std::getline(linestream, title, '|');
-      std::getline(linestream, id, '|');
-      while (std::getline(linestream, tag, ',')) {
-        tags.emplace_back(trim(std::move(tag)));
+VideoLibrary::VideoLibrary() : VideoLibrary(defaultCatalogPath()) {}
+
+VideoLibrary::VideoLibrary(const std::string& catalogPath,
+                           unsigned parserThreads)
+    : VideoLibrary(
+          std::make_shared<const Catalog>(catalogPath, parserThreads)) {
+  setReloader(
+      std::make_shared<CatalogReloader>(catalogPath, "", parserThreads));
+}
+
+VideoLibrary::VideoLibrary(std::shared_ptr<const Catalog> catalog)
+    : mCatalog(std::move(catalog)), mFlags(mCatalog->getVideos().size()) {
+  mPlaylistShards.push_back(std::make_unique<PlaylistShard>());
+}
+
+void VideoLibrary::setReloader(std::shared_ptr<CatalogReloader> reloader) {
+  mReloader = std::move(reloader);
+  mGeneration = mCatalog->isOpen() ? mReloader->setCurrent(mCatalog)
+                                   : mReloader->generation();
+}
+
+VideoLibrary VideoLibrary::shareCatalog() const {
+  // The reloader already serves this catalog, or a newer one both libraries
+  // will move to.
+  VideoLibrary library(mCatalog);
+  library.mReloader = mReloader;
+  library.mGeneration = mGeneration;
+  return library;
+}
+
+std::optional<VideoLibrary> VideoLibrary::fromSnapshot(
+    const std::string& snapshotPath) {
+  MappedFile file(snapshotPath);
+  SnapshotView snapshot;
+  if (!file.isOpen() || !snapshot.open(file.contents())) {
+    return std::nullopt;
+  }
+  // The view stays valid once the catalog owns the file, the mapping itself
+  // does not move.
+  VideoLibrary library(
+      std::make_shared<const Catalog>(std::move(file), snapshot));
+  library.setReloader(std::make_shared<CatalogReloader>("", snapshotPath, 0));
+  // Flags and playlists are saved by id; entries for ids the catalog does
+  // not have are dropped.
+  for (std::size_t i = 0; i < snapshot.flagCount(); ++i) {
+    auto flag = snapshot.flag(i);
+    VideoHandle video = library.findVideo(flag.first);
+    if (video != kNoVideo) {
+      library.addFlag(video, std::string(flag.second));
+    }
+  }
+  for (std::size_t i = 0; i < snapshot.playlistCount(); ++i) {
+    VideoPlaylist* playlist =
+        library.createPlaylist(snapshot.playlistName(i));
+    for (std::string_view videoId : snapshot.playlistEntries(i)) {
+      VideoHandle video = library.findVideo(videoId);
+      if (video != kNoVideo) {
+        playlist->addVideo(video);
       }
-      Video video = Video(trim(std::move(title)), trim(id), std::move(tags));
-      mVideos.emplace(trim(std::move(id)), std::move(video));
     }
-  } else {
-    std::cout << "Couldn't find videos.txt" << std::endl;
   }
+  return library;
 }
 
-std::vector<Video> VideoLibrary::getVideos() const {
-  std::vector<Video> result;
-  for (const auto& video : mVideos) {
-    result.emplace_back(video.second);
+VideoLibrary VideoLibrary::open(const std::string& catalogPath,
+                                const std::string& snapshotPath) {
+  if (snapshotIsFresh(snapshotPath, catalogPath)) {
+    if (auto library = fromSnapshot(snapshotPath)) {
+      library->setReloader(
+          std::make_shared<CatalogReloader>(catalogPath, snapshotPath, 0));
+      return std::move(*library);
+    }
   }
-  return result;
+  VideoLibrary library(catalogPath);
+  library.setReloader(
+      std::make_shared<CatalogReloader>(catalogPath, snapshotPath, 0));
+  return library;
 }
 
-const Video* VideoLibrary::getVideo(const std::string& videoId) const {
-  const auto found = mVideos.find(videoId);
-  if (found == mVideos.end()) {
-    // std::cout << "Video not found in video library" << std::endl;
+std::string VideoLibrary::defaultCatalogPath() {
+  const char* path = std::getenv("YOUTUBE_CATALOG");
+  return path && *path ? path : "./src/videos.txt";
+}
+
+std::string VideoLibrary::snapshotPathFor(const std::string& catalogPath) {
+  return std::filesystem::path(catalogPath)
+      .replace_extension(".snapshot")
+      .string();
+}
+
+bool VideoLibrary::saveSnapshot(const std::string& snapshotPath) const {
+  SnapshotContents contents;
+  contents.catalog = mCatalog.get();
+  for (VideoHandle video : getFlaggedVideos()) {
+    contents.flags.emplace_back(getVideoAt(video).getVideoId(),
+                                *getFlag(video));
+  }
+  forEachPlaylist([&](const VideoPlaylist& playlist) {
+    std::vector<std::string_view> videoIds;
+    playlist.forEachVideo([&](VideoHandle video) {
+      videoIds.push_back(getVideoAt(video).getVideoId());
+    });
+    contents.playlists.emplace_back(playlist.getPlaylistId(),
+                                    std::move(videoIds));
+  });
+  return writeSnapshot(snapshotPath, contents);
+}
+
+bool VideoLibrary::beginReload() { return mReloader->request(); }
+
+std::shared_ptr<const Catalog> VideoLibrary::adoptCurrentCatalog(
+    ReloadReport& result) {
+  std::uint64_t generation = 0;
+  std::shared_ptr<const Catalog> catalog =
+      mReloader->current(&generation, &result.loadTime);
+  if (generation == mGeneration) {
     return nullptr;
+  }
+  result.loaded = true;
+  result.videoCount = catalog->getVideos().size();
+  // Handles are positions in one catalog, so look each one up again by id
+  // in the new catalog.
+  auto remap = [&](VideoHandle video) {
+    return catalog->findVideo(mCatalog->getVideos()[video].getVideoId());
+  };
+  if (mConcurrentFlags) {
+    auto flags =
+        std::make_unique<ConcurrentFlagStore>(catalog->getVideos().size());
+    mConcurrentFlags->forEachFlag(
+        [&](VideoHandle video, const std::string& reason) {
+          VideoHandle moved = remap(video);
+          if (moved == kNoVideo) {
+            ++result.droppedFlags;
+          } else {
+            flags->flag(moved, reason);
+          }
+        });
+    mConcurrentFlags = std::move(flags);
   } else {
-    return &(found->second);
+    mFlags = mFlags.remapped(catalog->getVideos().size(), remap,
+                             &result.droppedFlags);
   }
+  for (auto& shard : mPlaylistShards) {
+    for (auto& playlist : shard->playlists) {
+      result.droppedPlaylistEntries += playlist.second.remapVideos(remap);
+    }
+  }
+  catalog.swap(mCatalog);
+  mGeneration = generation;
+  return catalog;
 }
 
-std::vector<VideoPlaylist> VideoLibrary::getPlaylists() {
-  std::vector<VideoPlaylist> result;
-  for (const auto &playlist : mPlaylists) {
-    result.emplace_back(playlist.second);
+bool VideoLibrary::applyReload(ReloadReport* report) {
+  if (mGate) {
+    bool reloaded = enterCommand(report);
+    leaveCommand();
+    return reloaded;
   }
-  return result;
+  ReloadReport result;
+  std::shared_ptr<const Catalog> pending =
+      mReloader->takePending(&result.loadTime);
+  // Another library sharing the reloader may have taken the new catalog.
+  if (!pending && mReloader->generation() == mGeneration) {
+    return false;
+  }
+  pending.reset();
+  auto start = std::chrono::steady_clock::now();
+  std::shared_ptr<const Catalog> previous = adoptCurrentCatalog(result);
+  result.swapTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  // Release the old catalog outside of the swap: the last reference may
+  // have to unmap a large file.
+  previous.reset();
+  if (report) {
+    *report = result;
+  }
+  return true;
 }
 
-VideoPlaylist *VideoLibrary::getPlaylist(const std::string &playlistId) {
-  auto found = mPlaylists.find(stringToUpper(playlistId));
-  if (found == mPlaylists.end()) {
-    // std::cout << "Video not found in video library" << std::endl;
-    return nullptr;
-  } else {
-    return &(found->second);
+bool VideoLibrary::enterCommand(ReloadReport* report) {
+  if (!mGate) {
+    return applyReload(report);
+  }
+  // Only one thread takes a finished reload, but every thread sees the
+  // generation move; mGeneration is only read inside the gate.
+  ReloadReport result;
+  bool tookPending =
+      mReloader->takePending(&result.loadTime) != nullptr;
+  mGate->enter();
+  if (!tookPending && mReloader->generation() == mGeneration) {
+    EpochReclaimer::global().pin();
+    return false;
+  }
+  mGate->leave();
+  auto start = std::chrono::steady_clock::now();
+  mGate->lockExclusive();
+  std::shared_ptr<const Catalog> previous = adoptCurrentCatalog(result);
+  mGate->unlockExclusive();
+  result.swapTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  bool adopted = previous != nullptr;
+  previous.reset();
+  mGate->enter();
+  // Reasons read during the command stay valid until leaveCommand.
+  EpochReclaimer::global().pin();
+  // Another thread may have swapped the catalog in first, and reported it.
+  if (!tookPending && !adopted) {
+    return false;
   }
+  if (report) {
+    *report = result;
+  }
+  return true;
 }
 
-VideoPlaylist *VideoLibrary::createPlaylist(const std::string &playlistId) {
-  if (getPlaylist(playlistId)) {
-    return nullptr;
-  } else {
-    VideoPlaylist playlist = VideoPlaylist(playlistId);
-    mPlaylists.emplace(std::piecewise_construct,
-                       std::forward_as_tuple(stringToUpper(playlistId)),
-                       std::forward_as_tuple(playlistId));
-    return getPlaylist(stringToUpper(playlistId));
+bool VideoLibrary::leaveCommand() {
+  if (mGate) {
+    EpochReclaimer::global().unpin();
+    mGate->leave();
+  }
+  // Wait for the disk outside the gate, so a slow fsync never holds up a
+  // reload. Sessions finishing commands meanwhile share this fsync.
+  if (!mLog) {
+    return true;
+  }
+  if (!mLog->sync()) {
+    return false;
+  }
+  if (mLog->shouldCompact()) {
+    compactLog(true);
   }
+  return true;
 }
 
-void VideoLibrary::deletePlaylist(VideoPlaylist playlist) {
-  mPlaylists.erase(playlist.getPlaylistId());
+bool VideoLibrary::openLog(const std::string& path, std::uint64_t* replayed) {
+  auto log = MutationLog::open(
+      path, [this](const Mutation& mutation) { replay(mutation); }, replayed);
+  if (!log) {
+    return false;
+  }
+  mLog = std::move(log);
+  return true;
 }
 
-const std::string *VideoLibrary::getFlag(const std::string &videoId) {
-  auto found = mFlags.find(videoId);
-  if (found == mFlags.end()) {
-    return nullptr;
-  } else {
-    return &(found->second);
+bool VideoLibrary::syncLog() { return mLog && mLog->sync(); }
+
+bool VideoLibrary::compactLog(bool onlyIfDue) {
+  if (!mLog) {
+    return false;
   }
+  if (mGate) {
+    mGate->lockExclusive();
+  }
+  bool compacted = false;
+  if (!onlyIfDue || mLog->shouldCompact()) {
+    compacted = mLog->sync() && mLog->compact(logState());
+  }
+  if (mGate) {
+    mGate->unlockExclusive();
+  }
+  return compacted;
 }
 
-void VideoLibrary::addFlag(const std::string &videoId,
-                           const std::string &reason) {
-  mFlags.emplace(videoId, reason);
+std::string VideoLibrary::logState() const {
+  std::string state;
+  for (VideoHandle video : getFlaggedVideos()) {
+    MutationLog::encode(state, {MutationType::Flag,
+                                getVideoAt(video).getVideoId(),
+                                *getFlag(video)});
+  }
+  forEachPlaylist([&](const VideoPlaylist& playlist) {
+    std::string_view name = playlist.getPlaylistId();
+    MutationLog::encode(state, {MutationType::CreatePlaylist, name, {}});
+    playlist.forEachVideo([&](VideoHandle video) {
+      MutationLog::encode(state, {MutationType::AddToPlaylist, name,
+                                  getVideoAt(video).getVideoId()});
+    });
+  });
+  return state;
 }
 
-void VideoLibrary::deleteFlag(const std::string &videoId) {
-  mFlags.erase(videoId);
+void VideoLibrary::replay(const Mutation& mutation) {
+  switch (mutation.type) {
+    case MutationType::CreatePlaylist:
+      createPlaylist(mutation.first);
+      break;
+    case MutationType::DeletePlaylist:
+      deletePlaylist(mutation.first);
+      break;
+    case MutationType::AddToPlaylist:
+    case MutationType::RemoveFromPlaylist: {
+      VideoHandle video = findVideo(mutation.second);
+      if (video == kNoVideo) {
+        break;
+      }
+      withPlaylist(mutation.first, [&](VideoPlaylist& playlist) {
+        if (mutation.type == MutationType::AddToPlaylist) {
+          playlist.addVideo(video);
+        } else {
+          playlist.removeVideo(video);
+        }
+      });
+      break;
+    }
+    case MutationType::ClearPlaylist:
+      withPlaylist(mutation.first,
+                   [](VideoPlaylist& playlist) { playlist.clearPlaylist(); });
+      break;
+    case MutationType::Flag:
+    case MutationType::Allow: {
+      VideoHandle video = findVideo(mutation.first);
+      if (video == kNoVideo) {
+        break;
+      }
+      if (mutation.type == MutationType::Flag) {
+        addFlag(video, mutation.second);
+      } else {
+        deleteFlag(video);
+      }
+      break;
+    }
+  }
 }
 
-std::vector<std::string> VideoLibrary::getFlaggedVideoIds() {
-  std::vector<std::string> result;
-  for (const auto &flag : mFlags) {
-    result.emplace_back(flag.first);
+void VideoLibrary::enableConcurrency(std::size_t shardCount) {
+  if (mGate) {
+    return;
+  }
+  unsigned bits = 0;
+  while ((std::size_t{1} << bits) < shardCount) {
+    ++bits;
+  }
+  std::vector<std::unique_ptr<PlaylistShard>> shards;
+  for (std::size_t shard = 0; shard < (std::size_t{1} << bits); ++shard) {
+    shards.push_back(std::make_unique<PlaylistShard>());
+  }
+  mPlaylistShardBits = bits;
+  std::swap(shards, mPlaylistShards);
+  for (auto& shard : shards) {
+    for (auto& playlist : shard->playlists) {
+      PlaylistShard& target = playlistShard(playlist.first);
+      target.playlists.emplace(playlist.first, std::move(playlist.second));
+    }
+  }
+
+  mConcurrentFlags = std::make_unique<ConcurrentFlagStore>(size());
+  for (VideoHandle video : mFlags.flaggedVideos()) {
+    mConcurrentFlags->flag(video, *mFlags.reason(video));
   }
+  mFlags = FlagStore();
+  mGate = std::make_unique<CommandGate>();
+}
+
+void VideoLibrary::waitForReload() { mReloader->wait(); }
+
+bool VideoLibrary::watchCatalog() {
+  std::shared_ptr<CatalogReloader> reloader = mReloader;
+  auto watcher = std::make_unique<CatalogWatcher>(
+      [reloader] { reloader->request(); });
+  std::vector<std::string> paths;
+  for (const std::string* path :
+       {&mReloader->getCatalogPath(), &mReloader->getSnapshotPath()}) {
+    if (!path->empty()) {
+      paths.push_back(*path);
+    }
+  }
+  if (!watcher->start(paths)) {
+    return false;
+  }
+  mWatcher = std::move(watcher);
+  return true;
+}
+
+std::vector<Video> VideoLibrary::getVideos() const {
+  return mCatalog->getVideos();
+}
+
+Span<Video> VideoLibrary::videos() const {
+  const std::vector<Video> &videos = mCatalog->getVideos();
+  return Span<Video>(videos.data(), videos.size());
+}
+
+const Video* VideoLibrary::getVideo(std::string_view videoId) const {
+  return mCatalog->getVideo(videoId);
+}
+
+VideoHandle VideoLibrary::findVideo(std::string_view videoId) const {
+  return mCatalog->findVideo(videoId);
+}
+
+std::uint32_t VideoLibrary::findTag(std::string_view tag) const {
+  return mCatalog->getTagDictionary().findFolded(tag);
+}
+
+Span<std::uint32_t> VideoLibrary::findVideosWithTag(
+    std::string_view tag) const {
+  return mCatalog->getTagIndex().find(findTag(tag));
+}
+
+std::vector<std::uint32_t> VideoLibrary::searchTitles(
+    std::string_view searchTerm, bool *complete,
+    std::uint64_t stepBudget) const {
+  return mCatalog->searchTitles(searchTerm, complete, stepBudget);
+}
+
+Span<std::uint32_t> VideoLibrary::getTitleOrder() const {
+  return mCatalog->getTitleOrder();
+}
+
+const Video &VideoLibrary::getVideoAt(VideoHandle video) const {
+  return mCatalog->getVideos()[video];
+}
+
+std::vector<VideoPlaylist> VideoLibrary::getPlaylists() {
+  std::vector<VideoPlaylist> result;
+  auto locks = lockAllPlaylists();
+  forEachPlaylist([&](const VideoPlaylist &playlist) {
+    result.emplace_back(playlist);
+  });
   return result;
-}
\ No newline at end of file
+}
+
+std::size_t VideoLibrary::playlistCount() const {
+  std::size_t count = 0;
+  for (const auto &shard : mPlaylistShards) {
+    count += shard->playlists.size();
+  }
+  return count;
+}
+
+std::vector<std::unique_lock<std::mutex>> VideoLibrary::lockAllPlaylists()
+    const {
+  std::vector<std::unique_lock<std::mutex>> locks;
+  if (mGate) {
+    locks.reserve(mPlaylistShards.size());
+    for (const auto &shard : mPlaylistShards) {
+      locks.emplace_back(shard->mutex);
+    }
+  }
+  return locks;
+}
+
+VideoLibrary::PlaylistShard &VideoLibrary::playlistShard(
+    std::string_view playlistId) const {
+  if (mPlaylistShardBits == 0) {
+    return *mPlaylistShards.front();
+  }
+  // Take the top bits of a Fibonacci hash, so the shard does not depend on
+  // the same low bits the shard's own table buckets by.
+  std::uint64_t hash = static_cast<std::uint64_t>(hashFolded(playlistId)) *
+                       0x9E3779B97F4A7C15ull;
+  return *mPlaylistShards[hash >> (64 - mPlaylistShardBits)];
+}
+
+VideoPlaylist *VideoLibrary::getPlaylist(std::string_view playlistId) {
+  VideoPlaylist *result = nullptr;
+  withPlaylist(playlistId,
+               [&](VideoPlaylist &playlist) { result = &playlist; });
+  return result;
+}
+
+VideoPlaylist *VideoLibrary::createPlaylist(std::string_view playlistId) {
+  // Look the name up through the shard's key buffer, so refusing an
+  // existing playlist allocates nothing; the owned strings are only made
+  // for a new one.
+  PlaylistShard &shard = playlistShard(playlistId);
+  auto lock = lockShard(shard);
+  shard.key.assign(playlistId);
+  VideoPlaylist *created = nullptr;
+  logged({MutationType::CreatePlaylist, playlistId, {}}, [&] {
+    if (shard.playlists.find(shard.key) != shard.playlists.end()) {
+      return false;
+    }
+    created = &shard.playlists.try_emplace(shard.key, shard.key).first->second;
+    return true;
+  });
+  return created;
+}
+
+bool VideoLibrary::deletePlaylist(std::string_view playlistId) {
+  PlaylistShard &shard = playlistShard(playlistId);
+  auto lock = lockShard(shard);
+  // Copy the name first: it may be the key being erased.
+  shard.key.assign(playlistId);
+  return logged({MutationType::DeletePlaylist, shard.key, {}}, [&] {
+    auto found = shard.playlists.find(shard.key);
+    if (found == shard.playlists.end()) {
+      return false;
+    }
+    shard.playlists.erase(found);
+    return true;
+  });
+}
+
+void VideoLibrary::deletePlaylist(const VideoPlaylist &playlist) {
+  deletePlaylist(std::string_view(playlist.getPlaylistId()));
+}
+
+const std::string *VideoLibrary::getFlag(VideoHandle video) const {
+  return mConcurrentFlags ? mConcurrentFlags->reason(video)
+                          : mFlags.reason(video);
+}
+
+bool VideoLibrary::addToPlaylist(VideoPlaylist &playlist, VideoHandle video) {
+  return logged({MutationType::AddToPlaylist, playlist.getPlaylistId(),
+                 getVideoAt(video).getVideoId()},
+                [&] {
+                  if (playlist.contains(video)) {
+                    return false;
+                  }
+                  playlist.addVideo(video);
+                  return true;
+                });
+}
+
+bool VideoLibrary::removeFromPlaylist(VideoPlaylist &playlist,
+                                      VideoHandle video) {
+  return logged({MutationType::RemoveFromPlaylist, playlist.getPlaylistId(),
+                 getVideoAt(video).getVideoId()},
+                [&] {
+                  if (!playlist.contains(video)) {
+                    return false;
+                  }
+                  playlist.removeVideo(video);
+                  return true;
+                });
+}
+
+void VideoLibrary::clearPlaylist(VideoPlaylist &playlist) {
+  logged({MutationType::ClearPlaylist, playlist.getPlaylistId(), {}}, [&] {
+    playlist.clearPlaylist();
+    return true;
+  });
+}
+
+bool VideoLibrary::addFlag(VideoHandle video, std::string_view reason) {
+  // Flags are changed and logged in one step, so two sessions flagging and
+  // allowing the same video are logged in the order they took effect.
+  return logged({MutationType::Flag, getVideoAt(video).getVideoId(), reason},
+                [&] {
+                  return mConcurrentFlags
+                             ? mConcurrentFlags->flag(video, reason)
+                             : mFlags.flag(video, reason);
+                });
+}
+
+bool VideoLibrary::deleteFlag(VideoHandle video) {
+  return logged({MutationType::Allow, getVideoAt(video).getVideoId(), {}},
+                [&] {
+                  return mConcurrentFlags ? mConcurrentFlags->allow(video)
+                                          : mFlags.allow(video);
+                });
+}
+
+VideoHandle VideoLibrary::randomPlayable(std::minstd_rand &random) const {
+  if (mConcurrentFlags) {
+    return mConcurrentFlags->randomPlayable(random);
+  }
+  // The store keeps the unflagged videos in an array, so this is one draw.
+  std::size_t playable = mFlags.playableCount();
+  if (playable == 0) {
+    return kNoVideo;
+  }
+  // Scale a 31-bit draw to the array with a multiply rather than a modulo;
+  // std::minstd_rand's output is fixed by the standard, so a seed gives the
+  // same picks everywhere.
+  std::uint64_t draw = random() - std::minstd_rand::min();
+  return mFlags.playableAt((draw * playable) >> 31);
+}
+
+std::vector<VideoHandle> VideoLibrary::getFlaggedVideos() const {
+  return mConcurrentFlags ? mConcurrentFlags->flaggedVideos()
+                          : mFlags.flaggedVideos();
+}
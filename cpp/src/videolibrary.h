@@ -1,24 +1,144 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "casefold.h"
+#include "catalog.h"
+#include "catalogreloader.h"
+#include "catalogwatcher.h"
+#include "commandgate.h"
+#include "concurrentflagstore.h"
+#include "flagstore.h"
+#include "mutationlog.h"
+#include "span.h"
 #include "video.h"
 #include "videoplaylist.h"
 
+/**
+ * A summary of a catalog swapped in by VideoLibrary::applyReload.
+ */
+struct ReloadReport {
+  // False if the catalog file could not be opened; the old one is kept.
+  bool loaded = false;
+  std::size_t videoCount = 0;
+  // Time spent building the catalog in the background.
+  std::chrono::microseconds loadTime{0};
+  // Time the owning thread spent swapping it in, during which no command ran.
+  std::chrono::microseconds swapTime{0};
+  std::size_t droppedFlags = 0;
+  std::size_t droppedPlaylistEntries = 0;
+};
+
 /**
  * A class used to represent a Video Library.
  */
 class VideoLibrary {
  private:
-  std::unordered_map<std::string, Video> mVideos;
+  // The playlists whose names hash to one shard, and the lock guarding them
+  // when the library is concurrent.
+  struct PlaylistShard {
+    std::mutex mutex;
+    // Keyed by the name the playlist was created with, matched ignoring
+    // case, so a lookup hashes the caller's string as it is.
+    std::unordered_map<std::string, VideoPlaylist, FoldedHash, FoldedEqual>
+        playlists;
+    // Reused to hold the name a caller looks a playlist up by, since the map
+    // cannot be searched with a string_view before C++20.
+    std::string key;
+  };
+
+  std::shared_ptr<const Catalog> mCatalog;
+  std::shared_ptr<CatalogReloader> mReloader;
+  std::unique_ptr<CatalogWatcher> mWatcher;
   std::vector<VideoPlaylist> playlistsVec;
-  std::unordered_map<std::string, VideoPlaylist> mPlaylists;
-  std::unordered_map<std::string, std::string> mFlags;
+  // A single shard until enableConcurrency.
+  std::vector<std::unique_ptr<PlaylistShard>> mPlaylistShards;
+  unsigned mPlaylistShardBits = 0;
+  // The flags are in mFlags, or in mConcurrentFlags once the library is
+  // concurrent.
+  FlagStore mFlags;
+  std::unique_ptr<ConcurrentFlagStore> mConcurrentFlags;
+  // Set once the library is concurrent; commands run inside it and a reload
+  // takes it exclusively to swap the catalog.
+  std::unique_ptr<CommandGate> mGate;
+  // The reloader generation of mCatalog.
+  std::uint64_t mGeneration = 0;
+  // Where playlist and flag changes are recorded, once openLog is called.
+  std::unique_ptr<MutationLog> mLog;
+
+  // Creates a library over catalog with no reloader; every public way of
+  // making one sets it.
+  explicit VideoLibrary(std::shared_ptr<const Catalog> catalog);
+
+  // Makes reloader the one this library reloads through, serving mCatalog.
+  void setReloader(std::shared_ptr<CatalogReloader> reloader);
+
+  PlaylistShard& playlistShard(std::string_view playlistId) const;
+  // Locks a playlist shard if the library is concurrent.
+  std::unique_lock<std::mutex> lockShard(PlaylistShard& shard) const {
+    return mGate ? std::unique_lock<std::mutex>(shard.mutex)
+                 : std::unique_lock<std::mutex>();
+  }
+
+  // Moves the flags and playlists onto the reloader's current catalog if it
+  // is not the one they are on, filling in result. Returns the catalog they
+  // were on, for the caller to release, or nullptr if nothing changed.
+  std::shared_ptr<const Catalog> adoptCurrentCatalog(ReloadReport& result);
+
+  // Makes a change and, if it changed anything and a log is open, records
+  // mutation. Returns what change returns.
+  template <typename Change>
+  bool logged(const Mutation &mutation, Change &&change) {
+    return mLog ? mLog->record(mutation, change) : change();
+  }
+  // Applies a mutation read back from the log.
+  void replay(const Mutation &mutation);
+  // Returns the log records that rebuild the current playlists and flags.
+  std::string logState() const;
+  // Compacts the log with every command kept out; with onlyIfDue, only if
+  // no other thread compacted it first.
+  bool compactLog(bool onlyIfDue);
 
   public:
+  // Loads the catalog at defaultCatalogPath().
   VideoLibrary();
+  // Loads the catalog from the videos.txt-format file at catalogPath, parsing
+  // it on parserThreads threads. With 0, large catalogs are parsed on every
+  // hardware thread and small ones serially. If the file cannot be read the
+  // library is empty, and catalog()->isOpen() is false.
+  explicit VideoLibrary(const std::string& catalogPath,
+                        unsigned parserThreads = 0);
+
+  // Loads a library from a snapshot written by saveSnapshot, without parsing
+  // anything. Returns nothing if the file is missing or not a valid snapshot.
+  static std::optional<VideoLibrary> fromSnapshot(
+      const std::string& snapshotPath);
+
+  // Loads the snapshot if it exists and is newer than the text catalog, and
+  // the text catalog otherwise.
+  static VideoLibrary open(const std::string& catalogPath,
+                           const std::string& snapshotPath);
+
+  // Returns the catalog loaded when none is named: the file in the
+  // YOUTUBE_CATALOG environment variable, or ./src/videos.txt without it.
+  static std::string defaultCatalogPath();
+
+  // Returns where youtube_snapshot keeps the snapshot of the catalog at
+  // catalogPath: the same path with a .snapshot extension.
+  static std::string snapshotPathFor(const std::string& catalogPath);
+
+  // Returns a library over the same catalog, with no playlists or flags of
+  // its own, for another session. The catalog is shared rather than copied,
+  // and both libraries move to a new one when either is reloaded.
+  VideoLibrary shareCatalog() const;
 
   // This class is not copyable to avoid expensive copies.
   VideoLibrary(const VideoLibrary&) = delete;
@@ -28,17 +148,191 @@ class VideoLibrary {
   VideoLibrary(VideoLibrary&&) = default;
   VideoLibrary& operator=(VideoLibrary&&) = default;
 
+  // Returns a copy of every video. Prefer videos() or forEachVideo, which
+  // do not copy.
   std::vector<Video> getVideos() const;
-  const Video *getVideo(const std::string& videoId) const;
+  // Returns every video, in catalog order, without copying. Like positions,
+  // the view is only valid until the catalog is reloaded.
+  Span<Video> videos() const;
+  // Calls visit with each video, in catalog order.
+  template <typename Visitor>
+  void forEachVideo(Visitor &&visit) const {
+    for (const Video &video : mCatalog->getVideos()) {
+      visit(video);
+    }
+  }
+  // Returns the number of videos.
+  std::size_t size() const { return mCatalog->getVideos().size(); }
+  // Returns the catalog handles refer to, which changes on reload.
+  const std::shared_ptr<const Catalog> &catalog() const { return mCatalog; }
+  // Returns the file the catalog is loaded and reloaded from: the text
+  // catalog, or the snapshot for a library loaded from that alone.
+  const std::string &getCatalogPath() const {
+    return mReloader->getCatalogPath().empty() ? mReloader->getSnapshotPath()
+                                               : mReloader->getCatalogPath();
+  }
+  const Video *getVideo(std::string_view videoId) const;
+  // Returns the handle of the video with the given id, or kNoVideo. This is
+  // the one id lookup a command makes; everything else takes handles.
+  VideoHandle findVideo(std::string_view videoId) const;
+  // Returns the folded id of a tag, matched case-insensitively, or
+  // TagDictionary::npos if no video has it.
+  std::uint32_t findTag(std::string_view tag) const;
+  // Returns the handles of the videos with a tag, matched
+  // case-insensitively, in title order.
+  Span<std::uint32_t> findVideosWithTag(std::string_view tag) const;
+  // Returns the handles of the videos whose title matches searchTerm,
+  // ignoring case, in title order. See Catalog::searchTitles.
+  std::vector<std::uint32_t> searchTitles(
+      std::string_view searchTerm, bool *complete = nullptr,
+      std::uint64_t stepBudget = Catalog::kSearchStepBudget) const;
+  // Returns the handles of every video in title order (ties in catalog
+  // order), kept up to date across reloads.
+  Span<std::uint32_t> getTitleOrder() const;
+  // Returns the video with a handle handed out by the library. Handles are
+  // only valid until the catalog is reloaded.
+  const Video &getVideoAt(VideoHandle video) const;
 
+  // Returns a copy of every playlist. Prefer forEachPlaylist, which does
+  // not copy.
   std::vector<VideoPlaylist> getPlaylists();
-  VideoPlaylist *getPlaylist(const std::string &playlistId);
-  VideoPlaylist *createPlaylist(const std::string &playlistId);
-  void deletePlaylist(VideoPlaylist playlist);
-
-  const std::string *getFlag(const std::string &videoId);
-  std::vector<std::string> getFlaggedVideoIds();
-  void addFlag(const std::string &videoId,
-               const std::string &reason = "Not supplied");
-  void deleteFlag(const std::string &videoId);
+  // Calls visit with each playlist, in no particular order. In a concurrent
+  // library, only while holding lockAllPlaylists().
+  template <typename Visitor>
+  void forEachPlaylist(Visitor &&visit) const {
+    for (const auto &shard : mPlaylistShards) {
+      for (const auto &playlist : shard->playlists) {
+        visit(playlist.second);
+      }
+    }
+  }
+  // Like forEachPlaylist, only while holding lockAllPlaylists() in a
+  // concurrent library.
+  std::size_t playlistCount() const;
+  // Locks every playlist shard, in order, if the library is concurrent.
+  std::vector<std::unique_lock<std::mutex>> lockAllPlaylists() const;
+  // Calls visit with the playlist with a name, matched ignoring case, while
+  // no other thread can change it. Returns false, without calling it, if
+  // there is no such playlist.
+  template <typename Visitor>
+  bool withPlaylist(std::string_view playlistId, Visitor &&visit) {
+    PlaylistShard &shard = playlistShard(playlistId);
+    auto lock = lockShard(shard);
+    shard.key.assign(playlistId);
+    auto found = shard.playlists.find(shard.key);
+    if (found == shard.playlists.end()) {
+      return false;
+    }
+    visit(found->second);
+    return true;
+  }
+  // The playlist getters return pointers that are only safe to use while no
+  // other thread deletes the playlist; concurrent callers use withPlaylist.
+  VideoPlaylist *getPlaylist(std::string_view playlistId);
+  VideoPlaylist *createPlaylist(std::string_view playlistId);
+  // Deletes the playlist with a name. Returns false if there is none.
+  bool deletePlaylist(std::string_view playlistId);
+  void deletePlaylist(const VideoPlaylist &playlist);
+  // Change a playlist of this library and record the change in the log.
+  // Changing the playlist directly is not recorded. Return false if there
+  // was nothing to change.
+  bool addToPlaylist(VideoPlaylist &playlist, VideoHandle video);
+  bool removeFromPlaylist(VideoPlaylist &playlist, VideoHandle video);
+  void clearPlaylist(VideoPlaylist &playlist);
+
+  // Returns the reason a video was flagged, or nullptr if it is not. In a
+  // concurrent library the reason stays valid until leaveCommand, or while
+  // the caller holds an EpochReclaimer::Guard, even if another thread
+  // allows the video meanwhile.
+  const std::string *getFlag(VideoHandle video) const;
+  // Calls visit with the reason a video was flagged. Returns false, without
+  // calling it, if it is not flagged.
+  template <typename Visitor>
+  bool withFlag(VideoHandle video, Visitor &&visit) const {
+    if (mConcurrentFlags) {
+      return mConcurrentFlags->withReason(video, visit);
+    }
+    const std::string *reason = mFlags.reason(video);
+    if (!reason) {
+      return false;
+    }
+    visit(*reason);
+    return true;
+  }
+  bool isFlagged(VideoHandle video) const {
+    return mConcurrentFlags ? mConcurrentFlags->isFlagged(video)
+                            : mFlags.isFlagged(video);
+  }
+  std::vector<VideoHandle> getFlaggedVideos() const;
+  std::size_t flagCount() const {
+    return mConcurrentFlags ? mConcurrentFlags->size() : mFlags.size();
+  }
+  // Returns a random video that is not flagged, drawn from random, or
+  // kNoVideo if every video is flagged.
+  VideoHandle randomPlayable(std::minstd_rand &random) const;
+  // Flags a video. Returns false if it was already flagged.
+  bool addFlag(VideoHandle video, std::string_view reason = "Not supplied");
+  // Removes a video's flag. Returns false if it was not flagged.
+  bool deleteFlag(VideoHandle video);
+
+  // Makes the library safe to run commands on from many threads at once,
+  // through the players of sessions sharing it. The catalog and flags are
+  // read without locking and flags change with atomic operations; playlists
+  // are split into shardCount shards by name, each with its own lock. Must
+  // be called before any other thread uses the library, and cannot be
+  // undone.
+  void enableConcurrency(std::size_t shardCount = 64);
+  bool isConcurrent() const { return mGate != nullptr; }
+
+  // Replays the mutation log at path onto the library's playlists and flags,
+  // creating the log if it does not exist, then records every later change
+  // to them in it. Changes are durable once the command that made them
+  // ends, or after syncLog. Entries for videos the catalog no longer has are
+  // skipped. Must be called before enableConcurrency. Returns false if the
+  // file cannot be opened or is not a mutation log.
+  bool openLog(const std::string &path, std::uint64_t *replayed = nullptr);
+  // Returns the open log, or nullptr.
+  MutationLog *getLog() const { return mLog.get(); }
+  // Returns false once the open log has failed to write. Changes to
+  // playlists and flags are then refused, since they could not be kept.
+  bool canRecord() const { return !mLog || !mLog->failed(); }
+  // Blocks until every recorded change is on disk. Returns false if there is
+  // no log or it could not be written.
+  bool syncLog();
+  // Rewrites the log as just the current playlists and flags. Commands do
+  // this themselves once the log has grown well past that. Must not be
+  // called from inside a command.
+  bool compactLog() { return compactLog(false); }
+
+  // Writes the catalog, flags and playlists to a binary snapshot.
+  bool saveSnapshot(const std::string& snapshotPath) const;
+
+  // Starts rebuilding the catalog from the files it was loaded from on a
+  // background thread. Returns false if a reload is already in progress;
+  // it then runs again when done, to pick up the files as they are now.
+  bool beginReload();
+
+  // Swaps in a catalog finished by a background reload, if there is one, or
+  // one that a library sharing this one's catalog has swapped in. Flags and
+  // playlist entries are moved onto the new catalog's handles, and those
+  // whose video is no longer in it are dropped. Returns false, without
+  // blocking, if there is no new catalog.
+  bool applyReload(ReloadReport* report);
+
+  // Starts a command on the calling thread: applies a reload as above, then,
+  // in a concurrent library, keeps any other thread from swapping the
+  // catalog, and pins the epoch so no flag reason read meanwhile is freed,
+  // until leaveCommand. Returns what applyReload would.
+  bool enterCommand(ReloadReport* report);
+  // Ends a command, returning once the changes it recorded are on disk, and
+  // compacts the log if it is due. Returns false if a log is open and could
+  // not be written.
+  bool leaveCommand();
+
+  // Blocks until a reload in progress has finished building.
+  void waitForReload();
+
+  // Reloads the catalog in the background whenever its files change on disk.
+  // Returns false if the platform does not support watching files.
+  bool watchCatalog();
 };
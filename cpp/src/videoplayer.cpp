@@ -1,421 +1,565 @@
 #include "videoplayer.h"
 
+#include <atomic>
+#include <charconv>
 #include <iostream>
+#include <system_error>
+#include <utility>
 
 #include "helper.h"
 
-// compares two videos by name lexographically
-bool videoLexCompare(const Video &a, const Video &b) {
-  return a.getTitle() < b.getTitle();
-}
-
 // compares two playlists by name lexographically
-bool playlistLexCompare(const VideoPlaylist &a, const VideoPlaylist &b) {
-  return a.getPlaylistId() < b.getPlaylistId();
+bool playlistLexCompare(const VideoPlaylist *a, const VideoPlaylist *b) {
+  return a->getPlaylistId() < b->getPlaylistId();
 }
 
+VideoPlayer::VideoPlayer(VideoLibrary &&videoLibrary)
+    : VideoPlayer(std::make_shared<VideoLibrary>(std::move(videoLibrary)),
+                  std::make_shared<StdoutSink>()) {}
+
+VideoPlayer::VideoPlayer(std::shared_ptr<OutputSink> output)
+    : VideoPlayer(std::make_shared<VideoLibrary>(), std::move(output)) {}
+
+VideoPlayer::VideoPlayer(VideoLibrary &&videoLibrary,
+                         std::shared_ptr<OutputSink> output)
+    : VideoPlayer(std::make_shared<VideoLibrary>(std::move(videoLibrary)),
+                  std::move(output)) {}
+
+VideoPlayer::VideoPlayer(std::shared_ptr<VideoLibrary> videoLibrary,
+                         std::shared_ptr<OutputSink> output)
+    : mVideoLibrary(std::move(videoLibrary)),
+      mOutput(std::move(output)),
+      mCatalog(mVideoLibrary->catalog()) {}
+
 // takes in a video and outputs a string describing its properties
-std::string VideoPlayer::VideoToString(const Video video) {
-  std::string output = "";
-  output += video.getTitle() + " (" + video.getVideoId() + ") [";
-  std::vector<std::string> tags = video.getTags();
-  for (auto tag : tags) {
-    output += tag;
-    if (tag != tags[tags.size() - 1]) {
+std::string VideoPlayer::VideoToString(VideoHandle video) {
+  std::string output;
+  appendVideoString(output, video);
+  return output;
+}
+
+void VideoPlayer::appendVideoString(std::string &output, VideoHandle handle) {
+  const Video &video = mVideoLibrary->getVideoAt(handle);
+  output.append(video.getTitle()).append(" (");
+  output.append(video.getVideoId()).append(") [");
+  bool first = true;
+  for (std::string_view tag : video.getTags()) {
+    if (!first) {
       output += " ";
     }
+    output.append(tag);
+    first = false;
   }
   output += "]";
 
-  if (auto flagReason = mVideoLibrary.getFlag(video.getVideoId())) {
-    output += " - FLAGGED (reason: " + *flagReason + ")";
-  }
-  return output;
+  mVideoLibrary->withFlag(handle, [&](const std::string &flagReason) {
+    output.append(" - FLAGGED (reason: ").append(flagReason).append(")");
+  });
 }
 
 void VideoPlayer::numberOfVideos() {
-  std::cout << mVideoLibrary.getVideos().size() << " videos in the library"
-            << std::endl;
+  *mOutput << mVideoLibrary->size() << " videos in the library"
+           << '\n';
 }
 
 void VideoPlayer::showAllVideos() {
-  std::cout << "Here's a list of all available videos:" << std::endl;
-  // get all the videos
-  auto videos = mVideoLibrary.getVideos();
-  // sort all the videos by name (lexographically)
-  std::sort(videos.begin(), videos.end(), videoLexCompare);
-  // list all the videos
-  for (auto video : videos) {
-    std::cout << "\t" << VideoToString(video) << std::endl;
-  }
-}
-
-void VideoPlayer::playVideo(const std::string &videoId) {
-  // get a pointer to the videoif the pointer is not null (meaning the video was
-  // found)
-  if (auto video = mVideoLibrary.getVideo(videoId)) {
-    // if the currentlyplaying pointer is not null (already playing a video)
-    if (auto flagReason = mVideoLibrary.getFlag(video->getVideoId())) {
-      std::cout << "Cannot play video: Video is currently flagged (reason: "
-                << *flagReason << ")" << std::endl;
-    } else {
-      if (CurrentlyPlaying) {
-        std::cout << "Stopping video: " << CurrentlyPlaying->getTitle()
-                  << std::endl;
-      }
-      std::cout << "Playing video: " << video->getTitle() << std::endl;
-      playing = true;
-      CurrentlyPlaying = video;
-    }
+  *mOutput << "Here's a list of all available videos:" << '\n';
+  // list all the videos, in the title order the library keeps
+  std::string line;
+  for (VideoHandle video : mVideoLibrary->getTitleOrder()) {
+    line.clear();
+    appendVideoString(line, video);
+    *mOutput << "\t" << line << '\n';
+  }
+}
+
+void VideoPlayer::playVideo(std::string_view videoId) {
+  // look the video up once; if it was found, play it by handle
+  VideoHandle video = mVideoLibrary->findVideo(videoId);
+  if (video != kNoVideo) {
+    playVideo(video);
   } else {
-    std::cout << "Cannot play video: Video does not exist" << std::endl;
+    *mOutput << "Cannot play video: Video does not exist" << '\n';
+  }
+}
+
+void VideoPlayer::playVideo(VideoHandle video) {
+  bool flagged =
+      mVideoLibrary->withFlag(video, [&](const std::string &flagReason) {
+        *mOutput << "Cannot play video: Video is currently flagged (reason: "
+                 << flagReason << ")" << '\n';
+      });
+  if (!flagged) {
+    // if a video is already playing
+    if (CurrentlyPlaying != kNoVideo) {
+      *mOutput << "Stopping video: "
+               << mVideoLibrary->getVideoAt(CurrentlyPlaying).getTitle()
+               << '\n';
+    }
+    *mOutput << "Playing video: " << mVideoLibrary->getVideoAt(video).getTitle()
+             << '\n';
+    playing = true;
+    CurrentlyPlaying = video;
   }
 }
 
 void VideoPlayer::stopVideo() {
-  // if the currentlyPlaying pointer is not null (already playing a video)
-  if (CurrentlyPlaying) {
-    std::cout << "Stopping video: " << CurrentlyPlaying->getTitle()
-              << std::endl;
-    CurrentlyPlaying = nullptr;
+  // if a video is playing
+  if (CurrentlyPlaying != kNoVideo) {
+    *mOutput << "Stopping video: "
+             << mVideoLibrary->getVideoAt(CurrentlyPlaying).getTitle()
+             << '\n';
+    CurrentlyPlaying = kNoVideo;
     playing = false;
   } else {
-    std::cout << "Cannot stop video: No video is currently playing"
-              << std::endl;
+    *mOutput << "Cannot stop video: No video is currently playing"
+             << '\n';
   }
 }
 
 void VideoPlayer::playRandomVideo() {
-  auto videos = mVideoLibrary.getVideos();
-  std::vector<Video> validVideos;
-  auto flaggedVideos = mVideoLibrary.getFlaggedVideoIds();
-  for (auto video : videos) {
-    if (std::find(flaggedVideos.begin(), flaggedVideos.end(),
-                  video.getVideoId()) != flaggedVideos.end()) {
-      continue;
-    }
-    validVideos.push_back(video);
-  }
+  VideoHandle video = mVideoLibrary->randomPlayable(mRandom);
   // if there are no videos in the library
-  if (validVideos.size() == 0) {
-    std::cout << "No videos available" << std::endl;
+  if (video == kNoVideo) {
+    *mOutput << "No videos available" << '\n';
   } else {
-    playVideo(validVideos[std::rand() % validVideos.size()].getVideoId());
+    playVideo(video);
   }
 }
 
+void VideoPlayer::seedRandom(std::uint32_t seed) { mRandom.seed(seed); }
+
+std::uint32_t VideoPlayer::nextSeed() {
+  // A SplitMix64 sequence started from one system-random value.
+  static std::atomic<std::uint64_t> state{std::random_device{}()};
+  constexpr std::uint64_t kGamma = 0x9E3779B97F4A7C15ull;
+  std::uint64_t z = state.fetch_add(kGamma) + kGamma;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return static_cast<std::uint32_t>(z ^ (z >> 31));
+}
+
 void VideoPlayer::pauseVideo() {
-  // if the currentlyPlaying pointer is not null (already playing a video)
-  if (CurrentlyPlaying) {
+  // if a video is playing
+  if (CurrentlyPlaying != kNoVideo) {
+    const Video &video = mVideoLibrary->getVideoAt(CurrentlyPlaying);
     if (playing) {
-      std::cout << "Pausing video: " << CurrentlyPlaying->getTitle()
-                << std::endl;
+      *mOutput << "Pausing video: " << video.getTitle() << '\n';
       playing = false;
     } else {
-      std::cout << "Video already paused: " << CurrentlyPlaying->getTitle()
-                << std::endl;
+      *mOutput << "Video already paused: " << video.getTitle() << '\n';
     }
   } else {
-    std::cout << "Cannot pause video: No video is currently playing"
-              << std::endl;
+    *mOutput << "Cannot pause video: No video is currently playing"
+             << '\n';
   }
 }
 
 void VideoPlayer::continueVideo() {
-  // if the currentlyPlaying pointer is not null (already playing a video)
-  if (CurrentlyPlaying) {
+  // if a video is playing
+  if (CurrentlyPlaying != kNoVideo) {
     if (!playing) {
-      std::cout << "Continuing video: " << CurrentlyPlaying->getTitle()
-                << std::endl;
+      *mOutput << "Continuing video: "
+               << mVideoLibrary->getVideoAt(CurrentlyPlaying).getTitle()
+               << '\n';
       playing = true;
     } else {
-      std::cout << "Cannot continue video: Video is not paused" << std::endl;
+      *mOutput << "Cannot continue video: Video is not paused" << '\n';
     }
   } else {
-    std::cout << "Cannot continue video: No video is currently playing"
-              << std::endl;
+    *mOutput << "Cannot continue video: No video is currently playing"
+             << '\n';
   }
 }
 
 void VideoPlayer::showPlaying() {
-  // if the currentlyPlaying pointer is not null (currently playing avideo)
-  if (CurrentlyPlaying) {
-    std::cout << "Currently playing: " << VideoToString(*CurrentlyPlaying);
+  // if a video is playing
+  if (CurrentlyPlaying != kNoVideo) {
+    *mOutput << "Currently playing: " << VideoToString(CurrentlyPlaying);
     if (!playing) {
-      std::cout << " - PAUSED";
+      *mOutput << " - PAUSED";
     }
-    std::cout << std::endl;
+    *mOutput << '\n';
   } else {
-    std::cout << "No video is currently playing" << std::endl;
+    *mOutput << "No video is currently playing" << '\n';
+  }
+}
+
+bool VideoPlayer::canRecord(std::string_view failure,
+                            std::string_view playlistName) {
+  if (mVideoLibrary->canRecord()) {
+    return true;
   }
+  *mOutput << failure;
+  if (!playlistName.empty()) {
+    *mOutput << " " << playlistName;
+  }
+  *mOutput << ": Cannot persist change to "
+           << mVideoLibrary->getLog()->getPath() << '\n';
+  return false;
 }
 
-void VideoPlayer::createPlaylist(const std::string &playlistName) {
-  // if the store of playlists already has a playlist with a matching Id
-  if (auto playlist = mVideoLibrary.createPlaylist(playlistName)) {
-    std::cout << "Successfully created new playlist: "
-              << playlist->getPlaylistId() << std::endl;
+void VideoPlayer::createPlaylist(std::string_view playlistName) {
+  if (!canRecord("Cannot create playlist")) {
+    return;
+  }
+  // The playlist is created with the name as given; print that rather than
+  // read it back, since another session may already be changing it.
+  if (mVideoLibrary->createPlaylist(playlistName)) {
+    *mOutput << "Successfully created new playlist: " << playlistName
+             << '\n';
   } else {
-    std::cout << "Cannot create playlist: A playlist with the same name "
-                 "already exists"
-              << std::endl;
-  }
-}
-
-void VideoPlayer::addVideoToPlaylist(const std::string &playlistName,
-                                     const std::string &videoId) {
-  if (auto playlist = mVideoLibrary.getPlaylist(playlistName)) {
-    if (auto video = mVideoLibrary.getVideo(videoId)) {
-      if (auto flagReason = mVideoLibrary.getFlag(video->getVideoId())) {
-        std::cout << "Cannot add video to " << playlistName
-                  << ": Video is currently flagged (reason: " << *flagReason
-                  << ")" << std::endl;
-      } else {
-        if (playlist->contains(videoId)) {
-          std::cout << "Cannot add video to " << playlistName
-                    << ": Video already added" << std::endl;
+    *mOutput << "Cannot create playlist: A playlist with the same name "
+                "already exists"
+             << '\n';
+  }
+}
+
+void VideoPlayer::addVideoToPlaylist(std::string_view playlistName,
+                                     std::string_view videoId) {
+  if (!canRecord("Cannot add video to", playlistName)) {
+    return;
+  }
+  bool found = mVideoLibrary->withPlaylist(
+      playlistName, [&](VideoPlaylist &playlist) {
+        VideoHandle video = mVideoLibrary->findVideo(videoId);
+        if (video == kNoVideo) {
+          *mOutput << "Cannot add video to " << playlistName
+                   << ": Video does not exist" << '\n';
+          return;
+        }
+        bool flagged =
+            mVideoLibrary->withFlag(video, [&](const std::string &reason) {
+              *mOutput << "Cannot add video to " << playlistName
+                       << ": Video is currently flagged (reason: " << reason
+                       << ")" << '\n';
+            });
+        if (flagged) {
+          return;
+        }
+        if (playlist.contains(video)) {
+          *mOutput << "Cannot add video to " << playlistName
+                   << ": Video already added" << '\n';
         } else {
-          playlist->addVideo(video->getVideoId());
-          std::cout << "Added video to " << playlistName << ": "
-                    << video->getTitle() << std::endl;
+          mVideoLibrary->addToPlaylist(playlist, video);
+          *mOutput << "Added video to " << playlistName << ": "
+                   << mVideoLibrary->getVideoAt(video).getTitle() << '\n';
         }
-      }
-    } else {
-      std::cout << "Cannot add video to " << playlistName
-                << ": Video does not exist" << std::endl;
-    }
-  } else {
-    std::cout << "Cannot add video to " << playlistName
-              << ": Playlist does not exist" << std::endl;
+      });
+  if (!found) {
+    *mOutput << "Cannot add video to " << playlistName
+             << ": Playlist does not exist" << '\n';
   }
 }
 
 void VideoPlayer::showAllPlaylists() {
-  auto playlists = mVideoLibrary.getPlaylists();
-  if (playlists.size()) {
-    std::cout << "Showing all playlists:" << std::endl;
-    // sort all the playlists by name (lexographically)
+  // Other sessions may be creating and deleting playlists; hold them all
+  // still while listing them.
+  auto locks = mVideoLibrary->lockAllPlaylists();
+  if (mVideoLibrary->playlistCount()) {
+    *mOutput << "Showing all playlists:" << '\n';
+    // sort the playlists by name (lexographically), by pointer so none are
+    // copied
+    std::vector<const VideoPlaylist *> playlists;
+    playlists.reserve(mVideoLibrary->playlistCount());
+    mVideoLibrary->forEachPlaylist([&](const VideoPlaylist &playlist) {
+      playlists.push_back(&playlist);
+    });
     std::sort(playlists.begin(), playlists.end(), playlistLexCompare);
     // list all the videos
-    for (auto playlist : playlists) {
-      std::cout << "\t" << playlist.getPlaylistId() << std::endl;
+    for (const VideoPlaylist *playlist : playlists) {
+      *mOutput << "\t" << playlist->getPlaylistId() << '\n';
     }
   } else {
-    std::cout << "No playlists exist yet" << std::endl;
+    *mOutput << "No playlists exist yet" << '\n';
   }
 }
 
-void VideoPlayer::showPlaylist(const std::string &playlistName) {
-  if (auto playlist = mVideoLibrary.getPlaylist(playlistName)) {
-    std::cout << "Showing playlist: " << playlistName << std::endl;
-    auto videoIds = playlist->getVideoIds();
-    if (videoIds.size()) {
-      for (auto videoId : videoIds) {
-        std::cout << "\t" << VideoToString(*mVideoLibrary.getVideo(videoId))
-                  << std::endl;
-      }
-    } else {
-      std::cout << " \t No videos here yet" << std::endl;
-    }
-  } else {
-    std::cout << "Cannot show playlist " << playlistName
-              << ": Playlist does not exist" << std::endl;
-  }
-}
-
-void VideoPlayer::removeFromPlaylist(const std::string &playlistName,
-                                     const std::string &videoId) {
-  if (auto playlist = mVideoLibrary.getPlaylist(playlistName)) {
-    if (auto video = mVideoLibrary.getVideo(videoId)) {
-      if (playlist->contains(videoId)) {
-        playlist->removeVideo(video);
-        std::cout << "Removed video from " << playlistName << ": "
-                  << video->getTitle() << std::endl;
-      } else {
-        std::cout << "Cannot remove video from " << playlistName
-                  << ": Video is not in playlist" << std::endl;
-      }
-    } else {
-      std::cout << "Cannot remove video from " << playlistName
-                << ": Video does not exist" << std::endl;
-    }
-  } else {
-    std::cout << "Cannot remove video from " << playlistName
-              << ": Playlist does not exist" << std::endl;
+void VideoPlayer::showPlaylist(std::string_view playlistName) {
+  bool found = mVideoLibrary->withPlaylist(
+      playlistName, [&](const VideoPlaylist &playlist) {
+        *mOutput << "Showing playlist: " << playlistName << '\n';
+        if (playlist.size()) {
+          std::string line;
+          playlist.forEachVideo([&](VideoHandle video) {
+            line.clear();
+            appendVideoString(line, video);
+            *mOutput << "\t" << line << '\n';
+          });
+        } else {
+          *mOutput << " \t No videos here yet" << '\n';
+        }
+      });
+  if (!found) {
+    *mOutput << "Cannot show playlist " << playlistName
+             << ": Playlist does not exist" << '\n';
   }
 }
 
-void VideoPlayer::clearPlaylist(const std::string &playlistName) {
-  if (auto playlist = mVideoLibrary.getPlaylist(playlistName)) {
-    playlist->clearPlaylist();
-    std::cout << "Successfully removed all videos from " << playlistName
-              << std::endl;
-  } else {
-    std::cout << "Cannot clear playlist " << playlistName
-              << ": Playlist does not exist" << std::endl;
+void VideoPlayer::removeFromPlaylist(std::string_view playlistName,
+                                     std::string_view videoId) {
+  if (!canRecord("Cannot remove video from", playlistName)) {
+    return;
+  }
+  bool found = mVideoLibrary->withPlaylist(
+      playlistName, [&](VideoPlaylist &playlist) {
+        VideoHandle video = mVideoLibrary->findVideo(videoId);
+        if (video == kNoVideo) {
+          *mOutput << "Cannot remove video from " << playlistName
+                   << ": Video does not exist" << '\n';
+        } else if (mVideoLibrary->removeFromPlaylist(playlist, video)) {
+          *mOutput << "Removed video from " << playlistName << ": "
+                   << mVideoLibrary->getVideoAt(video).getTitle() << '\n';
+        } else {
+          *mOutput << "Cannot remove video from " << playlistName
+                   << ": Video is not in playlist" << '\n';
+        }
+      });
+  if (!found) {
+    *mOutput << "Cannot remove video from " << playlistName
+             << ": Playlist does not exist" << '\n';
   }
 }
 
-void VideoPlayer::deletePlaylist(const std::string &playlistName) {
-  if (auto playlist = mVideoLibrary.getPlaylist(playlistName)) {
-    mVideoLibrary.deletePlaylist(*playlist);
-    std::cout << "Deleted playlist: " << playlistName << std::endl;
+void VideoPlayer::clearPlaylist(std::string_view playlistName) {
+  if (!canRecord("Cannot clear playlist", playlistName)) {
+    return;
+  }
+  if (mVideoLibrary->withPlaylist(playlistName, [&](VideoPlaylist &playlist) {
+        mVideoLibrary->clearPlaylist(playlist);
+      })) {
+    *mOutput << "Successfully removed all videos from " << playlistName
+             << '\n';
   } else {
-    std::cout << "Cannot delete playlist " << playlistName
-              << ": Playlist does not exist" << std::endl;
+    *mOutput << "Cannot clear playlist " << playlistName
+             << ": Playlist does not exist" << '\n';
   }
 }
 
-void VideoPlayer::searchVideos(const std::string &searchTerm) {
-  std::regex pat{stringToUpper(searchTerm)};
-  auto videos = mVideoLibrary.getVideos();
-  std::vector<Video> matches;
-  for (auto video : videos) {
-    if (std::regex_search(stringToUpper(video.getTitle()), pat)) {
-      if (mVideoLibrary.getFlag(video.getVideoId())) {
-        continue;
-      }
-      matches.push_back(video);
-    }
+void VideoPlayer::deletePlaylist(std::string_view playlistName) {
+  if (!canRecord("Cannot delete playlist", playlistName)) {
+    return;
   }
-  if (matches.size()) {
-    std::cout << "Here are the results for " << searchTerm << ":" << std::endl;
-    int counter = 1;
-    std::sort(matches.begin(), matches.end(), videoLexCompare);
-    for (auto video : matches) {
-      std::cout << "\t" << counter << (") ") << VideoToString(video)
-                << std::endl;
-      counter++;
-    }
-    std::cout << "Would you like to play any of the above? If yes, specify the "
-                 "number of the video."
-              << std::endl;
-    std::cout
-        << "If your answer is not a valid number, we will assume it's a no."
-        << std::endl;
-    std::string userInput;
-    std::string command;
-    std::vector<std::string> commandList;
-    for (;;) {
-      if (!std::getline(std::cin, userInput)) {
-        break;
-      }
-      if (userInput.empty()) {
-        break;
-      } else {
-        try {
-          int index = std::stoi(userInput);
-          if (index > 0 && index <= matches.size()) {
-            playVideo(matches[index - 1].getVideoId());
-            break;
-          } else {
-            break;
-          }
-        } catch (const std::invalid_argument &ia) {
-          break;
-        }
-      }
-    }
+  if (mVideoLibrary->deletePlaylist(playlistName)) {
+    *mOutput << "Deleted playlist: " << playlistName << '\n';
   } else {
-    std::cout << "No search results for " << searchTerm << std::endl;
+    *mOutput << "Cannot delete playlist " << playlistName
+             << ": Playlist does not exist" << '\n';
   }
 }
 
-void VideoPlayer::searchVideosWithTag(const std::string &videoTag) {
-  auto videos = mVideoLibrary.getVideos();
-  std::vector<Video> matches;
-  for (auto video : videos) {
-    if (mVideoLibrary.getFlag(video.getVideoId())) {
+void VideoPlayer::searchVideos(std::string_view searchTerm) {
+  searchVideos(searchTerm, nullptr);
+}
+
+void VideoPlayer::searchVideos(std::string_view searchTerm,
+                               std::string_view selection) {
+  searchVideos(searchTerm, &selection);
+}
+
+void VideoPlayer::searchVideos(std::string_view searchTerm,
+                               const std::string_view* selection) {
+  // The title index only yields matching videos, already in title order.
+  bool complete = true;
+  std::vector<VideoHandle> matches;
+  for (VideoHandle video : mVideoLibrary->searchTitles(searchTerm, &complete)) {
+    if (mVideoLibrary->isFlagged(video)) {
       continue;
     }
-    std::vector<std::string> tags;
-    for (auto tag : video.getTags()) {
-      tags.push_back(stringToUpper(tag));
-    }
-    if (std::find(tags.begin(), tags.end(), stringToUpper(videoTag)) !=
-        tags.end()) {
-      matches.push_back(video);
-    }
+    matches.push_back(video);
   }
-  if (matches.size()) {
-    std::cout << "Here are the results for " << videoTag << ":" << std::endl;
-    int counter = 1;
-    std::sort(matches.begin(), matches.end(), videoLexCompare);
-    for (auto video : matches) {
-      std::cout << "\t" << counter << (") ") << VideoToString(video)
-                << std::endl;
-      counter++;
-    }
-    std::cout << "Would you like to play any of the above? If yes, specify the "
-                 "number of the video."
-              << std::endl;
-    std::cout
-        << "If your answer is not a valid number, we will assume it's a no."
-        << std::endl;
-    std::string userInput;
-    std::string command;
-    std::vector<std::string> commandList;
-    for (;;) {
-      if (!std::getline(std::cin, userInput)) {
-        break;
-      }
-      if (userInput.empty()) {
-        break;
-      } else {
-        try {
-          int index = std::stoi(userInput);
-          if (index > 0 && index <= matches.size()) {
-            playVideo(matches[index - 1].getVideoId());
-            break;
-          } else {
-            break;
-          }
-        } catch (const std::invalid_argument &ia) {
-          break;
-        }
-      }
+  if (!complete) {
+    *mOutput << "Search for " << searchTerm
+             << " took too long; results may be incomplete" << '\n';
+  }
+  showSearchResults(searchTerm, matches, selection);
+}
+
+void VideoPlayer::searchVideosWithTag(std::string_view videoTag) {
+  searchVideosWithTag(videoTag, nullptr);
+}
+
+void VideoPlayer::searchVideosWithTag(std::string_view videoTag,
+                                      std::string_view selection) {
+  searchVideosWithTag(videoTag, &selection);
+}
+
+void VideoPlayer::searchVideosWithTag(std::string_view videoTag,
+                                      const std::string_view* selection) {
+  // The tag index only yields the videos with the tag, already in title
+  // order.
+  std::vector<VideoHandle> matches;
+  for (VideoHandle video : mVideoLibrary->findVideosWithTag(videoTag)) {
+    if (mVideoLibrary->isFlagged(video)) {
+      continue;
     }
-  } else {
-    std::cout << "No search results for " << videoTag << std::endl;
+    matches.push_back(video);
+  }
+  showSearchResults(videoTag, matches, selection);
+}
+
+void VideoPlayer::showSearchResults(std::string_view query,
+                                    const std::vector<VideoHandle> &matches,
+                                    const std::string_view* selection) {
+  if (matches.empty()) {
+    *mOutput << "No search results for " << query << '\n';
+    return;
+  }
+  *mOutput << "Here are the results for " << query << ":" << '\n';
+  int counter = 1;
+  std::string line;
+  for (VideoHandle video : matches) {
+    line.clear();
+    appendVideoString(line, video);
+    *mOutput << "\t" << counter << (") ") << line << '\n';
+    counter++;
+  }
+  if (selection) {
+    playSelection(matches, *selection);
+    return;
+  }
+  if (!mInteractive) {
+    // Nobody is there to answer, and the next line of input is a command.
+    return;
+  }
+  *mOutput << "Would you like to play any of the above? If yes, specify the "
+              "number of the video."
+           << '\n';
+  *mOutput
+      << "If your answer is not a valid number, we will assume it's a no."
+      << '\n';
+  // The question must be visible before waiting for the answer.
+  mOutput->flush();
+  std::string userInput;
+  if (std::getline(std::cin, userInput)) {
+    playSelection(matches, userInput);
+  }
+}
+
+void VideoPlayer::playSelection(const std::vector<VideoHandle> &matches,
+                                std::string_view answer) {
+  // Like std::stoi, accept surrounding blanks and anything after the number.
+  answer = trimView(answer);
+  if (!answer.empty() && answer.front() == '+') {
+    answer.remove_prefix(1);
+  }
+  std::size_t index = 0;
+  auto parsed =
+      std::from_chars(answer.data(), answer.data() + answer.size(), index);
+  if (parsed.ec == std::errc() && index > 0 && index <= matches.size()) {
+    playVideo(matches[index - 1]);
   }
 }
 
-void VideoPlayer::flagVideo(const std::string &videoId) {
+void VideoPlayer::flagVideo(std::string_view videoId) {
   flagVideo(videoId, "Not supplied");
 }
 
-void VideoPlayer::flagVideo(const std::string &videoId,
-                            const std::string &reason) {
-  if (auto video = mVideoLibrary.getVideo(videoId)) {
-    if (mVideoLibrary.getFlag(videoId)) {
-      std::cout << "Cannot flag video: Video is already flagged" << std::endl;
+void VideoPlayer::flagVideo(std::string_view videoId,
+                            std::string_view reason) {
+  if (!canRecord("Cannot flag video")) {
+    return;
+  }
+  VideoHandle video = mVideoLibrary->findVideo(videoId);
+  if (video != kNoVideo) {
+    // Flag and check in one step: another session may flag it at once.
+    if (!mVideoLibrary->addFlag(video, reason)) {
+      *mOutput << "Cannot flag video: Video is already flagged" << '\n';
     } else {
-      mVideoLibrary.addFlag(videoId, reason);
-      if (CurrentlyPlaying) {
-        if (CurrentlyPlaying->getVideoId().compare(videoId) == 0) {
-          stopVideo();
-        }
+      if (CurrentlyPlaying == video) {
+        stopVideo();
       }
-      std::cout << "Successfully flagged video: " << video->getTitle()
-                << " (reason: " << reason << ")" << std::endl;
+      *mOutput << "Successfully flagged video: "
+               << mVideoLibrary->getVideoAt(video).getTitle()
+               << " (reason: " << reason << ")" << '\n';
     }
   } else {
-    std::cout << "Cannot flag video: Video does not exist" << std::endl;
+    *mOutput << "Cannot flag video: Video does not exist" << '\n';
   }
 }
 
-void VideoPlayer::allowVideo(const std::string &videoId) {
-  if (auto video = mVideoLibrary.getVideo(videoId)) {
-    if (mVideoLibrary.getFlag(videoId)) {
-      mVideoLibrary.deleteFlag(videoId);
-      std::cout << "Successfully removed flag from video: " << video->getTitle()
-                << std::endl;
+void VideoPlayer::allowVideo(std::string_view videoId) {
+  if (!canRecord("Cannot remove flag from video")) {
+    return;
+  }
+  VideoHandle video = mVideoLibrary->findVideo(videoId);
+  if (video != kNoVideo) {
+    if (mVideoLibrary->deleteFlag(video)) {
+      *mOutput << "Successfully removed flag from video: "
+               << mVideoLibrary->getVideoAt(video).getTitle() << '\n';
     } else {
-      std::cout << "Cannot remove flag from video: Video is not flagged"
-                << std::endl;
+      *mOutput << "Cannot remove flag from video: Video is not flagged"
+               << '\n';
     }
   } else {
-    std::cout << "Cannot remove flag from video: Video does not exist"
-              << std::endl;
+    *mOutput << "Cannot remove flag from video: Video does not exist"
+             << '\n';
+  }
+}
+
+void VideoPlayer::reloadLibrary() {
+  if (mVideoLibrary->beginReload()) {
+    *mOutput << "Reloading video library in the background" << '\n';
+  } else {
+    *mOutput << "Cannot reload video library: A reload is already in progress"
+             << '\n';
   }
 }
+
+void VideoPlayer::endCommand() {
+  if (!mVideoLibrary->leaveCommand() && !mLogFailureReported) {
+    mLogFailureReported = true;
+    *mOutput << "Cannot persist change: Couldn't write "
+             << mVideoLibrary->getLog()->getPath() << '\n';
+  }
+}
+
+VideoPlayer::CommandScope VideoPlayer::beginCommand() {
+  ReloadReport report;
+  bool reloaded = mVideoLibrary->enterCommand(&report);
+  if (reloaded && !report.loaded) {
+    *mOutput << "Cannot reload video library: Couldn't find "
+             << mVideoLibrary->getCatalogPath() << '\n';
+    return CommandScope(this);
+  }
+  // The library may also have moved on through another player sharing it.
+  // The currently playing handle belongs to the old catalog, so find the
+  // video again by id.
+  if (mVideoLibrary->catalog() != mCatalog) {
+    std::shared_ptr<const Catalog> previous = std::move(mCatalog);
+    mCatalog = mVideoLibrary->catalog();
+    if (CurrentlyPlaying != kNoVideo) {
+      const Video &video = previous->getVideos()[CurrentlyPlaying];
+      CurrentlyPlaying = mVideoLibrary->findVideo(video.getVideoId());
+      if (CurrentlyPlaying == kNoVideo) {
+        *mOutput << "Stopping video: " << video.getTitle() << '\n';
+        playing = false;
+      }
+    }
+  }
+  // Writing the catalog in place changes the videos underneath the player,
+  // so start loading it afresh before reading more of it.
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (now >= mNextChangeCheck) {
+    mNextChangeCheck = now + kChangeCheckInterval;
+    if (mCatalog->changedOnDisk() && mChangedCatalog.lock() != mCatalog) {
+      mChangedCatalog = mCatalog;
+      *mOutput << "Warning: " << mVideoLibrary->getCatalogPath()
+               << " was changed in place while loaded; reloading it. Replace "
+                  "it by renaming a new file over it instead"
+               << '\n';
+      mVideoLibrary->beginReload();
+    }
+  }
+  if (reloaded) {
+    *mOutput << "Reloaded video library: " << report.videoCount
+             << " videos (loaded in " << report.loadTime.count() / 1000
+             << " ms, commands paused for " << report.swapTime.count()
+             << " us)" << '\n';
+  }
+  return CommandScope(this);
+}
+
+void VideoPlayer::waitForReload() { mVideoLibrary->waitForReload(); }
+
+bool VideoPlayer::watchLibrary() { return mVideoLibrary->watchCatalog(); }
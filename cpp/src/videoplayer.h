@@ -2,23 +2,86 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
-#include <regex>
+#include <memory>
+#include <random>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "outputsink.h"
 #include "videolibrary.h"
 
 /**
- * A class used to represent a Video Player.
+ * A class used to represent a Video Player: one session's view of a video
+ * library. The player only holds what is playing; its library, and the
+ * playlists and flags in it, may be shared with other players.
  */
 class VideoPlayer {
  private:
-  VideoLibrary mVideoLibrary;
-  const Video* CurrentlyPlaying = nullptr;
+  std::shared_ptr<VideoLibrary> mVideoLibrary;
+  std::shared_ptr<OutputSink> mOutput;
+  // The catalog CurrentlyPlaying is a handle into, kept until the player
+  // moves the handle onto the library's current one.
+  std::shared_ptr<const Catalog> mCatalog;
+  VideoHandle CurrentlyPlaying = kNoVideo;
   bool playing = false;
+  // Draws PLAY_RANDOM's videos; each player has its own, so a seeded one
+  // replays the same picks. A small engine keeps sessions small.
+  std::minstd_rand mRandom{nextSeed()};
+  // Whether searches ask which result to play and read the answer from
+  // std::cin.
+  bool mInteractive = true;
+  // Whether the player has said that its library's log could not be
+  // written; it is only said once.
+  bool mLogFailureReported = false;
+  // The catalog the player last warned was written in place, so each
+  // catalog is only warned about once.
+  std::weak_ptr<const Catalog> mChangedCatalog;
+  // When the player next checks its catalog for writes in place. Checking
+  // costs a system call, so it is done at most every kChangeCheckInterval.
+  std::chrono::steady_clock::time_point mNextChangeCheck;
+  static constexpr std::chrono::milliseconds kChangeCheckInterval{100};
+
+  // Returns a different seed for every player, without asking the system
+  // for randomness each time.
+  static std::uint32_t nextSeed();
+
+  void playVideo(VideoHandle video);
+  void searchVideos(std::string_view searchTerm,
+                    const std::string_view* selection);
+  void searchVideosWithTag(std::string_view videoTag,
+                           const std::string_view* selection);
+  // Lists a search's results, then plays the one picked by selection, or by
+  // the user's answer when there is no selection and the player is
+  // interactive.
+  void showSearchResults(std::string_view query,
+                         const std::vector<VideoHandle>& matches,
+                         const std::string_view* selection);
+  // Plays the result numbered by answer, if it names one.
+  void playSelection(const std::vector<VideoHandle>& matches,
+                     std::string_view answer);
+  // Returns whether the library can still record changes. If it cannot,
+  // says so after failure and playlistName, the start of the command's
+  // error.
+  bool canRecord(std::string_view failure,
+                 std::string_view playlistName = {});
+  // Ends the command begun by beginCommand, saying so if its changes could
+  // not be written to the log.
+  void endCommand();
 
   public:
-  VideoPlayer() = default;
+  VideoPlayer() : VideoPlayer(std::make_shared<StdoutSink>()) {}
+  explicit VideoPlayer(VideoLibrary&& videoLibrary);
+  // Writes the player's output to output rather than a buffered std::cout.
+  explicit VideoPlayer(std::shared_ptr<OutputSink> output);
+  VideoPlayer(VideoLibrary&& videoLibrary, std::shared_ptr<OutputSink> output);
+  // Plays from a library other players may share, so they see each other's
+  // playlists and flags.
+  VideoPlayer(std::shared_ptr<VideoLibrary> videoLibrary,
+              std::shared_ptr<OutputSink> output);
 
   // This class is not copyable to avoid expensive copies.
   VideoPlayer(const VideoPlayer&) = delete;
@@ -28,27 +91,79 @@ class VideoPlayer {
   VideoPlayer(VideoPlayer&&) = default;
   VideoPlayer& operator=(VideoPlayer&&) = default;
 
-  std::string VideoToString(const Video video);
+  // Returns the sink the player writes to, so the command loop can share it.
+  OutputSink& getOutput() const { return *mOutput; }
+
+  // A player that is not interactive never asks which search result to play,
+  // so it never reads std::cin; batch runs use it that way.
+  void setInteractive(bool interactive) { mInteractive = interactive; }
+
+  std::string VideoToString(VideoHandle video);
+  // Appends VideoToString(video) to output, so a command listing many videos
+  // can reuse one buffer.
+  void appendVideoString(std::string& output, VideoHandle video);
 
   void numberOfVideos();
   void showAllVideos();
-  void playVideo(const std::string& videoId);
+  void playVideo(std::string_view videoId);
   void stopVideo();
   void playRandomVideo();
+  // Reseeds the generator PLAY_RANDOM draws from, to make its picks
+  // repeatable.
+  void seedRandom(std::uint32_t seed);
   void pauseVideo();
   void continueVideo();
   void showPlaying();
-  void createPlaylist(const std::string& playlistName);
-  void addVideoToPlaylist(const std::string& playlistName, const std::string& videoId);
+  void createPlaylist(std::string_view playlistName);
+  void addVideoToPlaylist(std::string_view playlistName,
+                          std::string_view videoId);
   void showAllPlaylists();
-  void showPlaylist(const std::string& playlistName);
-  void removeFromPlaylist(const std::string& playlistName, const std::string& videoId);
-  void clearPlaylist(const std::string& playlistName);
-  void deletePlaylist(const std::string& playlistName);
-  void searchVideos(const std::string& searchTerm);
-  void searchVideosWithTag(const std::string& videoTag);
-  void flagVideo(const std::string& videoId);
-  void flagVideo(const std::string& videoId, const std::string& reason);
-  void allowVideo(const std::string& videoId);
-  
+  void showPlaylist(std::string_view playlistName);
+  void removeFromPlaylist(std::string_view playlistName,
+                          std::string_view videoId);
+  void clearPlaylist(std::string_view playlistName);
+  void deletePlaylist(std::string_view playlistName);
+  void searchVideos(std::string_view searchTerm);
+  void searchVideosWithTag(std::string_view videoTag);
+  // Searches as above, but plays the result numbered by selection instead of
+  // asking which one to play.
+  void searchVideos(std::string_view searchTerm, std::string_view selection);
+  void searchVideosWithTag(std::string_view videoTag,
+                           std::string_view selection);
+  void flagVideo(std::string_view videoId);
+  void flagVideo(std::string_view videoId, std::string_view reason);
+  void allowVideo(std::string_view videoId);
+  void reloadLibrary();
+
+  /**
+   * A class used to mark a command in progress on a player's library, so a
+   * concurrent library does not swap its catalog until the command is done.
+   */
+  class CommandScope {
+   private:
+    VideoPlayer* mPlayer;
+
+   public:
+    explicit CommandScope(VideoPlayer* player) : mPlayer(player) {}
+    ~CommandScope() { mPlayer->endCommand(); }
+
+    CommandScope(const CommandScope&) = delete;
+    CommandScope& operator=(const CommandScope&) = delete;
+  };
+
+  // Swaps in a catalog finished by a background reload, if there is one, and
+  // reports it, then follows the library onto its current catalog, which
+  // another player sharing it may have swapped in. The catalog then stays
+  // until the returned scope ends, so a reload never interrupts a command.
+  [[nodiscard]] CommandScope beginCommand();
+
+  // Like beginCommand, between commands.
+  void applyPendingReload() { CommandScope scope = beginCommand(); }
+
+  // Blocks until a background reload has finished building.
+  void waitForReload();
+
+  // Reloads the library whenever its catalog files change on disk.
+  bool watchLibrary();
+
 };
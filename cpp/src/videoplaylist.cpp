@@ -1,33 +1,84 @@
 #include "videoplaylist.h"
 
-VideoPlaylist::VideoPlaylist(std::string name) { mPlaylistID = name; }
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Compacting below this many slots is not worth it.
+constexpr std::size_t kMinCompactSlots = 64;
+
+}  // namespace
+
+VideoPlaylist::VideoPlaylist(std::string name)
+    : mPlaylistID{std::move(name)} {}
 
 const std::string &VideoPlaylist::getPlaylistId() const { return mPlaylistID; }
 
 VideoPlaylist::VideoPlaylist(VideoPlaylist &&v)
-    : mPlaylistID{v.mPlaylistID}, list{v.list} {
+    : list{std::move(v.list)},
+      mSlots{std::move(v.mSlots)},
+      mTombstones{v.mTombstones},
+      mPlaylistID{std::move(v.mPlaylistID)} {
   v.mPlaylistID = "";
   v.list = {};
+  v.mSlots = {};
+  v.mTombstones = 0;
 }
 
 VideoPlaylist::VideoPlaylist(const VideoPlaylist &v) {
   mPlaylistID = v.mPlaylistID;
   list = v.list;
+  mSlots = v.mSlots;
+  mTombstones = v.mTombstones;
 }
 
-std::vector<std::string> VideoPlaylist::getVideoIds() const { return list; }
+std::vector<VideoHandle> VideoPlaylist::getVideoHandles() const {
+  std::vector<VideoHandle> result;
+  result.reserve(size());
+  forEachVideo([&result](VideoHandle video) { result.push_back(video); });
+  return result;
+}
+
+bool VideoPlaylist::contains(VideoHandle video) const {
+  return mSlots.count(video) != 0;
+}
 
-bool VideoPlaylist::contains(const std::string videoId) {
-  return std::find(list.begin(), list.end(), videoId) != list.end();
+void VideoPlaylist::addVideo(VideoHandle video) {
+  if (mSlots.emplace(video, static_cast<std::uint32_t>(list.size())).second) {
+    list.push_back(video);
+  }
 }
 
-void VideoPlaylist::addVideo(const std::string videoId) {
-  list.push_back(videoId);
+void VideoPlaylist::removeVideo(VideoHandle video) {
+  auto found = mSlots.find(video);
+  if (found == mSlots.end()) {
+    return;
+  }
+  list[found->second] = kNoVideo;
+  mSlots.erase(found);
+  ++mTombstones;
+  if (list.size() >= kMinCompactSlots && mTombstones * 2 >= list.size()) {
+    compact();
+  }
 }
 
-void VideoPlaylist::removeVideo(const Video *video) {
-  list.erase(std::remove(list.begin(), list.end(), video->getVideoId()),
-             list.end());
+void VideoPlaylist::clearPlaylist() {
+  list.clear();
+  mSlots.clear();
+  mTombstones = 0;
 }
 
-void VideoPlaylist::clearPlaylist() { list.clear(); }
\ No newline at end of file
+void VideoPlaylist::compact() {
+  mSlots.clear();
+  std::size_t kept = 0;
+  for (VideoHandle video : list) {
+    // Remapping can map two entries to the same video; keep the first.
+    if (video != kNoVideo &&
+        mSlots.emplace(video, static_cast<std::uint32_t>(kept)).second) {
+      list[kept++] = video;
+    }
+  }
+  list.resize(kept);
+  mTombstones = 0;
+}
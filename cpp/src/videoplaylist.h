@@ -1,19 +1,33 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "video.h"
-/** A class used to represent a Playlist */
-
+/**
+ * A class used to represent a Playlist. The videos are kept in the order
+ * they were added, with an index from each video to its slot, so membership
+ * and removal are O(1). A removed video leaves a tombstone (kNoVideo) in
+ * its slot, and the slots are compacted once tombstones make up half of
+ * them, which keeps removal amortized O(1).
+ */
 class VideoPlaylist
 {
 private:
-    std::vector<std::string> list;
+    std::vector<VideoHandle> list;
+    std::unordered_map<VideoHandle, std::uint32_t> mSlots;
+    std::size_t mTombstones = 0;
     std::string mPlaylistID;
 
+    // Drops the tombstones and renumbers the slots.
+    void compact();
+
 public:
-    VideoPlaylist(const std::string name);
+    VideoPlaylist(std::string name);
 
     VideoPlaylist(const VideoPlaylist &v);
 
@@ -21,18 +35,55 @@ public:
     VideoPlaylist(VideoPlaylist &&);
     VideoPlaylist &operator=(VideoPlaylist &&v)
     {
-        mPlaylistID = v.mPlaylistID;
-        list = v.list;
+        mPlaylistID = std::move(v.mPlaylistID);
+        list = std::move(v.list);
+        mSlots = std::move(v.mSlots);
+        mTombstones = v.mTombstones;
         v.mPlaylistID = "";
         v.list = {};
+        v.mSlots = {};
+        v.mTombstones = 0;
         return *this;
     }
 
-    std::vector<std::string> getVideoIds() const;
+    // Returns the handles of the videos, in the order they were added.
+    std::vector<VideoHandle> getVideoHandles() const;
+    // Calls visit with the handle of each video, in the order they were
+    // added.
+    template <typename Visitor>
+    void forEachVideo(Visitor &&visit) const
+    {
+        for (VideoHandle video : list)
+        {
+            if (video != kNoVideo)
+            {
+                visit(video);
+            }
+        }
+    }
+    std::size_t size() const { return mSlots.size(); }
     // Returns the playlist id of the playlist.
     const std::string &getPlaylistId() const;
-    void addVideo(const std::string videoId);
-    void removeVideo(const Video *video);
+    void addVideo(VideoHandle video);
+    void removeVideo(VideoHandle video);
     void clearPlaylist();
-    bool contains(const std::string videoId);
+    bool contains(VideoHandle video) const;
+
+    // Replaces each handle with remap(handle), dropping the videos it maps
+    // to kNoVideo, and returns how many were dropped. Used to move the
+    // playlist onto a reloaded catalog.
+    template <typename Remap>
+    std::size_t remapVideos(Remap remap)
+    {
+        std::size_t before = size();
+        for (VideoHandle &video : list)
+        {
+            if (video != kNoVideo)
+            {
+                video = remap(video);
+            }
+        }
+        compact();
+        return before - size();
+    }
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "span.h"
+
+/**
+ * A class used to hold one of an index's tables of 32-bit words: either a
+ * table built in memory, which it owns, or a view of one stored in a mapped
+ * snapshot, which must outlive it. Lookups read through the same view
+ * either way, so a snapshot's tables are used in place instead of copied.
+ */
+class WordArray {
+ private:
+  std::vector<std::uint32_t> mOwned;
+  Span<std::uint32_t> mWords;
+
+ public:
+  WordArray() = default;
+
+  // Moving keeps the view valid: the owned buffer moves with it.
+  WordArray(WordArray&& other) noexcept
+      : mOwned(std::move(other.mOwned)),
+        mWords(std::exchange(other.mWords, Span<std::uint32_t>())) {}
+  WordArray& operator=(WordArray&& other) noexcept {
+    mOwned = std::move(other.mOwned);
+    mWords = std::exchange(other.mWords, Span<std::uint32_t>());
+    return *this;
+  }
+
+  // This class is not copyable, a copy would still view the original.
+  WordArray(const WordArray&) = delete;
+  WordArray& operator=(const WordArray&) = delete;
+
+  // Takes over words built in memory.
+  void assign(std::vector<std::uint32_t>&& words) {
+    mOwned = std::move(words);
+    mWords = Span<std::uint32_t>(mOwned.data(), mOwned.size());
+  }
+  // Views words stored elsewhere, releasing any owned ones.
+  void assign(Span<std::uint32_t> words) {
+    mOwned = std::vector<std::uint32_t>();
+    mWords = words;
+  }
+
+  // Overwrites one word of a table built in memory.
+  void set(std::size_t index, std::uint32_t word) { mOwned[index] = word; }
+
+  Span<std::uint32_t> span() const { return mWords; }
+  const std::uint32_t* begin() const { return mWords.begin(); }
+  const std::uint32_t* end() const { return mWords.end(); }
+  const std::uint32_t* data() const { return mWords.data(); }
+  std::size_t size() const { return mWords.size(); }
+  bool empty() const { return mWords.empty(); }
+  std::uint32_t operator[](std::size_t index) const { return mWords[index]; }
+};
@@ -0,0 +1,96 @@
+#include "../src/casefold.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+// Draws from a small alphabet that includes both cases, the bytes either
+// side of the letter ranges and non-ASCII bytes, so matches are common and
+// every branch of the fold is exercised.
+std::string randomString(std::mt19937& rng, std::size_t size) {
+  static const char alphabet[] = "aAbB`@[{zZ\x80\xe1\xc1 ";
+  std::string result(size, ' ');
+  for (char& c : result) {
+    c = alphabet[rng() % (sizeof(alphabet) - 1)];
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(CaseFold, testFoldAsciiMatchesScalar) {
+  std::string all;
+  for (int c = 0; c < 256; ++c) {
+    all += static_cast<char>(c);
+  }
+  all += all;
+  std::string expected = all;
+  foldAsciiScalar(expected.data(), expected.size());
+  foldAscii(all.data(), all.size());
+  EXPECT_EQ(all, expected);
+  EXPECT_EQ(expected.substr('a', 26), "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+  EXPECT_EQ(expected['z' + 1], '{');
+  EXPECT_EQ(expected[0xe1], '\xe1');
+}
+
+TEST(CaseFold, testFindFoldedMatchesScalar) {
+  std::mt19937 rng(7);
+  // Lengths straddle the 16 and 32 byte blocks.
+  for (std::size_t haystackSize : {0, 1, 15, 16, 17, 31, 32, 33, 47, 64, 100}) {
+    for (std::size_t needleSize : {0, 1, 2, 3, 5, 17, 33}) {
+      for (int trial = 0; trial < 50; ++trial) {
+        std::string haystack = randomString(rng, haystackSize);
+        std::string needle = randomString(rng, needleSize);
+        foldAsciiScalar(needle.data(), needle.size());
+        EXPECT_EQ(findFolded(haystack, needle),
+                  findFoldedScalar(haystack, needle))
+            << "haystack: " << haystack << ", needle: " << needle;
+      }
+    }
+  }
+}
+
+TEST(CaseFold, testFindFoldedFindsFirstMatch) {
+  EXPECT_EQ(findFolded("Amazing Cats", "CATS"), 8);
+  EXPECT_EQ(findFolded("Amazing Cats", "DOGS"), std::string_view::npos);
+  std::string text(100, 'x');
+  text += "Needle needle";
+  EXPECT_EQ(findFolded(text, "NEEDLE"), 100);
+  EXPECT_EQ(findFolded(text, ""), 0);
+  // A folded needle never matches a lower-case letter in it.
+  EXPECT_EQ(findFolded("abc", "abc"), std::string_view::npos);
+}
+
+TEST(CaseFold, testEqualsFoldedMatchesScalar) {
+  std::mt19937 rng(11);
+  for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 64, 65}) {
+    for (int trial = 0; trial < 50; ++trial) {
+      std::string a = randomString(rng, size);
+      std::string b = a;
+      // Flip the case of some letters, and sometimes change a byte.
+      for (char& c : b) {
+        if (rng() % 3 == 0) {
+          c = c >= 'a' && c <= 'z'   ? static_cast<char>(c - 32)
+              : c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32)
+                                     : c;
+        }
+      }
+      if (size && trial % 2) {
+        b[rng() % size] = '@';
+      }
+      EXPECT_EQ(equalsFolded(a, b), equalsFoldedScalar(a, b));
+    }
+  }
+  EXPECT_TRUE(equalsFolded("My_Playlist", "MY_PLAYLIST"));
+  EXPECT_FALSE(equalsFolded("My_Playlist", "My_Playlist2"));
+  EXPECT_FALSE(equalsFolded("@", "`"));
+}
+
+TEST(CaseFold, testHashFoldedIgnoresCase) {
+  EXPECT_EQ(hashFolded("My_Playlist"), hashFolded("mY_pLAYLIST"));
+  EXPECT_NE(hashFolded("My_Playlist"), hashFolded("My_Playlist2"));
+}
@@ -0,0 +1,110 @@
+#include "../src/cataloggenerator.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../src/videolibrary.h"
+
+namespace {
+
+std::string generate(const CatalogOptions& options) {
+  std::ostringstream out;
+  EXPECT_TRUE(CatalogGenerator(options).write(out));
+  return out.str();
+}
+
+void writeCatalog(const std::string& path, const CatalogOptions& options) {
+  std::ofstream(path, std::ios::binary) << generate(options);
+}
+
+}  // namespace
+
+TEST(CatalogGenerator, testEdgeCasesParseToEveryRow) {
+  std::string path = "./cataloggenerator_edge.txt";
+  CatalogOptions options;
+  options.rows = 2000;
+  options.edgeCaseRate = 0.5;
+  std::string catalog = generate(options);
+  EXPECT_NE(catalog.find("Caf\xC3\xA9"), std::string::npos);
+  EXPECT_NE(catalog.find(",,"), std::string::npos);
+  EXPECT_NE(catalog.find('\t'), std::string::npos);
+  EXPECT_NE(catalog.back(), '\n');
+  std::ofstream(path, std::ios::binary) << catalog;
+
+  VideoLibrary serial(path, 1);
+  VideoLibrary parallel(path, 4);
+  ASSERT_EQ(serial.size(), options.rows);
+  ASSERT_EQ(parallel.size(), options.rows);
+  std::size_t untagged = 0;
+  for (std::size_t row = 0; row < options.rows; ++row) {
+    std::string id = "video_" + std::to_string(row) + "_id";
+    const Video* video = serial.getVideo(id);
+    ASSERT_NE(video, nullptr) << id;
+    std::string title(video->getTitle());
+    // Padding is trimmed away, leaving the row number last.
+    EXPECT_EQ(title.substr(title.rfind(' ') + 1), std::to_string(row));
+    EXPECT_NE(title.front(), ' ');
+    EXPECT_EQ(parallel.getVideo(id)->getTitle(), title);
+    untagged += video->getTags().empty();
+  }
+  EXPECT_GT(untagged, 0);
+  std::remove(path.c_str());
+}
+
+TEST(CatalogGenerator, testSeedFixesTheCatalog) {
+  CatalogOptions options;
+  options.edgeCaseRate = 0.1;
+  std::string first = generate(options);
+  EXPECT_EQ(first, generate(options));
+  options.seed = 7;
+  EXPECT_NE(first, generate(options));
+}
+
+TEST(CatalogGenerator, testTitleWords) {
+  CatalogOptions options;
+  options.rows = 200;
+  options.minTitleWords = 3;
+  options.maxTitleWords = 3;
+  std::istringstream catalog(generate(options));
+  std::string line;
+  while (std::getline(catalog, line)) {
+    std::string title = line.substr(0, line.find(" |"));
+    // Three words and the row number.
+    EXPECT_EQ(std::count(title.begin(), title.end(), ' '), 3) << line;
+  }
+}
+
+TEST(CatalogGenerator, testZipfTagPopularity) {
+  std::string path = "./cataloggenerator_zipf.txt";
+  CatalogOptions options;
+  options.rows = 20000;
+  options.tagVocabulary = 100;
+  options.maxTagsPerVideo = 1;
+  writeCatalog(path, options);
+  {
+    VideoLibrary library(path);
+    // The most popular tag is drawn about ten times as often as the tenth.
+    std::size_t first = library.findVideosWithTag("#tag0").size();
+    std::size_t tenth = library.findVideosWithTag("#tag9").size();
+    EXPECT_GT(first, 5 * tenth);
+    EXPECT_LT(first, 20 * tenth);
+    EXPECT_TRUE(library.findVideosWithTag("#tag100").empty());
+  }
+
+  options.tagSkew = 0;
+  writeCatalog(path, options);
+  {
+    VideoLibrary library(path);
+    std::size_t first = library.findVideosWithTag("#tag0").size();
+    std::size_t tenth = library.findVideosWithTag("#tag9").size();
+    EXPECT_LT(first, 2 * tenth);
+    EXPECT_LT(tenth, 2 * first);
+  }
+  std::remove(path.c_str());
+}
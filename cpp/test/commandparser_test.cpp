@@ -0,0 +1,160 @@
+#include "../src/commandparser.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#include "../src/outputsink.h"
+#include "../src/videoplayer.h"
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TEST(CommandParser, testExecuteLine) {
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{sink});
+  EXPECT_TRUE(parser.executeLine("play amazing_cats_video_id"));
+  EXPECT_THAT(sink->take(), HasSubstr("Playing video: Amazing Cats"));
+  EXPECT_TRUE(parser.executeLine(""));
+  EXPECT_THAT(sink->take(), HasSubstr("Please enter a valid command"));
+  EXPECT_FALSE(parser.executeLine("exit"));
+}
+
+TEST(CommandParser, testBatchSearchTakesInlineSelection) {
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{sink});
+  std::istringstream input(
+      "SEARCH_VIDEOS cat 2\n"
+      "\n"
+      "SEARCH_VIDEOS_WITH_TAG #dog\n"
+      "SHOW_PLAYING\n"
+      "EXIT\n"
+      "STOP\n");
+  EXPECT_EQ(parser.executeBatch(input), 3);
+  std::string output = sink->take();
+  EXPECT_THAT(output, HasSubstr("Playing video: Another Cat Video"));
+  EXPECT_THAT(output, HasSubstr("Here are the results for #dog:"));
+  // The search without a selection asks nothing and leaves SHOW_PLAYING to
+  // run as a command.
+  EXPECT_THAT(output, Not(HasSubstr("Would you like to play")));
+  EXPECT_THAT(output, HasSubstr("Currently playing: Another Cat Video"));
+  EXPECT_THAT(output, Not(HasSubstr("Stopping video")));
+}
+
+TEST(CommandParser, testInteractiveSearchTakesInlineSelection) {
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{sink});
+  // An inline selection is not followed by a question, even interactively.
+  std::streambuf* orig = std::cin.rdbuf();
+  std::istringstream input("1");
+  std::cin.rdbuf(input.rdbuf());
+  parser.executeLine("SEARCH_VIDEOS_WITH_TAG #cat 2");
+  std::cin.rdbuf(orig);
+  std::string output = sink->take();
+  EXPECT_THAT(output, HasSubstr("Playing video: Another Cat Video"));
+  EXPECT_THAT(output, Not(HasSubstr("Would you like to play")));
+  EXPECT_EQ(input.tellg(), 0);
+}
+
+TEST(CommandParser, testCommandsIgnoreCaseAndCheckArity) {
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{sink});
+  parser.executeLine("Create_Playlist\tmy_playlist");
+  EXPECT_THAT(sink->take(),
+              HasSubstr("Successfully created new playlist: my_playlist"));
+  parser.executeLine("stop now");
+  EXPECT_EQ(sink->take(), "Cannot stop video: No video is currently playing\n");
+  parser.executeLine("STOPS");
+  EXPECT_THAT(sink->take(), HasSubstr("Please enter a valid command"));
+  EXPECT_FALSE(parser.executeLine("Exit now"));
+}
+
+TEST(CommandParser, testUsageMessages) {
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{sink});
+  parser.executeLine("PLAY");
+  EXPECT_EQ(sink->take(),
+            "Please enter PLAY command followed by video_id.\n");
+  parser.executeLine("CREATE_PLAYLIST a b");
+  EXPECT_EQ(sink->take(),
+            "Please enter CREATE_PLAYLIST command followed by video_id.\n");
+  parser.executeLine("ADD_TO_PLAYLIST my_playlist");
+  EXPECT_EQ(sink->take(),
+            "Please enter ADD_TO_PLAYLIST command followed by playlist name "
+            "and video_id.\n");
+  parser.executeLine("REMOVE_FROM_PLAYLIST");
+  EXPECT_EQ(sink->take(),
+            "Please enter REMOVE_FROM_PLAYLIST command followed by playlist "
+            "name and video_id.\n");
+  parser.executeLine("CLEAR_PLAYLIST");
+  EXPECT_EQ(sink->take(),
+            "Please enter CLEAR_PLAYLIST command followed by a playlist "
+            "name.\n");
+  parser.executeLine("DELETE_PLAYLIST");
+  EXPECT_EQ(sink->take(),
+            "Please enter DELETE_PLAYLIST command followed by a playlist "
+            "name.\n");
+  parser.executeLine("SHOW_PLAYLIST");
+  EXPECT_EQ(sink->take(),
+            "Please enter SHOW_PLAYLIST command followed by a playlist "
+            "name.\n");
+  parser.executeLine("SEARCH_VIDEOS");
+  EXPECT_EQ(sink->take(),
+            "Please enter SEARCH_VIDEOS command followed by a search term and "
+            "an optional result number.\n");
+  parser.executeLine("SEARCH_VIDEOS_WITH_TAG a b c");
+  EXPECT_EQ(sink->take(),
+            "Please enter SEARCH_VIDEOS_WITH_TAG command followed by a video "
+            "tag and an optional result number.\n");
+  parser.executeLine("FLAG_VIDEO a b c");
+  EXPECT_EQ(sink->take(),
+            "Please enter FLAG_VIDEO command followed by a video_id and an "
+            "optional flag reason.\n");
+  parser.executeLine("ALLOW_VIDEO");
+  EXPECT_EQ(sink->take(),
+            "Please enter ALLOW_VIDEO command followed by a video_id.\n");
+}
+
+#if !defined(_WIN32)
+TEST(CommandParser, testReportsChangesThatCannotBePersisted) {
+  std::string path = "./commandparser_changes.wal";
+  std::remove(path.c_str());
+  VideoLibrary library;
+  ASSERT_TRUE(library.openLog(path));
+  auto sink = std::make_shared<MemorySink>();
+  CommandParser parser(VideoPlayer{std::move(library), sink});
+  // Keep the log from growing, so its next write fails.
+  rlimit limit{};
+  ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &limit), 0);
+  rlimit capped = limit;
+  capped.rlim_cur = std::filesystem::file_size(path);
+  auto handler = std::signal(SIGXFSZ, SIG_IGN);
+  ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &capped), 0);
+  parser.executeLine("FLAG_VIDEO amazing_cats_video_id");
+  parser.executeLine("CREATE_PLAYLIST my_list");
+  parser.executeLine("SHOW_ALL_PLAYLISTS");
+  setrlimit(RLIMIT_FSIZE, &limit);
+  std::signal(SIGXFSZ, handler);
+  std::string output = sink->take();
+  EXPECT_THAT(output, HasSubstr("Successfully flagged video: Amazing Cats"));
+  EXPECT_THAT(output, HasSubstr("Cannot persist change: Couldn't write " +
+                                path));
+  // Once the log has failed, changes are refused rather than acknowledged.
+  EXPECT_THAT(output, HasSubstr("Cannot create playlist: Cannot persist "
+                                "change to " + path));
+  EXPECT_THAT(output, HasSubstr("No playlists exist yet"));
+  std::remove(path.c_str());
+}
+#endif
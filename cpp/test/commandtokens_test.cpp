@@ -0,0 +1,25 @@
+#include "../src/commandtokens.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(CommandTokens, testSplitsOnSpacesAndTabs) {
+  std::string line = "  ADD_TO_PLAYLIST \tmy_playlist  video_id\r";
+  CommandTokens tokens(line);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0], "ADD_TO_PLAYLIST");
+  EXPECT_EQ(tokens[1], "my_playlist");
+  EXPECT_EQ(tokens[2], "video_id");
+  // The tokens point into the line rather than copying it.
+  EXPECT_EQ(tokens[1].data(), line.data() + line.find("my_playlist"));
+}
+
+TEST(CommandTokens, testEmptyAndLongLines) {
+  EXPECT_TRUE(CommandTokens("").empty());
+  EXPECT_TRUE(CommandTokens(" \t ").empty());
+  CommandTokens tokens("a b c d e f");
+  EXPECT_EQ(tokens.size(), 6);
+  EXPECT_EQ(tokens[CommandTokens::kMaxTokens - 1], "d");
+}
@@ -0,0 +1,181 @@
+#include "../src/commandgate.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../src/outputsink.h"
+#include "../src/sessionmanager.h"
+#include "../src/videolibrary.h"
+
+namespace {
+
+std::size_t countOccurrences(std::string_view text, std::string_view word) {
+  std::size_t count = 0;
+  for (std::size_t at = text.find(word); at != std::string_view::npos;
+       at = text.find(word, at + word.size())) {
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST(CommandGate, testExclusiveWaitsForCommands) {
+  CommandGate gate;
+  std::atomic<int> inside{0};
+  std::atomic<bool> overlapped{false};
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 4; ++thread) {
+    threads.emplace_back([&] {
+      while (!stop) {
+        gate.enter();
+        ++inside;
+        std::this_thread::yield();
+        --inside;
+        gate.leave();
+      }
+    });
+  }
+  for (int swap = 0; swap < 200; ++swap) {
+    gate.lockExclusive();
+    if (inside != 0) {
+      overlapped = true;
+    }
+    gate.unlockExclusive();
+  }
+  stop = true;
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_FALSE(overlapped);
+}
+
+TEST(ConcurrentLibrary, testEnableKeepsPlaylistsAndFlags) {
+  VideoLibrary library;
+  library.createPlaylist("My_List")->addVideo(2);
+  library.addFlag(1, "dont_like");
+  library.enableConcurrency(8);
+  EXPECT_TRUE(library.isConcurrent());
+  EXPECT_EQ(library.playlistCount(), 1);
+  ASSERT_NE(library.getPlaylist("my_list"), nullptr);
+  EXPECT_EQ(library.getPlaylist("my_list")->getPlaylistId(), "My_List");
+  EXPECT_TRUE(library.getPlaylist("my_list")->contains(2));
+  EXPECT_TRUE(library.isFlagged(1));
+  ASSERT_NE(library.getFlag(1), nullptr);
+  EXPECT_EQ(*library.getFlag(1), "dont_like");
+  EXPECT_FALSE(library.addFlag(1, "again"));
+  EXPECT_TRUE(library.deletePlaylist(std::string_view("MY_LIST")));
+  EXPECT_EQ(library.playlistCount(), 0);
+}
+
+TEST(ConcurrentLibrary, testStressSharedSessions) {
+  const int threadCount = 8;
+  const int commandsPerThread = 3000;
+  const char* videoIds[] = {"funny_dogs_video_id", "amazing_cats_video_id",
+                            "another_cat_video_id", "life_at_google_video_id",
+                            "nothing_video_id"};
+  const char* playlists[] = {"alpha", "Beta", "gamma", "Delta"};
+
+  SessionManager manager{VideoLibrary()};
+  manager.enableConcurrency(4);
+  std::vector<std::shared_ptr<MemorySink>> sinks;
+  std::vector<SessionManager::SessionId> sessions;
+  for (int thread = 0; thread < threadCount; ++thread) {
+    sinks.push_back(std::make_shared<MemorySink>());
+    sessions.push_back(manager.open(SessionScope::Shared, sinks.back()));
+  }
+
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threadCount; ++thread) {
+    threads.emplace_back([&, thread] {
+      std::mt19937 rng(thread);
+      for (int step = 0; step < commandsPerThread; ++step) {
+        std::string video = videoIds[rng() % 5];
+        std::string playlist = playlists[rng() % 4];
+        std::string line;
+        switch (rng() % 10) {
+          case 0:
+            line = "PLAY " + video;
+            break;
+          case 1:
+            line = "FLAG_VIDEO " + video + " reason_" + std::to_string(thread);
+            break;
+          case 2:
+            line = "ALLOW_VIDEO " + video;
+            break;
+          case 3:
+            line = "CREATE_PLAYLIST " + playlist;
+            break;
+          case 4:
+            line = "ADD_TO_PLAYLIST " + playlist + " " + video;
+            break;
+          case 5:
+            line = "REMOVE_FROM_PLAYLIST " + playlist + " " + video;
+            break;
+          case 6:
+            line = "DELETE_PLAYLIST " + playlist;
+            break;
+          case 7:
+            line = "SHOW_PLAYLIST " + playlist;
+            break;
+          case 8:
+            line = "PLAY_RANDOM";
+            break;
+          default:
+            // Every so often, swap the catalog under the other threads.
+            line = thread == 0 && step % 500 == 0 ? "RELOAD_LIBRARY"
+                                                  : "SHOW_ALL_PLAYLISTS";
+            break;
+        }
+        manager.executeLine(sessions[thread], line);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  VideoLibrary& library = manager.getSharedLibrary();
+  library.waitForReload();
+  manager.executeLine(sessions[0], "NUMBER_OF_VIDEOS");
+
+  // Every change reported as made was made exactly once.
+  std::size_t flagged = 0;
+  std::size_t allowed = 0;
+  std::size_t created = 0;
+  std::size_t deleted = 0;
+  for (const auto& sink : sinks) {
+    flagged += countOccurrences(sink->str(), "Successfully flagged video");
+    allowed += countOccurrences(sink->str(), "Successfully removed flag");
+    created += countOccurrences(sink->str(), "Successfully created");
+    deleted += countOccurrences(sink->str(), "Deleted playlist");
+  }
+  EXPECT_GT(flagged, 0);
+  EXPECT_GT(created, 0);
+  EXPECT_EQ(library.flagCount(), flagged - allowed);
+  EXPECT_EQ(library.playlistCount(), created - deleted);
+
+  std::size_t flaggedVideos = 0;
+  for (VideoHandle video = 0; video < library.size(); ++video) {
+    flaggedVideos += library.isFlagged(video);
+  }
+  EXPECT_EQ(flaggedVideos, library.flagCount());
+  library.forEachPlaylist([&](const VideoPlaylist& playlist) {
+    const auto& videos = playlist.getVideoHandles();
+    EXPECT_EQ(std::set<VideoHandle>(videos.begin(), videos.end()).size(),
+              videos.size());
+    for (VideoHandle video : videos) {
+      EXPECT_LT(video, library.size());
+    }
+  });
+}
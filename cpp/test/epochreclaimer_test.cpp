@@ -0,0 +1,111 @@
+#include "../src/epochreclaimer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/concurrentflagstore.h"
+
+namespace {
+
+std::atomic<int> gDestroyed{0};
+
+struct Counted : EpochReclaimer::Retired {
+  ~Counted() override { ++gDestroyed; }
+};
+
+// Reclaims until nothing is pending, or gives up after a few rounds.
+std::size_t drain() {
+  std::size_t pending = EpochReclaimer::global().reclaim();
+  for (int round = 0; pending != 0 && round < 8; ++round) {
+    pending = EpochReclaimer::global().reclaim();
+  }
+  return pending;
+}
+
+}  // namespace
+
+TEST(EpochReclaimer, testGuardDelaysFree) {
+  drain();
+  gDestroyed = 0;
+  {
+    EpochReclaimer::Guard guard;
+    EpochReclaimer::global().retire(new Counted);
+    {
+      // Guards nest.
+      EpochReclaimer::Guard inner;
+    }
+    drain();
+    EXPECT_EQ(gDestroyed, 0);
+  }
+  EXPECT_EQ(drain(), 0);
+  EXPECT_EQ(gDestroyed, 1);
+}
+
+TEST(EpochReclaimer, testReaderOnAnotherThreadDelaysFree) {
+  drain();
+  gDestroyed = 0;
+  std::atomic<bool> pinned{false};
+  std::atomic<bool> release{false};
+  std::thread reader([&] {
+    EpochReclaimer::Guard guard;
+    pinned = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!pinned) {
+    std::this_thread::yield();
+  }
+  EpochReclaimer::global().retire(new Counted);
+  drain();
+  EXPECT_EQ(gDestroyed, 0);
+  release = true;
+  reader.join();
+  EXPECT_EQ(drain(), 0);
+  EXPECT_EQ(gDestroyed, 1);
+}
+
+TEST(EpochReclaimer, testReadersSeeWholeReasonsDuringChurn) {
+  const std::size_t videoCount = 64;
+  ConcurrentFlagStore flags(videoCount);
+  std::atomic<bool> stop{false};
+  std::atomic<bool> torn{false};
+  std::vector<std::thread> readers;
+  for (int thread = 0; thread < 3; ++thread) {
+    readers.emplace_back([&, thread] {
+      std::mt19937 rng(thread);
+      while (!stop) {
+        VideoHandle video = rng() % videoCount;
+        flags.withReason(video, [&](const std::string& reason) {
+          // Every reason a writer installs names its video.
+          if (reason != "reason for " + std::to_string(video)) {
+            torn = true;
+          }
+        });
+      }
+    });
+  }
+  std::mt19937 rng(9);
+  for (int step = 0; step < 100000; ++step) {
+    VideoHandle video = rng() % videoCount;
+    if (rng() % 2) {
+      flags.flag(video, "reason for " + std::to_string(video));
+    } else {
+      flags.allow(video);
+    }
+  }
+  stop = true;
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  EXPECT_FALSE(torn);
+  EXPECT_EQ(flags.size(), flags.flaggedVideos().size());
+  // With the readers gone, everything allowed is freed.
+  EXPECT_EQ(drain(), 0);
+}
@@ -0,0 +1,167 @@
+#include "../src/flagstore.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/concurrentflagstore.h"
+
+TEST(FlagStore, testFlagAndAllow) {
+  FlagStore flags(3);
+  EXPECT_THAT(flags.playable(), ::testing::UnorderedElementsAre(0, 1, 2));
+  EXPECT_TRUE(flags.flag(1, "reason"));
+  EXPECT_FALSE(flags.flag(1, "again"));
+  EXPECT_TRUE(flags.isFlagged(1));
+  ASSERT_NE(flags.reason(1), nullptr);
+  EXPECT_EQ(*flags.reason(1), "reason");
+  EXPECT_EQ(flags.reason(0), nullptr);
+  EXPECT_EQ(flags.reason(kNoVideo), nullptr);
+  EXPECT_EQ(flags.size(), 1);
+  EXPECT_THAT(flags.playable(), ::testing::UnorderedElementsAre(0, 2));
+  EXPECT_TRUE(flags.allow(1));
+  EXPECT_FALSE(flags.allow(1));
+  EXPECT_FALSE(flags.isFlagged(1));
+  EXPECT_THAT(flags.playable(), ::testing::UnorderedElementsAre(0, 1, 2));
+}
+
+TEST(FlagStore, testRefusesVideosOutsideCatalog) {
+  FlagStore empty;
+  EXPECT_FALSE(empty.flag(0, "reason"));
+  EXPECT_FALSE(empty.isFlagged(0));
+  EXPECT_EQ(empty.size(), 0);
+  FlagStore flags(3);
+  EXPECT_TRUE(flags.flag(0, "reason"));
+  EXPECT_FALSE(flags.flag(3, "reason"));
+  EXPECT_FALSE(flags.flag(kNoVideo, "reason"));
+  EXPECT_FALSE(flags.isFlagged(kNoVideo));
+  EXPECT_FALSE(flags.allow(kNoVideo));
+  EXPECT_EQ(flags.size(), 1);
+  EXPECT_THAT(flags.playable(), ::testing::UnorderedElementsAre(1, 2));
+}
+
+TEST(FlagStore, testRandomOperationsMatchReference) {
+  // Crosses a bitmap word boundary.
+  const std::size_t videoCount = 130;
+  FlagStore flags(videoCount);
+  std::map<VideoHandle, std::string> expected;
+  std::mt19937 rng(3);
+  for (int step = 0; step < 5000; ++step) {
+    VideoHandle video = rng() % videoCount;
+    if (rng() % 2) {
+      std::string reason = "reason " + std::to_string(step);
+      EXPECT_EQ(flags.flag(video, reason), expected.emplace(video, reason).second);
+    } else {
+      EXPECT_EQ(flags.allow(video), expected.erase(video) == 1);
+    }
+  }
+  EXPECT_EQ(flags.size(), expected.size());
+  std::vector<VideoHandle> playable = flags.playable();
+  std::sort(playable.begin(), playable.end());
+  std::vector<VideoHandle> expectedPlayable;
+  for (VideoHandle video = 0; video < videoCount; ++video) {
+    auto found = expected.find(video);
+    EXPECT_EQ(flags.isFlagged(video), found != expected.end());
+    if (found == expected.end()) {
+      expectedPlayable.push_back(video);
+      EXPECT_EQ(flags.reason(video), nullptr);
+    } else {
+      ASSERT_NE(flags.reason(video), nullptr);
+      EXPECT_EQ(*flags.reason(video), found->second);
+    }
+  }
+  EXPECT_EQ(playable, expectedPlayable);
+}
+
+TEST(FlagStore, testRemapped) {
+  FlagStore flags(4);
+  flags.flag(0, "zero");
+  flags.flag(3, "three");
+  std::size_t dropped = 0;
+  // Video 0 is gone and the rest move down by one.
+  FlagStore remapped = flags.remapped(
+      3, [](VideoHandle video) { return video == 0 ? kNoVideo : video - 1; },
+      &dropped);
+  EXPECT_EQ(dropped, 1);
+  EXPECT_EQ(remapped.size(), 1);
+  ASSERT_NE(remapped.reason(2), nullptr);
+  EXPECT_EQ(*remapped.reason(2), "three");
+  EXPECT_THAT(remapped.playable(), ::testing::UnorderedElementsAre(0, 1));
+}
+
+TEST(ConcurrentFlagStore, testMatchesFlagStore) {
+  const std::size_t videoCount = 130;
+  FlagStore flags(videoCount);
+  ConcurrentFlagStore concurrent(videoCount);
+  std::mt19937 rng(7);
+  for (int step = 0; step < 5000; ++step) {
+    VideoHandle video = rng() % videoCount;
+    if (rng() % 2) {
+      std::string reason = "reason " + std::to_string(step);
+      EXPECT_EQ(concurrent.flag(video, reason), flags.flag(video, reason));
+    } else {
+      EXPECT_EQ(concurrent.allow(video), flags.allow(video));
+    }
+  }
+  EXPECT_EQ(concurrent.size(), flags.size());
+  for (VideoHandle video = 0; video < videoCount; ++video) {
+    EXPECT_EQ(concurrent.isFlagged(video), flags.isFlagged(video));
+    std::string reason;
+    EXPECT_EQ(concurrent.withReason(
+                  video, [&](const std::string& found) { reason = found; }),
+              flags.isFlagged(video));
+    EXPECT_EQ(reason, flags.isFlagged(video) ? *flags.reason(video) : "");
+  }
+  EXPECT_FALSE(concurrent.isFlagged(kNoVideo));
+  EXPECT_FALSE(concurrent.flag(videoCount, "reason"));
+  EXPECT_FALSE(concurrent.flag(kNoVideo, "reason"));
+  EXPECT_THAT(concurrent.flaggedVideos(),
+              ::testing::UnorderedElementsAreArray(flags.flaggedVideos()));
+}
+
+TEST(ConcurrentFlagStore, testRandomPlayable) {
+  ConcurrentFlagStore flags(100);
+  for (VideoHandle video = 0; video < 100; ++video) {
+    if (video != 42) {
+      flags.flag(video, "reason");
+    }
+  }
+  std::minstd_rand random(1);
+  // Nearly everything is flagged, so this falls back to scanning.
+  EXPECT_EQ(flags.randomPlayable(random), 42);
+  flags.flag(42, "reason");
+  EXPECT_EQ(flags.randomPlayable(random), kNoVideo);
+  flags.allow(7);
+  flags.allow(8);
+  for (int draw = 0; draw < 20; ++draw) {
+    EXPECT_THAT(flags.randomPlayable(random), ::testing::AnyOf(7, 8));
+  }
+}
+
+TEST(ConcurrentFlagStore, testRandomPlayableIsUniform) {
+  // Few enough playable videos that most picks come from the scan, bunched
+  // so that a pick biased towards the one after a flagged run shows.
+  const std::size_t videoCount = 1000;
+  const VideoHandle playable[] = {10, 11, 12, 500};
+  ConcurrentFlagStore flags(videoCount);
+  for (VideoHandle video = 0; video < videoCount; ++video) {
+    if (std::find(std::begin(playable), std::end(playable), video) ==
+        std::end(playable)) {
+      flags.flag(video, "reason");
+    }
+  }
+  std::minstd_rand random(5);
+  std::map<VideoHandle, int> picks;
+  for (int draw = 0; draw < 4000; ++draw) {
+    ++picks[flags.randomPlayable(random)];
+  }
+  ASSERT_EQ(picks.size(), 4);
+  for (VideoHandle video : playable) {
+    EXPECT_NEAR(picks[video], 1000, 120) << video;
+  }
+}
@@ -0,0 +1,64 @@
+#include "../src/latencyhistogram.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+
+TEST(LatencyHistogram, testEmpty) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.percentile(0.5), 0);
+  EXPECT_EQ(histogram.mean(), 0);
+}
+
+TEST(LatencyHistogram, testSmallValuesAreExact) {
+  LatencyHistogram histogram;
+  for (std::uint64_t value = 1; value <= 50; ++value) {
+    histogram.record(value);
+  }
+  EXPECT_EQ(histogram.percentile(0.5), 25);
+  EXPECT_EQ(histogram.percentile(0.75), 38);
+  EXPECT_EQ(histogram.percentile(1), 50);
+  EXPECT_EQ(histogram.percentile(0), 1);
+  EXPECT_DOUBLE_EQ(histogram.mean(), 25.5);
+}
+
+TEST(LatencyHistogram, testPercentilesWithinBucketError) {
+  LatencyHistogram histogram;
+  for (std::uint64_t value = 1; value <= 1000000; ++value) {
+    histogram.record(value);
+  }
+  for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+    double exact = quantile * 1000000;
+    auto reported = static_cast<double>(histogram.percentile(quantile));
+    EXPECT_GE(reported, exact) << quantile;
+    EXPECT_LE(reported, exact * (1 + 1.0 / 32)) << quantile;
+  }
+  EXPECT_EQ(histogram.percentile(1), 1000000);
+  EXPECT_EQ(histogram.max(), 1000000);
+}
+
+TEST(LatencyHistogram, testMerge) {
+  LatencyHistogram fast;
+  LatencyHistogram slow;
+  for (int sample = 0; sample < 990; ++sample) {
+    fast.record(10);
+  }
+  for (int sample = 0; sample < 10; ++sample) {
+    slow.record(5000);
+  }
+  fast.merge(slow);
+  EXPECT_EQ(fast.count(), 1000);
+  EXPECT_EQ(fast.percentile(0.99), 10);
+  EXPECT_EQ(fast.percentile(0.999), 5000);
+  EXPECT_EQ(fast.max(), 5000);
+}
+
+TEST(LatencyHistogram, testLargestValues) {
+  LatencyHistogram histogram;
+  histogram.record(std::numeric_limits<std::uint64_t>::max());
+  EXPECT_EQ(histogram.percentile(0.5),
+            std::numeric_limits<std::uint64_t>::max());
+}
@@ -0,0 +1,143 @@
+#include "../src/mutationlog.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Returns every record in the log at path as "type first second".
+std::vector<std::string> readLog(const std::string& path,
+                                 std::uint64_t* replayed = nullptr) {
+  std::vector<std::string> records;
+  auto log = MutationLog::open(
+      path,
+      [&](const Mutation& mutation) {
+        records.push_back(std::to_string(static_cast<int>(mutation.type)) +
+                          " " + std::string(mutation.first) + " " +
+                          std::string(mutation.second));
+      },
+      replayed);
+  EXPECT_NE(log, nullptr);
+  return records;
+}
+
+std::unique_ptr<MutationLog> openEmpty(const std::string& path) {
+  std::remove(path.c_str());
+  return MutationLog::open(path, [](const Mutation&) {});
+}
+
+}  // namespace
+
+TEST(MutationLog, testReplaysInOrder) {
+  std::string path = "./mutationlog_order.wal";
+  {
+    auto log = openEmpty(path);
+    ASSERT_NE(log, nullptr);
+    log->record({MutationType::CreatePlaylist, "list", {}},
+                [] { return true; });
+    log->record({MutationType::AddToPlaylist, "list", "cat_id"},
+                [] { return true; });
+    // Changes that change nothing are not recorded.
+    log->record({MutationType::Allow, "cat_id", {}}, [] { return false; });
+    log->record({MutationType::Flag, "cat_id", "reason with spaces"},
+                [] { return true; });
+    EXPECT_TRUE(log->sync());
+  }
+  std::uint64_t replayed = 0;
+  EXPECT_THAT(readLog(path, &replayed),
+              ::testing::ElementsAre("1 list ", "3 list cat_id",
+                                     "6 cat_id reason with spaces"));
+  EXPECT_EQ(replayed, 3);
+  std::remove(path.c_str());
+}
+
+TEST(MutationLog, testDropsTornTail) {
+  std::string path = "./mutationlog_torn.wal";
+  {
+    auto log = openEmpty(path);
+    log->record({MutationType::Flag, "a", "first"}, [] { return true; });
+    log->record({MutationType::Flag, "b", "second"}, [] { return true; });
+  }
+  // A crash in the middle of writing the second record.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+  EXPECT_THAT(readLog(path), ::testing::ElementsAre("6 a first"));
+  // Opening cut the tail off, so new records follow the last good one.
+  {
+    auto log = MutationLog::open(path, [](const Mutation&) {});
+    log->record({MutationType::Flag, "c", "third"}, [] { return true; });
+  }
+  EXPECT_THAT(readLog(path),
+              ::testing::ElementsAre("6 a first", "6 c third"));
+
+  // A record whose bytes were damaged stops the replay just the same.
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-2, std::ios::end);
+    file.put('X');
+  }
+  EXPECT_THAT(readLog(path), ::testing::ElementsAre("6 a first"));
+  std::remove(path.c_str());
+}
+
+TEST(MutationLog, testRejectsOtherFiles) {
+  std::string path = "./mutationlog_other.txt";
+  std::ofstream(path) << "Funny Dogs | funny_dogs_video_id |  #dog\n";
+  EXPECT_EQ(MutationLog::open(path, [](const Mutation&) {}), nullptr);
+  // The file is left alone.
+  EXPECT_EQ(std::filesystem::file_size(path), 41);
+  std::remove(path.c_str());
+}
+
+TEST(MutationLog, testGroupCommit) {
+  std::string path = "./mutationlog_group.wal";
+  auto log = openEmpty(path);
+  const int threadCount = 8;
+  const int recordsPerThread = 200;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < threadCount; ++thread) {
+    threads.emplace_back([&, thread] {
+      std::string id = "video_" + std::to_string(thread);
+      for (int record = 0; record < recordsPerThread; ++record) {
+        log->record({MutationType::Flag, id, "reason"}, [] { return true; });
+        EXPECT_TRUE(log->sync());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // Never more than one fsync per sync, usually far fewer.
+  EXPECT_LE(log->syncCount(), threadCount * recordsPerThread);
+  log.reset();
+  EXPECT_EQ(readLog(path).size(), threadCount * recordsPerThread);
+  std::remove(path.c_str());
+}
+
+TEST(MutationLog, testCompact) {
+  std::string path = "./mutationlog_compact.wal";
+  auto log = openEmpty(path);
+  for (int record = 0; record < 1000; ++record) {
+    log->record({MutationType::Flag, "cat_id", "reason"}, [] { return true; });
+    log->record({MutationType::Allow, "cat_id", {}}, [] { return true; });
+  }
+  std::uint64_t before = log->size();
+  std::string state;
+  MutationLog::encode(state, {MutationType::Flag, "dog_id", "kept"});
+  ASSERT_TRUE(log->compact(state));
+  EXPECT_LT(log->size(), before);
+  log->record({MutationType::Allow, "dog_id", {}}, [] { return true; });
+  log.reset();
+  EXPECT_FALSE(std::filesystem::exists(path + ".compact"));
+  EXPECT_THAT(readLog(path),
+              ::testing::ElementsAre("6 dog_id kept", "7 dog_id "));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,45 @@
+#include "../src/outputsink.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+TEST(OutputSink, testStdoutSinkWritesOnFlush) {
+  std::ostringstream stream;
+  {
+    StdoutSink sink(stream);
+    sink << "Playing video: " << std::string("Amazing Cats") << '\n';
+    EXPECT_EQ(stream.str(), "");
+    sink.flush();
+    EXPECT_EQ(stream.str(), "Playing video: Amazing Cats\n");
+    sink << "Stopping video";
+  }
+  // Whatever is left is written when the sink goes away.
+  EXPECT_EQ(stream.str(), "Playing video: Amazing Cats\nStopping video");
+}
+
+TEST(OutputSink, testStdoutSinkWritesWhenFull) {
+  std::ostringstream stream;
+  StdoutSink sink(stream, 8);
+  sink << "12345";
+  EXPECT_EQ(stream.str(), "");
+  sink << "6789";
+  EXPECT_EQ(stream.str(), "12345");
+  // Text that could never fit is written straight through.
+  sink << "abcdefghijk";
+  EXPECT_EQ(stream.str(), "123456789abcdefghijk");
+  sink.flush();
+  EXPECT_EQ(stream.str(), "123456789abcdefghijk");
+}
+
+TEST(OutputSink, testMemorySinkFormatsNumbers) {
+  MemorySink sink;
+  sink << 5 << " videos, " << std::size_t{1000000} << ' ' << -3L << ' '
+       << std::uint32_t{7};
+  EXPECT_EQ(sink.str(), "5 videos, 1000000 -3 7");
+  EXPECT_EQ(sink.take(), "5 videos, 1000000 -3 7");
+  EXPECT_EQ(sink.str(), "");
+}
@@ -1,6 +1,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
+#include "../src/outputsink.h"
 #include "../src/videoplayer.h"
 #include "../src/helper.h"
 
@@ -8,18 +11,18 @@ using ::testing::ContainsRegex;
 using ::testing::HasSubstr;
 
 TEST(Part1, numberOfVideos) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.numberOfVideos();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   EXPECT_THAT(output, HasSubstr("5 videos in the library"));
 }
 
 TEST(Part1, showAllVideos) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.showAllVideos();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 6);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here's a list of all available videos:"));
@@ -37,31 +40,31 @@ TEST(Part1, showAllVideos) {
 }
 
 TEST(Part1, playVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
 }
 
 TEST(Part1, playVideoNonExistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("some_other_video_that_doesnt_exist");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("Cannot play video: Video does not exist"));
 }
 
 TEST(Part1, playVideoStopPrevious) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.playVideo("funny_dogs_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -70,11 +73,11 @@ TEST(Part1, playVideoStopPrevious) {
 }
 
 TEST(Part1, playVideoDontStopPreviousIfNonExistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.playVideo("some_other_video");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0], Not(HasSubstr("Stopping video: Amazing Cats")));
@@ -82,11 +85,11 @@ TEST(Part1, playVideoDontStopPreviousIfNonExistent) {
 }
 
 TEST(Part1, stopVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.stopVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -94,12 +97,12 @@ TEST(Part1, stopVideo) {
 }
 
 TEST(Part1, stopVideoTwice) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.stopVideo();
   videoPlayer.stopVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -109,10 +112,10 @@ TEST(Part1, stopVideoTwice) {
 }
 
 TEST(Part1, stopVideoNothingPlaying) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.stopVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0],
@@ -120,10 +123,10 @@ TEST(Part1, stopVideoNothingPlaying) {
 }
 
 TEST(Part1, playRandomVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playRandomVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -133,11 +136,11 @@ TEST(Part1, playRandomVideo) {
 }
 
 TEST(Part1, playRandomVideoStopsPreviousVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.playRandomVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -148,12 +151,58 @@ TEST(Part1, playRandomVideoStopsPreviousVideo) {
                     "Dogs|Life at Google|Video about nothing)"));
 }
 
+TEST(Part1, playRandomVideoIsRepeatableWithSeed) {
+  auto randomPicks = [](std::uint32_t seed) {
+    auto sink = std::make_shared<MemorySink>();
+    VideoPlayer videoPlayer = VideoPlayer(sink);
+    videoPlayer.seedRandom(seed);
+    for (int i = 0; i < 20; ++i) {
+      videoPlayer.playRandomVideo();
+      videoPlayer.stopVideo();
+    }
+    return sink->take();
+  };
+  std::string picks = randomPicks(42);
+  EXPECT_EQ(picks, randomPicks(42));
+  EXPECT_NE(picks, randomPicks(43));
+}
+
+TEST(Part1, playRandomVideoSkipsFlaggedVideos) {
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
+  videoPlayer.seedRandom(7);
+  videoPlayer.flagVideo("amazing_cats_video_id");
+  videoPlayer.flagVideo("funny_dogs_video_id");
+  videoPlayer.flagVideo("life_at_google_video_id");
+  for (int i = 0; i < 20; ++i) {
+    videoPlayer.playRandomVideo();
+  }
+  videoPlayer.allowVideo("funny_dogs_video_id");
+  for (int i = 0; i < 20; ++i) {
+    videoPlayer.playRandomVideo();
+  }
+  std::string output = sink->take();
+  std::vector<std::string> commandOutput = splitlines(output);
+  bool playedFunnyDogs = false;
+  for (std::size_t line = 3; line < commandOutput.size(); ++line) {
+    if (commandOutput[line].find("Playing video: ") == std::string::npos) {
+      continue;
+    }
+    EXPECT_THAT(commandOutput[line],
+                ContainsRegex("Playing video: (Another Cat Video|Video about "
+                              "nothing|Funny Dogs)"));
+    playedFunnyDogs |= commandOutput[line].find("Funny Dogs") !=
+                       std::string::npos;
+  }
+  EXPECT_TRUE(playedFunnyDogs);
+}
+
 TEST(Part1, showPlaying) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -162,21 +211,21 @@ TEST(Part1, showPlaying) {
 }
 
 TEST(Part1, showNothingPlaying) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("No video is currently playing"));
 }
 
 TEST(Part1, pauseVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -184,12 +233,12 @@ TEST(Part1, pauseVideo) {
 }
 
 TEST(Part1, pauseVideoShowVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -200,13 +249,13 @@ TEST(Part1, pauseVideoShowVideo) {
 }
 
 TEST(Part1, pauseVideoPlayVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -220,12 +269,12 @@ TEST(Part1, pauseVideoPlayVideo) {
 }
 
 TEST(Part1, pauseAlreadyPausedVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
   videoPlayer.pauseVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -234,10 +283,10 @@ TEST(Part1, pauseAlreadyPausedVideo) {
 }
 
 TEST(Part1, pauseVideoNothingPlaying) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.pauseVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0],
@@ -245,12 +294,12 @@ TEST(Part1, pauseVideoNothingPlaying) {
 }
 
 TEST(Part1, continueVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
   videoPlayer.continueVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -259,21 +308,21 @@ TEST(Part1, continueVideo) {
 }
 
 TEST(Part1, continueVideoNotPaused) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.continueVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[1], HasSubstr("Cannot continue video: Video is not paused"));
 }
 
 TEST(Part1, continueVideoNothingPlaying) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.continueVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -1,6 +1,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
+#include "../src/outputsink.h"
 #include "../src/videoplayer.h"
 #include "../src/helper.h"
 
@@ -8,10 +11,10 @@ using ::testing::HasSubstr;
 using ::testing::MatchesRegex;
 
 TEST(Part2, createPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0],
@@ -19,11 +22,11 @@ TEST(Part2, createPlaylist) {
 }
 
 TEST(Part2, createExistingPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.createPlaylist("MY_PLAYLIST");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0],
@@ -33,11 +36,11 @@ TEST(Part2, createExistingPlaylist) {
 }
 
 TEST(Part2, addToPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_playLIST", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0],
@@ -46,12 +49,12 @@ TEST(Part2, addToPlaylist) {
 }
 
 TEST(Part2, addToPlaylistAlreadyAdded) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0],
@@ -63,12 +66,12 @@ TEST(Part2, addToPlaylistAlreadyAdded) {
 }
 
 TEST(Part2, addVideoToPlaylistNonExistentVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "some_other_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0],
@@ -80,10 +83,10 @@ TEST(Part2, addVideoToPlaylistNonExistentVideo) {
 }
 
 TEST(Part2, addVideoToPlaylistNonExistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.addVideoToPlaylist("anotHER_playlist", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -93,10 +96,10 @@ TEST(Part2, addVideoToPlaylistNonExistent) {
 }
 
 TEST(Part2, addVideoToPlaylistNonExistentNoPlaylistNoVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.addVideoToPlaylist("anotHER_playlist", "video_does_not_exist");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -106,22 +109,22 @@ TEST(Part2, addVideoToPlaylistNonExistentNoPlaylistNoVideo) {
 }
 
 TEST(Part2, showAllPlaylistsNoPlaylistsExist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.showAllPlaylists();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("No playlists exist yet"));
 }
 
 TEST(Part2, showAllPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.createPlaylist("anotHER_playlist");
   videoPlayer.showAllPlaylists();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[2], HasSubstr("Showing all playlists:"));
@@ -130,13 +133,13 @@ TEST(Part2, showAllPlaylist) {
 }
 
 TEST(Part2, showPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.showPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.showPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 6);
   EXPECT_THAT(commandOutput[0],
@@ -150,15 +153,15 @@ TEST(Part2, showPlaylist) {
 }
 
 TEST(Part2, showPlaylistAfterRemoveAVideoFromPlaylistThenReAdd) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "life_at_google_video_id");
   videoPlayer.removeFromPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.showPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 8);
   EXPECT_THAT(commandOutput[5], HasSubstr("Showing playlist: mY_plaYList"));
@@ -169,10 +172,10 @@ TEST(Part2, showPlaylistAfterRemoveAVideoFromPlaylistThenReAdd) {
 }
 
 TEST(Part2, showPlaylistNonExistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.showPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -181,13 +184,13 @@ TEST(Part2, showPlaylistNonExistent) {
 }
 
 TEST(Part2, removeFromPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.removeFromPlaylist("MY_playlist", "amazing_cats_video_id");
   videoPlayer.removeFromPlaylist("mY_plaYList", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 4);
   EXPECT_THAT(commandOutput[0],
@@ -202,11 +205,11 @@ TEST(Part2, removeFromPlaylist) {
 }
 
 TEST(Part2, removeFromPlaylistVideoNotInPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.removeFromPlaylist("mY_plaYList", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(
@@ -216,12 +219,12 @@ TEST(Part2, removeFromPlaylistVideoNotInPlaylist) {
 }
 
 TEST(Part2, removeFromPlaylistNonexistentVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.removeFromPlaylist("mY_plaYList", "some_other_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0],
@@ -233,10 +236,10 @@ TEST(Part2, removeFromPlaylistNonexistentVideo) {
 }
 
 TEST(Part2, removeFromPlaylistNonexistentPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.removeFromPlaylist("my_cool_playlist", "some_other_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("Cannot remove video from my_cool_playlist: "
@@ -244,14 +247,14 @@ TEST(Part2, removeFromPlaylistNonexistentPlaylist) {
 }
 
 TEST(Part2, clearPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.addVideoToPlaylist("mY_plaYList", "amazing_cats_video_id");
   videoPlayer.showPlaylist("mY_plaYList");
   videoPlayer.clearPlaylist("mY_plaYList");
   videoPlayer.showPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 7);
   EXPECT_THAT(commandOutput[0],
@@ -267,10 +270,10 @@ TEST(Part2, clearPlaylist) {
 }
 
 TEST(Part2, clearPlaylistNonexistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.clearPlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -279,11 +282,11 @@ TEST(Part2, clearPlaylistNonexistent) {
 }
 
 TEST(Part2, deletePlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("mY_plaYList");
   videoPlayer.deletePlaylist("MY_PLAYLIST");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(commandOutput[0],
@@ -292,13 +295,28 @@ TEST(Part2, deletePlaylist) {
 }
 
 TEST(Part2, deletePlaylistNonexistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.deletePlaylist("mY_plaYList");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
       commandOutput[0],
       HasSubstr("Cannot delete playlist mY_plaYList: Playlist does not exist"));
 }
+
+TEST(Part2, deletePlaylistRemovesIt) {
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
+  videoPlayer.createPlaylist("mY_plaYList");
+  videoPlayer.deletePlaylist("MY_PLAYLIST");
+  videoPlayer.showAllPlaylists();
+  videoPlayer.createPlaylist("my_playlist");
+  std::string output = sink->take();
+  std::vector<std::string> commandOutput = splitlines(output);
+  ASSERT_EQ(commandOutput.size(), 4);
+  EXPECT_THAT(commandOutput[2], HasSubstr("No playlists exist yet"));
+  EXPECT_THAT(commandOutput[3],
+              HasSubstr("Successfully created new playlist: my_playlist"));
+}
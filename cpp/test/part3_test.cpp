@@ -1,6 +1,9 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+
+#include "../src/outputsink.h"
 #include "../src/videoplayer.h"
 #include "../src/helper.h"
 
@@ -8,14 +11,14 @@ using ::testing::HasSubstr;
 using ::testing::MatchesRegex;
 
 TEST(Part3, searchVideosWithNoAnswer) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("No");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideos("cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for cat:"));
@@ -31,14 +34,14 @@ TEST(Part3, searchVideosWithNoAnswer) {
 }
 
 TEST(Part3, searchVideosAndPlayAnswer) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("2");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideos("cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 6);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for cat:"));
@@ -54,14 +57,14 @@ TEST(Part3, searchVideosAndPlayAnswer) {
 }
 
 TEST(Part3, searchVideosAnswerOutOfBounds) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("5");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideos("cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for cat:"));
@@ -77,14 +80,14 @@ TEST(Part3, searchVideosAnswerOutOfBounds) {
 }
 
 TEST(Part3, searchVideosInvalidNumber) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("ab3g");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideos("cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for cat:"));
@@ -100,24 +103,24 @@ TEST(Part3, searchVideosInvalidNumber) {
 }
 
 TEST(Part3, searchVideosNoResults) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.searchVideos("blah");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("No search results for blah"));
 }
 
 TEST(Part3, searchVideosWithTagNoAnswer) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("no");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideosWithTag("#cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for #cat:"));
@@ -133,14 +136,14 @@ TEST(Part3, searchVideosWithTagNoAnswer) {
 }
 
 TEST(Part3, searchVideosWithTagPlayAnswer) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("1");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideosWithTag("#cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 6);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for #cat:"));
@@ -156,14 +159,14 @@ TEST(Part3, searchVideosWithTagPlayAnswer) {
 }
 
 TEST(Part3, searchVideosWithTagAnswerOutOfBounds) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("5");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.searchVideosWithTag("#cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Here are the results for #cat:"));
@@ -179,10 +182,10 @@ TEST(Part3, searchVideosWithTagAnswerOutOfBounds) {
 }
 
 TEST(Part3, searchVideosWithTagNoResults) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.searchVideosWithTag("#blah");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0], HasSubstr("No search results for #blah"));
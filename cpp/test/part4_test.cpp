@@ -1,6 +1,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#include "../src/outputsink.h"
 #include "../src/videoplayer.h"
 #include "../src/helper.h"
 
@@ -8,10 +13,10 @@ using ::testing::HasSubstr;
 using ::testing::MatchesRegex;
 
 TEST(Part4, flagVideoWithReason) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -21,20 +26,20 @@ TEST(Part4, flagVideoWithReason) {
 }
 
 TEST(Part4, flagVideoWithoutReason) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("another_cat_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   EXPECT_THAT(output, HasSubstr("Successfully flagged video: Another Cat Video "
                                 "(reason: Not supplied)"));
 }
 
 TEST(Part4, flagVideoAlreadyFlagged) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(
@@ -46,10 +51,10 @@ TEST(Part4, flagVideoAlreadyFlagged) {
 }
 
 TEST(Part4, flagVideoNonexistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("video_does_not_exist", "flagVideo_reason");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(
@@ -57,11 +62,11 @@ TEST(Part4, flagVideoNonexistent) {
 }
 
 TEST(Part4, flagVideoCanNoLongerPlay) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id");
   videoPlayer.playVideo("amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(
@@ -73,15 +78,15 @@ TEST(Part4, flagVideoCanNoLongerPlay) {
 }
 
 TEST(Part4, flagVideosPlayRandom) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("funny_dogs_video_id");
   videoPlayer.flagVideo("amazing_cats_video_id");
   videoPlayer.flagVideo("another_cat_video_id");
   videoPlayer.flagVideo("life_at_google_video_id");
   videoPlayer.flagVideo("nothing_video_id");
   videoPlayer.playRandomVideo();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 6);
   EXPECT_THAT(
@@ -108,12 +113,12 @@ TEST(Part4, flagVideosPlayRandom) {
 }
 
 TEST(Part4, flagVideoAddVideoToPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id");
   videoPlayer.createPlaylist("my_playlist");
   videoPlayer.addVideoToPlaylist("my_playlist", "amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(
@@ -128,13 +133,13 @@ TEST(Part4, flagVideoAddVideoToPlaylist) {
 }
 
 TEST(Part4, flagVideoShowPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("my_playlist");
   videoPlayer.addVideoToPlaylist("my_playlist", "amazing_cats_video_id");
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.showPlaylist("my_playlist");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0],
@@ -150,11 +155,11 @@ TEST(Part4, flagVideoShowPlaylist) {
 }
 
 TEST(Part4, flagVideoShowAllVideos) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.showAllVideos();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 7);
   EXPECT_THAT(
@@ -178,15 +183,15 @@ TEST(Part4, flagVideoShowAllVideos) {
 }
 
 TEST(Part4, flagVideoSearchVideos) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("no");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.searchVideos("cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(
@@ -204,15 +209,15 @@ TEST(Part4, flagVideoSearchVideos) {
 }
 
 TEST(Part4, flagVideoSearchVideosWithTag) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   std::streambuf* orig = std::cin.rdbuf();
   std::istringstream input("no");
   std::cin.rdbuf(input.rdbuf());
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.searchVideosWithTag("#cat");
   std::cin.rdbuf(orig);
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(
@@ -230,12 +235,12 @@ TEST(Part4, flagVideoSearchVideosWithTag) {
 }
 
 TEST(Part4, flagVideoStopPlayingVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 4);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -248,13 +253,13 @@ TEST(Part4, flagVideoStopPlayingVideo) {
 }
 
 TEST(Part4, flagVideoStopPausedVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.pauseVideo();
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 5);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -268,12 +273,12 @@ TEST(Part4, flagVideoStopPausedVideo) {
 }
 
 TEST(Part4, flagVideoKeepVideoPlayingIfDifferentFromFlaggedVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.playVideo("amazing_cats_video_id");
   videoPlayer.flagVideo("another_cat_video_id", "dont_like_cats");
   videoPlayer.showPlaying();
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 3);
   EXPECT_THAT(commandOutput[0], HasSubstr("Playing video: Amazing Cats"));
@@ -287,11 +292,11 @@ TEST(Part4, flagVideoKeepVideoPlayingIfDifferentFromFlaggedVideo) {
 }
 
 TEST(Part4, allowVideo) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.allowVideo("amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 2);
   EXPECT_THAT(
@@ -303,10 +308,10 @@ TEST(Part4, allowVideo) {
 }
 
 TEST(Part4, allowVideoNotFlagged) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.allowVideo("amazing_cats_video_id");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0],
@@ -314,10 +319,10 @@ TEST(Part4, allowVideoNotFlagged) {
 }
 
 TEST(Part4, allowVideoNonexistent) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.allowVideo("video_does_not_exist");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 1);
   EXPECT_THAT(commandOutput[0],
@@ -325,15 +330,15 @@ TEST(Part4, allowVideoNonexistent) {
 }
 
 TEST(Part4, allowVideoShowPlaylist) {
-  VideoPlayer videoPlayer = VideoPlayer();
-  testing::internal::CaptureStdout();
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(sink);
   videoPlayer.createPlaylist("my_playlist");
   videoPlayer.addVideoToPlaylist("my_playlist", "amazing_cats_video_id");
   videoPlayer.flagVideo("amazing_cats_video_id", "dont_like_cats");
   videoPlayer.showPlaylist("my_playlist");
   videoPlayer.allowVideo("amazing_cats_video_id");
   videoPlayer.showPlaylist("my_playlist");
-  std::string output = testing::internal::GetCapturedStdout();
+  std::string output = sink->take();
   std::vector<std::string> commandOutput = splitlines(output);
   ASSERT_EQ(commandOutput.size(), 8);
   EXPECT_THAT(commandOutput[0],
@@ -351,3 +356,74 @@ TEST(Part4, allowVideoShowPlaylist) {
   EXPECT_THAT(commandOutput[7],
               HasSubstr("Amazing Cats (amazing_cats_video_id) [#cat #animal]"));
 }
+
+TEST(Part4, flagsAndPlayingVideoFollowReload) {
+  std::string path = "./part4_reload_catalog.txt";
+  std::ofstream(path) << "First | first_id |\nSecond | second_id |\n";
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(VideoLibrary(path), sink);
+  videoPlayer.playVideo("second_id");
+  videoPlayer.flagVideo("first_id", "reason");
+  // Reorder the catalog, so both videos get new handles.
+  std::ofstream(path + ".new") << "New | new_id |\nSecond | second_id |\n"
+                                  "First | first_id |\n";
+  std::rename((path + ".new").c_str(), path.c_str());
+  videoPlayer.reloadLibrary();
+  videoPlayer.waitForReload();
+  videoPlayer.applyPendingReload();
+  videoPlayer.showPlaying();
+  videoPlayer.playVideo("first_id");
+  std::string output = sink->take();
+  std::vector<std::string> commandOutput = splitlines(output);
+  ASSERT_EQ(commandOutput.size(), 6);
+  EXPECT_THAT(commandOutput[3], HasSubstr("Reloaded video library: 3 videos"));
+  EXPECT_THAT(commandOutput[4],
+              HasSubstr("Currently playing: Second (second_id) []"));
+  EXPECT_THAT(commandOutput[5],
+              HasSubstr("Cannot play video: Video is currently flagged "
+                        "(reason: reason)"));
+  std::remove(path.c_str());
+}
+
+TEST(Part4, reloadNamesMissingCatalog) {
+  std::string path = "./part4_missing_catalog.txt";
+  std::ofstream(path) << "First | first_id |\n";
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(VideoLibrary(path), sink);
+  std::remove(path.c_str());
+  videoPlayer.reloadLibrary();
+  videoPlayer.waitForReload();
+  videoPlayer.applyPendingReload();
+  videoPlayer.numberOfVideos();
+  std::string output = sink->take();
+  std::vector<std::string> commandOutput = splitlines(output);
+  ASSERT_EQ(commandOutput.size(), 3);
+  EXPECT_THAT(commandOutput[1],
+              HasSubstr("Cannot reload video library: Couldn't find " + path));
+  EXPECT_THAT(commandOutput[2], HasSubstr("1 videos in the library"));
+}
+
+TEST(Part4, catalogWrittenInPlaceIsReloaded) {
+  std::string path = "./part4_in_place_catalog.txt";
+  std::ofstream(path) << "First | first_id |\n";
+  auto sink = std::make_shared<MemorySink>();
+  VideoPlayer videoPlayer = VideoPlayer(VideoLibrary(path), sink);
+  std::ofstream(path) << "First | first_id |\nSecond | second_id |\n"
+                         "Third | third_id |\n";
+  videoPlayer.applyPendingReload();
+  videoPlayer.numberOfVideos();
+  videoPlayer.waitForReload();
+  videoPlayer.applyPendingReload();
+  videoPlayer.applyPendingReload();
+  videoPlayer.numberOfVideos();
+  std::string output = sink->take();
+  std::vector<std::string> commandOutput = splitlines(output);
+  ASSERT_EQ(commandOutput.size(), 4);
+  EXPECT_THAT(commandOutput[0],
+              HasSubstr("Warning: " + path + " was changed in place while "
+                        "loaded; reloading it"));
+  EXPECT_THAT(commandOutput[1], HasSubstr("1 videos in the library"));
+  EXPECT_THAT(commandOutput[2], HasSubstr("Reloaded video library: 3 videos"));
+  EXPECT_THAT(commandOutput[3], HasSubstr("3 videos in the library"));
+  std::remove(path.c_str());
+}
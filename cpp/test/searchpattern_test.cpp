@@ -0,0 +1,110 @@
+#include "../src/searchpattern.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <regex>
+#include <string>
+
+#include "../src/videolibrary.h"
+
+namespace {
+
+SearchPattern::Result search(std::string_view pattern, std::string_view text,
+                             std::uint64_t steps = UINT64_MAX) {
+  std::optional<SearchPattern> compiled = SearchPattern::compile(pattern);
+  EXPECT_TRUE(compiled.has_value()) << "pattern: " << pattern;
+  return compiled ? compiled->search(text, steps)
+                  : SearchPattern::Result::kNoMatch;
+}
+
+bool matches(std::string_view pattern, std::string_view text) {
+  return search(pattern, text) == SearchPattern::Result::kMatch;
+}
+
+}  // namespace
+
+TEST(SearchPattern, testAgreesWithStdRegex) {
+  const char *patterns[] = {
+      "cat",        "^amazing",   "video$",      "^$",         "c.t",
+      "a|b",        "(cat|dog)s", "do+g",        "go*gle",     "gl?e",
+      "[a-c]at",    "[^a-z ]",    "\\d+",        "\\w+\\s\\w+", "\\bcat\\b",
+      "\\Bat",      "o{2}",       "o{1,}",       "(?:ab){2,3}", "[]x]",
+      "x|",         "(a*)*",      "^(a|b)+$",    "e\\.",       "\\x41",
+      "[\\d-]",     "[.]",        "\\D\\W\\S",   "a{0}b",      "(|a)z"};
+  const char *titles[] = {"Amazing Cats",  "Funny Dogs", "Another Cat Video",
+                          "Life at Google", "Video about nothing", "",
+                          "abab",          "aab",        "x1-2 3!",
+                          "catalogue",     "e.g. zoo",    "Goooogle"};
+  for (const char *pattern : patterns) {
+    std::regex expected(pattern,
+                        std::regex::ECMAScript | std::regex::icase);
+    for (const char *title : titles) {
+      EXPECT_EQ(matches(pattern, title), std::regex_search(title, expected))
+          << "pattern: " << pattern << ", title: " << title;
+    }
+  }
+}
+
+TEST(SearchPattern, testIgnoresCase) {
+  EXPECT_TRUE(matches("CAT", "amazing cats"));
+  EXPECT_TRUE(matches("[a-c]AT", "Cat"));
+  EXPECT_FALSE(matches("[^a]", "AaA"));
+  EXPECT_TRUE(matches("\\w", "_"));
+  EXPECT_FALSE(matches("\\W", "Abc"));
+}
+
+TEST(SearchPattern, testRejectsInvalidAndUnsupportedPatterns) {
+  for (const char *pattern :
+       {"(", ")", "[a", "*a", "a**", "a{2", "a{3,2}", "\\", "(a)\\1",
+        "(?=a)", "(?!a)", "[z-a]", "\\u0100", "a{1001}", "^*"}) {
+    EXPECT_FALSE(SearchPattern::compile(pattern).has_value())
+        << "pattern: " << pattern;
+  }
+}
+
+TEST(SearchPattern, testRejectsPatternsThatCompileTooLarge) {
+  EXPECT_FALSE(SearchPattern::compile("(a{1000}){1000}").has_value());
+  EXPECT_FALSE(SearchPattern::compile(std::string(1000, '(') + "a" +
+                                      std::string(1000, ')'))
+                   .has_value());
+  EXPECT_TRUE(SearchPattern::compile("((((a))))").has_value());
+}
+
+TEST(SearchPattern, testPathologicalPatternsRunInLinearTime) {
+  // Each of these backtracks exponentially (or overflows the stack) in a
+  // backtracking engine on a long run of 'a's with no match at the end.
+  std::string text(20000, 'a');
+  text += '!';
+  auto begin = std::chrono::steady_clock::now();
+  for (const char *pattern :
+       {"(a*)*b", "(a|aa)*c", "(a+)+$X", "(a|a)*b", "(.*a){20}b",
+        "^(([a-z])+.)+[A-Z]([a-z])+$X", "(x+x+)+y"}) {
+    EXPECT_EQ(search(pattern, text), SearchPattern::Result::kNoMatch)
+        << "pattern: " << pattern;
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+  EXPECT_TRUE(matches("(a*)*!", text));
+}
+
+TEST(SearchPattern, testStopsWhenOutOfSteps) {
+  std::string text(1000, 'a');
+  std::uint64_t steps = 100;
+  std::optional<SearchPattern> pattern = SearchPattern::compile("(a|aa)*b");
+  ASSERT_TRUE(pattern.has_value());
+  EXPECT_EQ(pattern->search(text, steps), SearchPattern::Result::kOutOfSteps);
+  EXPECT_EQ(steps, 0);
+  steps = UINT64_MAX;
+  EXPECT_EQ(pattern->search(text, steps), SearchPattern::Result::kNoMatch);
+  EXPECT_LT(steps, UINT64_MAX);
+}
+
+TEST(SearchPattern, testLibrarySearchReportsExhaustedBudget) {
+  VideoLibrary videoLibrary = VideoLibrary();
+  bool complete = false;
+  EXPECT_EQ(videoLibrary.searchTitles("^.*o.*$", &complete).size(), 4);
+  EXPECT_TRUE(complete);
+  EXPECT_TRUE(videoLibrary.searchTitles("^.*o.*$", &complete, 10).empty());
+  EXPECT_FALSE(complete);
+}
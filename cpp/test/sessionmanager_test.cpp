@@ -0,0 +1,115 @@
+#include "../src/sessionmanager.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/outputsink.h"
+#include "../src/videolibrary.h"
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TEST(SessionManager, testSessionsShareOneCatalog) {
+  SessionManager manager{VideoLibrary()};
+  const Catalog* catalog = manager.getSharedLibrary().catalog().get();
+  auto sink = std::make_shared<NullSink>();
+  for (int session = 0; session < 2000; ++session) {
+    manager.open(session % 2 ? SessionScope::Shared : SessionScope::Private,
+                 sink);
+  }
+  EXPECT_EQ(manager.size(), 2000);
+  EXPECT_EQ(manager.getSharedLibrary().catalog().get(), catalog);
+  // Every player and private library holds the one catalog.
+  EXPECT_GE(manager.getSharedLibrary().catalog().use_count(), 3000);
+}
+
+TEST(SessionManager, testPrivateAndSharedState) {
+  SessionManager manager{VideoLibrary()};
+  auto privateSink = std::make_shared<MemorySink>();
+  auto firstSink = std::make_shared<MemorySink>();
+  auto secondSink = std::make_shared<MemorySink>();
+  auto alone = manager.open(SessionScope::Private, privateSink);
+  auto first = manager.open(SessionScope::Shared, firstSink);
+  auto second = manager.open(SessionScope::Shared, secondSink);
+
+  manager.executeLine(first, "CREATE_PLAYLIST together");
+  manager.executeLine(first, "FLAG_VIDEO amazing_cats_video_id");
+  manager.executeLine(first, "PLAY funny_dogs_video_id");
+  firstSink->take();
+
+  // Shared sessions see each other's playlists and flags but not what the
+  // other is playing.
+  manager.executeLine(second, "SHOW_ALL_PLAYLISTS");
+  manager.executeLine(second, "PLAY amazing_cats_video_id");
+  manager.executeLine(second, "SHOW_PLAYING");
+  std::string output = secondSink->take();
+  EXPECT_THAT(output, HasSubstr("\ttogether"));
+  EXPECT_THAT(output, HasSubstr("Video is currently flagged"));
+  EXPECT_THAT(output, HasSubstr("No video is currently playing"));
+
+  manager.executeLine(alone, "SHOW_ALL_PLAYLISTS");
+  manager.executeLine(alone, "PLAY amazing_cats_video_id");
+  output = privateSink->take();
+  EXPECT_THAT(output, HasSubstr("No playlists exist yet"));
+  EXPECT_THAT(output, HasSubstr("Playing video: Amazing Cats"));
+}
+
+TEST(SessionManager, testExitClosesSession) {
+  SessionManager manager{VideoLibrary()};
+  auto sink = std::make_shared<MemorySink>();
+  auto first = manager.open(SessionScope::Private, sink);
+  auto second = manager.open(SessionScope::Private, sink);
+  EXPECT_FALSE(manager.executeLine(first, "EXIT"));
+  EXPECT_FALSE(manager.executeLine(first, "HELP"));
+  EXPECT_EQ(manager.size(), 1);
+  // The id is handed out again.
+  EXPECT_EQ(manager.open(SessionScope::Shared, sink), first);
+  EXPECT_TRUE(manager.close(second));
+  EXPECT_FALSE(manager.close(second));
+  EXPECT_EQ(manager.size(), 1);
+}
+
+TEST(SessionManager, testSessionsFollowReload) {
+  std::string path = "./sessionmanager_reload_catalog.txt";
+  std::ofstream(path) << "First | first_id |\nSecond | second_id |\n";
+  SessionManager manager{VideoLibrary(path)};
+  auto privateSink = std::make_shared<MemorySink>();
+  auto sharedSink = std::make_shared<MemorySink>();
+  auto otherSink = std::make_shared<MemorySink>();
+  auto alone = manager.open(SessionScope::Private, privateSink);
+  auto shared = manager.open(SessionScope::Shared, sharedSink);
+  auto other = manager.open(SessionScope::Shared, otherSink);
+  manager.executeLine(alone, "PLAY second_id");
+  manager.executeLine(alone, "FLAG_VIDEO first_id");
+  manager.executeLine(other, "PLAY first_id");
+  privateSink->take();
+  otherSink->take();
+
+  std::ofstream(path + ".new") << "New | new_id |\nSecond | second_id |\n";
+  std::rename((path + ".new").c_str(), path.c_str());
+  manager.executeLine(shared, "RELOAD_LIBRARY");
+  manager.getSharedLibrary().waitForReload();
+  manager.executeLine(shared, "NUMBER_OF_VIDEOS");
+  EXPECT_THAT(sharedSink->take(), HasSubstr("2 videos in the library"));
+
+  // The private session moves its own flags and playing video over.
+  manager.executeLine(alone, "SHOW_PLAYING");
+  std::string output = privateSink->take();
+  EXPECT_THAT(output, HasSubstr("Reloaded video library: 2 videos"));
+  EXPECT_THAT(output, HasSubstr("Currently playing: Second (second_id) []"));
+
+  // The other shared session finds its library already moved on, and its
+  // video gone.
+  manager.executeLine(other, "SHOW_PLAYING");
+  output = otherSink->take();
+  EXPECT_THAT(output, Not(HasSubstr("Reloaded video library")));
+  EXPECT_THAT(output, HasSubstr("Stopping video: First"));
+  EXPECT_THAT(output, HasSubstr("No video is currently playing"));
+  std::remove(path.c_str());
+}
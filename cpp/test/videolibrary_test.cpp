@@ -3,16 +3,75 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "../src/helper.h"
+#include "../src/snapshot.h"
 #include "../src/video.h"
 
 using ::testing::ContainsRegex;
 using ::testing::HasSubstr;
 
+namespace {
+
+// Returns the ids of the videos in a playlist, in order.
+std::vector<std::string> playlistVideoIds(const VideoLibrary &videoLibrary,
+                                          const VideoPlaylist &playlist) {
+  std::vector<std::string> videoIds;
+  for (VideoHandle video : playlist.getVideoHandles()) {
+    videoIds.emplace_back(videoLibrary.getVideoAt(video).getVideoId());
+  }
+  return videoIds;
+}
+
+}  // namespace
+
 TEST(VideoLibrary, VideoLibraryHasAllVideos) {
   VideoLibrary videoLibrary = VideoLibrary();
   EXPECT_EQ(videoLibrary.getVideos().size(), 5);
 }
 
+TEST(VideoLibrary, testViewsDoNotCopy) {
+  VideoLibrary videoLibrary = VideoLibrary();
+  EXPECT_EQ(videoLibrary.size(), 5);
+  Span<Video> videos = videoLibrary.videos();
+  ASSERT_EQ(videos.size(), 5);
+  // The views hand out the stored videos themselves.
+  std::size_t visited = 0;
+  videoLibrary.forEachVideo([&](const Video &video) {
+    EXPECT_EQ(&video, &videos[visited]);
+    EXPECT_EQ(&video, videoLibrary.getVideo(video.getVideoId()));
+    ++visited;
+  });
+  EXPECT_EQ(visited, 5);
+
+  videoLibrary.createPlaylist("First");
+  VideoPlaylist *second = videoLibrary.createPlaylist("Second");
+  second->addVideo(videoLibrary.findVideo("amazing_cats_video_id"));
+  second->addVideo(videoLibrary.findVideo("funny_dogs_video_id"));
+  EXPECT_EQ(videoLibrary.playlistCount(), 2);
+  std::vector<const VideoPlaylist *> playlists;
+  videoLibrary.forEachPlaylist(
+      [&](const VideoPlaylist &playlist) { playlists.push_back(&playlist); });
+  EXPECT_THAT(playlists, ::testing::UnorderedElementsAre(
+                             videoLibrary.getPlaylist("first"), second));
+  std::vector<VideoHandle> videoHandles;
+  second->forEachVideo(
+      [&](VideoHandle video) { videoHandles.push_back(video); });
+  EXPECT_EQ(videoHandles, second->getVideoHandles());
+  EXPECT_THAT(playlistVideoIds(videoLibrary, *second),
+              ::testing::ElementsAre("amazing_cats_video_id",
+                                     "funny_dogs_video_id"));
+  EXPECT_EQ(second->size(), 2);
+}
+
 TEST(VideoLibrary, VideoLibraryParsesTagsCorrectly) {
   std::vector<std::string> tags{"#cat", "#animal"};
   VideoLibrary videoLibrary = VideoLibrary();
@@ -30,3 +89,370 @@ TEST(VideoLibrary, testLibraryParsesVideoCorrectlyWithoutTags) {
   EXPECT_EQ("nothing_video_id", video->getVideoId());
   EXPECT_TRUE(video->getTags().empty());
 }
+
+TEST(VideoLibrary, testLibraryTrimsLikeStreamParser) {
+  std::string path = "./videolibrary_test_catalog.txt";
+  std::ofstream(path) << "  Spaced Title \t|\tspaced_id  | #a ,, #b,\n"
+                      << "\n"
+                      << "No Tags | no_tags_id\n"
+                      << "Duplicate | spaced_id | #c\n"
+                      << "Blank Tag | blank_tag_id | \n";
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  EXPECT_EQ(videoLibrary.getVideos().size(), 4);
+  const Video *video = videoLibrary.getVideo("spaced_id");
+  ASSERT_NE(video, nullptr);
+  EXPECT_EQ("Spaced Title", video->getTitle());
+  std::vector<std::string> tags(video->getTags().begin(),
+                                video->getTags().end());
+  EXPECT_THAT(tags, ::testing::ElementsAre("#a", "", "#b"));
+  EXPECT_TRUE(videoLibrary.getVideo("no_tags_id")->getTags().empty());
+  EXPECT_EQ(videoLibrary.getVideo("blank_tag_id")->getTags().size(), 1);
+  EXPECT_NE(videoLibrary.getVideo(""), nullptr);
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testParallelParseMatchesSerial) {
+  std::string path = "./videolibrary_parallel_catalog.txt";
+  {
+    std::ofstream catalog(path);
+    for (int row = 0; row < 1000; ++row) {
+      catalog << " Title " << row << " | id_" << row % 900 << " |"
+              << (row % 3 ? " #a , #b" : "") << "\n";
+    }
+    catalog << "Last | last_id | #end";
+  }
+  VideoLibrary serial = VideoLibrary(path, 1);
+  for (unsigned threads : {2u, 3u, 8u}) {
+    VideoLibrary parallel = VideoLibrary(path, threads);
+    std::vector<Video> expected = serial.getVideos();
+    std::vector<Video> actual = parallel.getVideos();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].getTitle(), actual[i].getTitle());
+      EXPECT_EQ(expected[i].getVideoId(), actual[i].getVideoId());
+      EXPECT_TRUE(std::equal(expected[i].getTags().begin(),
+                             expected[i].getTags().end(),
+                             actual[i].getTags().begin(),
+                             actual[i].getTags().end()));
+    }
+  }
+  EXPECT_EQ(serial.getVideo("id_5")->getTitle(), "Title 5");
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testSnapshotRoundTrip) {
+  std::string path = "./videolibrary_test.snapshot";
+  {
+    VideoLibrary videoLibrary = VideoLibrary();
+    videoLibrary.addFlag(videoLibrary.findVideo("funny_dogs_video_id"),
+                         "dont_like_dogs");
+    VideoPlaylist *playlist = videoLibrary.createPlaylist("My_Playlist");
+    playlist->addVideo(videoLibrary.findVideo("amazing_cats_video_id"));
+    playlist->addVideo(videoLibrary.findVideo("nothing_video_id"));
+    ASSERT_TRUE(videoLibrary.saveSnapshot(path));
+  }
+  std::optional<VideoLibrary> videoLibrary = VideoLibrary::fromSnapshot(path);
+  ASSERT_TRUE(videoLibrary.has_value());
+  EXPECT_EQ(videoLibrary->getVideos().size(), 5);
+  const Video *video = videoLibrary->getVideo("amazing_cats_video_id");
+  ASSERT_NE(video, nullptr);
+  EXPECT_EQ("Amazing Cats", video->getTitle());
+  std::vector<std::string> tags(video->getTags().begin(),
+                                video->getTags().end());
+  EXPECT_THAT(tags, ::testing::ElementsAre("#cat", "#animal"));
+  EXPECT_TRUE(videoLibrary->getVideo("nothing_video_id")->getTags().empty());
+  EXPECT_EQ(videoLibrary->getVideo("missing_video_id"), nullptr);
+  // The tag index is read from the snapshot as it was saved.
+  EXPECT_EQ(videoLibrary->findVideosWithTag("#CAT").size(), 2);
+  VideoHandle funnyDogs = videoLibrary->findVideo("funny_dogs_video_id");
+  ASSERT_NE(videoLibrary->getFlag(funnyDogs), nullptr);
+  EXPECT_EQ(*videoLibrary->getFlag(funnyDogs), "dont_like_dogs");
+  VideoPlaylist *playlist = videoLibrary->getPlaylist("my_playlist");
+  ASSERT_NE(playlist, nullptr);
+  EXPECT_EQ(playlist->getPlaylistId(), "My_Playlist");
+  EXPECT_THAT(playlistVideoIds(*videoLibrary, *playlist),
+              ::testing::ElementsAre("amazing_cats_video_id",
+                                     "nothing_video_id"));
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testSnapshotRejectsInvalidFiles) {
+  EXPECT_FALSE(VideoLibrary::fromSnapshot("./missing.snapshot").has_value());
+  std::string path = "./videolibrary_invalid.snapshot";
+  std::ofstream(path) << "not a snapshot";
+  EXPECT_FALSE(VideoLibrary::fromSnapshot(path).has_value());
+  // A library cannot hold two playlists whose names differ only in case.
+  VideoLibrary videoLibrary = VideoLibrary();
+  SnapshotContents contents;
+  contents.catalog = videoLibrary.catalog().get();
+  contents.playlists.push_back({"My_List", {"amazing_cats_video_id"}});
+  contents.playlists.push_back({"MY_LIST", {"nothing_video_id"}});
+  ASSERT_TRUE(writeSnapshot(path, contents));
+  EXPECT_FALSE(VideoLibrary::fromSnapshot(path).has_value());
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testSnapshotRejectsDuplicatedIndexSlots) {
+  std::string path = "./videolibrary_duplicated.snapshot";
+  VideoLibrary videoLibrary = VideoLibrary();
+  ASSERT_TRUE(videoLibrary.saveSnapshot(path));
+  std::string data;
+  {
+    std::ifstream input(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(input),
+                std::istreambuf_iterator<char>());
+  }
+  SnapshotHeader header;
+  ASSERT_GE(data.size(), sizeof(header));
+  std::memcpy(&header, data.data(), sizeof(header));
+  // Point a second slot at the first slot's video, so one video is indexed
+  // twice and another not at all, with the same number of slots in use.
+  char* slots = data.data() + header.indexOffset;
+  std::vector<std::size_t> used;
+  for (std::size_t i = 0; i < header.indexSlotCount; ++i) {
+    std::uint32_t slot;
+    std::memcpy(&slot, slots + i * sizeof(slot), sizeof(slot));
+    if (slot != 0) {
+      used.push_back(i);
+    }
+  }
+  ASSERT_GE(used.size(), 2);
+  std::memcpy(slots + used[1] * sizeof(std::uint32_t),
+              slots + used[0] * sizeof(std::uint32_t), sizeof(std::uint32_t));
+  std::ofstream(path, std::ios::binary) << data;
+  EXPECT_FALSE(VideoLibrary::fromSnapshot(path).has_value());
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testReloadKeepsFlagsAndPlaylistsForRemainingVideos) {
+  std::string path = "./videolibrary_reload_catalog.txt";
+  std::ofstream(path) << "Kept | kept_id | #a\nGone | gone_id | #b\n";
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  videoLibrary.addFlag(videoLibrary.findVideo("kept_id"), "reason");
+  videoLibrary.addFlag(videoLibrary.findVideo("gone_id"), "reason");
+  VideoPlaylist *playlist = videoLibrary.createPlaylist("list");
+  playlist->addVideo(videoLibrary.findVideo("gone_id"));
+  playlist->addVideo(videoLibrary.findVideo("kept_id"));
+
+  ReloadReport report;
+  EXPECT_FALSE(videoLibrary.applyReload(&report));
+  // Replace the file rather than rewriting it, the old catalog maps it.
+  std::ofstream(path + ".new") << "New | new_id |\nKept | kept_id | #a\n";
+  std::rename((path + ".new").c_str(), path.c_str());
+  ASSERT_TRUE(videoLibrary.beginReload());
+  videoLibrary.waitForReload();
+  // Until the reload is applied the old catalog is still served.
+  EXPECT_NE(videoLibrary.getVideo("gone_id"), nullptr);
+  ASSERT_TRUE(videoLibrary.applyReload(&report));
+
+  EXPECT_TRUE(report.loaded);
+  EXPECT_EQ(report.videoCount, 2);
+  EXPECT_EQ(report.droppedFlags, 1);
+  EXPECT_EQ(report.droppedPlaylistEntries, 1);
+  EXPECT_EQ(videoLibrary.getVideo("gone_id"), nullptr);
+  EXPECT_NE(videoLibrary.getVideo("new_id"), nullptr);
+  // The new catalog puts kept_id at a different position; its flag and
+  // playlist entry follow it.
+  EXPECT_EQ(videoLibrary.findVideo("kept_id"), 1);
+  EXPECT_EQ(videoLibrary.findVideo("gone_id"), kNoVideo);
+  EXPECT_NE(videoLibrary.getFlag(videoLibrary.findVideo("kept_id")), nullptr);
+  EXPECT_EQ(videoLibrary.getFlag(videoLibrary.findVideo("new_id")), nullptr);
+  EXPECT_EQ(videoLibrary.flagCount(), 1);
+  EXPECT_THAT(playlistVideoIds(videoLibrary, *videoLibrary.getPlaylist("list")),
+              ::testing::ElementsAre("kept_id"));
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testReloadPicksUpChangesMadeDuringIt) {
+  std::string path = "./videolibrary_rerun_catalog.txt";
+  std::ofstream(path) << "First | first_id |\n";
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  auto replace = [&](const std::string& lastRow, int rows) {
+    {
+      std::ofstream catalog(path + ".new");
+      for (int row = 0; row < rows; ++row) {
+        catalog << "Video " << row << " | id_" << row << " |\n";
+      }
+      catalog << lastRow;
+    }
+    std::rename((path + ".new").c_str(), path.c_str());
+  };
+  // Big enough that the second change lands while the first is loading,
+  // once the build has had a moment to open the file.
+  replace("Second | second_id |\n", 100000);
+  ASSERT_TRUE(videoLibrary.beginReload());
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  replace("Third | third_id |\n", 10);
+  videoLibrary.beginReload();
+  videoLibrary.waitForReload();
+  ReloadReport report;
+  ASSERT_TRUE(videoLibrary.applyReload(&report));
+  EXPECT_EQ(report.videoCount, 11);
+  EXPECT_NE(videoLibrary.getVideo("third_id"), nullptr);
+
+  // A change after a build finished, but before it was applied, replaces it.
+  replace("Fourth | fourth_id |\n", 0);
+  ASSERT_TRUE(videoLibrary.beginReload());
+  videoLibrary.waitForReload();
+  replace("Fifth | fifth_id |\n", 0);
+  ASSERT_TRUE(videoLibrary.beginReload());
+  videoLibrary.waitForReload();
+  ASSERT_TRUE(videoLibrary.applyReload(&report));
+  EXPECT_EQ(videoLibrary.getVideo("fourth_id"), nullptr);
+  EXPECT_NE(videoLibrary.getVideo("fifth_id"), nullptr);
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testLogRestoresPlaylistsAndFlags) {
+  std::string path = "./videolibrary_changes.wal";
+  std::remove(path.c_str());
+  {
+    VideoLibrary videoLibrary;
+    ASSERT_TRUE(videoLibrary.openLog(path));
+    VideoHandle nothing = videoLibrary.findVideo("nothing_video_id");
+    VideoHandle dogs = videoLibrary.findVideo("funny_dogs_video_id");
+    VideoHandle google = videoLibrary.findVideo("life_at_google_video_id");
+    VideoPlaylist *playlist = videoLibrary.createPlaylist("My_List");
+    videoLibrary.addToPlaylist(*playlist, nothing);
+    videoLibrary.addToPlaylist(*playlist, dogs);
+    videoLibrary.removeFromPlaylist(*playlist, nothing);
+    videoLibrary.createPlaylist("Gone");
+    videoLibrary.deletePlaylist(std::string_view("GONE"));
+    videoLibrary.addFlag(videoLibrary.findVideo("amazing_cats_video_id"),
+                         "dont_like");
+    videoLibrary.addFlag(google);
+    videoLibrary.deleteFlag(google);
+  }
+
+  auto check = [&](VideoLibrary &videoLibrary) {
+    EXPECT_EQ(videoLibrary.playlistCount(), 1);
+    VideoPlaylist *playlist = videoLibrary.getPlaylist("my_list");
+    ASSERT_NE(playlist, nullptr);
+    EXPECT_EQ(playlist->getPlaylistId(), "My_List");
+    EXPECT_THAT(playlistVideoIds(videoLibrary, *playlist),
+                ::testing::ElementsAre("funny_dogs_video_id"));
+    EXPECT_EQ(videoLibrary.flagCount(), 1);
+    const std::string *reason =
+        videoLibrary.getFlag(videoLibrary.findVideo("amazing_cats_video_id"));
+    ASSERT_NE(reason, nullptr);
+    EXPECT_EQ(*reason, "dont_like");
+  };
+  std::uint64_t replayed = 0;
+  {
+    VideoLibrary videoLibrary;
+    ASSERT_TRUE(videoLibrary.openLog(path, &replayed));
+    EXPECT_EQ(replayed, 9);
+    check(videoLibrary);
+    ASSERT_TRUE(videoLibrary.compactLog());
+  }
+  // Compacted down to the flag, the playlist and its one entry.
+  VideoLibrary videoLibrary;
+  ASSERT_TRUE(videoLibrary.openLog(path, &replayed));
+  EXPECT_EQ(replayed, 3);
+  check(videoLibrary);
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testTagsAreInternedCaseInsensitively) {
+  std::string path = "./videolibrary_tags_catalog.txt";
+  std::ofstream(path) << "One | one_id | #Cat, #dog\n"
+                      << "Two | two_id | #cat, #a, #b, #c, #d, #e\n";
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  std::vector<std::string> tags(
+      videoLibrary.getVideo("one_id")->getTags().begin(),
+      videoLibrary.getVideo("one_id")->getTags().end());
+  EXPECT_THAT(tags, ::testing::ElementsAre("#Cat", "#dog"));
+  // More tags than fit inline still read back in order.
+  TagList twoTags = videoLibrary.getVideo("two_id")->getTags();
+  EXPECT_EQ(twoTags.size(), 6);
+  EXPECT_EQ(*std::next(twoTags.begin(), 5), "#e");
+
+  std::uint32_t cat = videoLibrary.findTag("#CAT");
+  ASSERT_NE(cat, TagDictionary::npos);
+  EXPECT_EQ(cat, videoLibrary.findTag("#cat"));
+  EXPECT_TRUE(videoLibrary.getVideo("one_id")->getTags().containsFolded(cat));
+  EXPECT_TRUE(twoTags.containsFolded(cat));
+  EXPECT_EQ(videoLibrary.findTag("#missing"), TagDictionary::npos);
+  std::remove(path.c_str());
+}
+
+TEST(VideoLibrary, testTitleSearchMatchesSubstringScan) {
+  std::string path = "./videolibrary_titles_catalog.txt";
+  std::string snapshotPath = "./videolibrary_titles.snapshot";
+  const char *words[] = {"Cat", "dog", "Catalog", "aaaa", "Ab", "x"};
+  {
+    std::ofstream catalog(path);
+    for (int row = 0; row < 200; ++row) {
+      catalog << words[row % 6] << " " << words[row / 6 % 6] << row % 7
+              << " | id_" << row << " |\n";
+    }
+  }
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  ASSERT_TRUE(videoLibrary.saveSnapshot(snapshotPath));
+  std::optional<VideoLibrary> restored =
+      VideoLibrary::fromSnapshot(snapshotPath);
+  ASSERT_TRUE(restored.has_value());
+
+  // Results are in title order, so a brute-force scan of the sorted titles
+  // must agree exactly.
+  std::vector<Video> videos = videoLibrary.getVideos();
+  std::stable_sort(videos.begin(), videos.end(),
+                   [](const Video &a, const Video &b) {
+                     return a.getTitle() < b.getTitle();
+                   });
+  for (std::string term : {"", "a", "CA", "cat", "ALOG d", "aaa", "aaaaa",
+                           "g dog3", "b x", "missing", "t c"}) {
+    std::vector<std::string> expected;
+    for (const auto &video : videos) {
+      if (stringToUpper(std::string(video.getTitle()))
+              .find(stringToUpper(term)) != std::string::npos) {
+        expected.emplace_back(video.getVideoId());
+      }
+    }
+    for (const VideoLibrary *library : {&videoLibrary, &*restored}) {
+      std::vector<std::string> actual;
+      for (std::uint32_t position : library->searchTitles(term)) {
+        actual.emplace_back(library->getVideoAt(position).getVideoId());
+      }
+      EXPECT_EQ(actual, expected) << "term: " << term;
+    }
+  }
+  // Terms with regex syntax are still matched as regexes.
+  EXPECT_EQ(videoLibrary.searchTitles("^DOG X6$").size(), 1);
+  EXPECT_TRUE(videoLibrary.searchTitles("(").empty());
+  std::remove(path.c_str());
+  std::remove(snapshotPath.c_str());
+}
+
+TEST(VideoLibrary, testReloadKeepsTitleOrder) {
+  std::string path = "./videolibrary_order_catalog.txt";
+  auto titleOrderIds = [](const VideoLibrary &library) {
+    std::vector<std::string> ids;
+    for (std::uint32_t position : library.getTitleOrder()) {
+      ids.emplace_back(library.getVideoAt(position).getVideoId());
+    }
+    return ids;
+  };
+  std::ofstream(path) << "B | b_id |\nA | a_id |\nSame | s1_id |\n"
+                      << "Same | s2_id |\nC | c_id |\n";
+  VideoLibrary videoLibrary = VideoLibrary(path);
+  EXPECT_THAT(titleOrderIds(videoLibrary),
+              ::testing::ElementsAre("a_id", "b_id", "c_id", "s1_id", "s2_id"));
+
+  // Removed, added and retitled videos, then rows swapped so the ties
+  // change order: each reload must match a fresh load of the same file.
+  for (const char *catalog :
+       {"B | b_id |\nSame | s1_id |\nAa | new_id |\nSame | s2_id |\n"
+        "Z | c_id |\nSame | s3_id |\n",
+        "Same | s2_id |\nB | b_id |\nSame | s1_id |\n"}) {
+    std::ofstream(path + ".new") << catalog;
+    std::rename((path + ".new").c_str(), path.c_str());
+    ASSERT_TRUE(videoLibrary.beginReload());
+    videoLibrary.waitForReload();
+    ASSERT_TRUE(videoLibrary.applyReload(nullptr));
+    EXPECT_EQ(titleOrderIds(videoLibrary), titleOrderIds(VideoLibrary(path)));
+  }
+  EXPECT_THAT(titleOrderIds(videoLibrary),
+              ::testing::ElementsAre("b_id", "s2_id", "s1_id"));
+  std::remove(path.c_str());
+}
@@ -0,0 +1,67 @@
+#include "../src/videoplaylist.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+TEST(VideoPlaylist, testKeepsInsertionOrder) {
+  VideoPlaylist playlist("list");
+  for (VideoHandle video : {5, 3, 9, 1}) {
+    playlist.addVideo(video);
+  }
+  playlist.addVideo(3);
+  EXPECT_THAT(playlist.getVideoHandles(), ::testing::ElementsAre(5, 3, 9, 1));
+  playlist.removeVideo(9);
+  playlist.removeVideo(9);
+  playlist.addVideo(9);
+  EXPECT_THAT(playlist.getVideoHandles(), ::testing::ElementsAre(5, 3, 1, 9));
+  EXPECT_TRUE(playlist.contains(9));
+  EXPECT_FALSE(playlist.contains(7));
+  EXPECT_EQ(playlist.size(), 4);
+  playlist.clearPlaylist();
+  EXPECT_EQ(playlist.size(), 0);
+  EXPECT_FALSE(playlist.contains(5));
+}
+
+TEST(VideoPlaylist, testRandomOperationsMatchReference) {
+  // Enough removals to compact many times.
+  VideoPlaylist playlist("list");
+  std::vector<VideoHandle> expected;
+  std::mt19937 rng(5);
+  for (int step = 0; step < 20000; ++step) {
+    VideoHandle video = rng() % 500;
+    bool present =
+        std::find(expected.begin(), expected.end(), video) != expected.end();
+    EXPECT_EQ(playlist.contains(video), present);
+    if (rng() % 3) {
+      playlist.addVideo(video);
+      if (!present) {
+        expected.push_back(video);
+      }
+    } else {
+      playlist.removeVideo(video);
+      expected.erase(std::remove(expected.begin(), expected.end(), video),
+                     expected.end());
+    }
+  }
+  EXPECT_EQ(playlist.getVideoHandles(), expected);
+  EXPECT_EQ(playlist.size(), expected.size());
+}
+
+TEST(VideoPlaylist, testRemapVideos) {
+  VideoPlaylist playlist("list");
+  for (VideoHandle video : {0, 1, 2, 3}) {
+    playlist.addVideo(video);
+  }
+  playlist.removeVideo(1);
+  // Video 2 is gone and the rest are reversed.
+  std::size_t dropped = playlist.remapVideos(
+      [](VideoHandle video) { return video == 2 ? kNoVideo : 3 - video; });
+  EXPECT_EQ(dropped, 1);
+  EXPECT_THAT(playlist.getVideoHandles(), ::testing::ElementsAre(3, 0));
+  EXPECT_TRUE(playlist.contains(0));
+  EXPECT_FALSE(playlist.contains(1));
+}
@@ -0,0 +1,104 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "../src/cataloggenerator.h"
+
+namespace {
+
+void printUsage(const char* program) {
+  std::cout
+      << "Usage: " << program << " [options] [output]\n"
+      << "Writes a synthetic videos.txt-format catalog to output, or to\n"
+      << "standard output without one. Row N has the id video_N_id.\n"
+      << "  --rows <n>            rows to write (1000)\n"
+      << "  --title-words <a>:<b> words per title, drawn from a to b (2:5)\n"
+      << "  --tags <n>            tag vocabulary, #tag0 to #tag<n-1> (1000)\n"
+      << "  --tags-per-video <n>  most tags on one video (3)\n"
+      << "  --zipf <s>            tag popularity exponent, 0 for uniform (1)\n"
+      << "  --edge-cases <rate>   share of rows in awkward forms, 0 to 1 (0)\n"
+      << "  --seed <n>            random seed (42)" << std::endl;
+}
+
+// Parses all of text as a number into *value. Returns false if it is not one.
+bool parseCount(const std::string& text, std::size_t* value) {
+  char* end = nullptr;
+  unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+  if (text.empty() || text[0] == '-' || *end != '\0') {
+    return false;
+  }
+  *value = static_cast<std::size_t>(parsed);
+  return true;
+}
+
+bool parseFraction(const std::string& text, double* value) {
+  char* end = nullptr;
+  *value = std::strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0' && *value >= 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  CatalogOptions options;
+  std::string outputPath;
+  for (int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    bool hasValue = arg + 1 < argc;
+    std::string value = hasValue ? argv[arg + 1] : "";
+    bool valid = hasValue;
+    std::size_t seed = options.seed;
+    if (option == "--rows") {
+      valid = valid && parseCount(value, &options.rows);
+    } else if (option == "--title-words") {
+      std::size_t colon = value.find(':');
+      valid = valid && colon != std::string::npos &&
+              parseCount(value.substr(0, colon), &options.minTitleWords) &&
+              parseCount(value.substr(colon + 1), &options.maxTitleWords) &&
+              options.minTitleWords <= options.maxTitleWords;
+    } else if (option == "--tags") {
+      valid = valid && parseCount(value, &options.tagVocabulary);
+    } else if (option == "--tags-per-video") {
+      valid = valid && parseCount(value, &options.maxTagsPerVideo);
+    } else if (option == "--zipf") {
+      valid = valid && parseFraction(value, &options.tagSkew);
+    } else if (option == "--edge-cases") {
+      valid = valid && parseFraction(value, &options.edgeCaseRate) &&
+              options.edgeCaseRate <= 1;
+    } else if (option == "--seed") {
+      valid = valid && parseCount(value, &seed);
+      options.seed = static_cast<std::uint32_t>(seed);
+    } else if (outputPath.empty() && !option.empty() && option[0] != '-') {
+      outputPath = option;
+      continue;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      printUsage(argv[0]);
+      return 1;
+    }
+    ++arg;
+  }
+
+  std::ofstream file;
+  if (!outputPath.empty()) {
+    file.open(outputPath, std::ios::binary);
+    if (!file) {
+      std::cerr << "Couldn't write " << outputPath << std::endl;
+      return 1;
+    }
+  }
+  CatalogGenerator generator(options);
+  if (!generator.write(file.is_open() ? file : std::cout)) {
+    std::cerr << "Couldn't write "
+              << (outputPath.empty() ? "output" : outputPath) << std::endl;
+    return 1;
+  }
+  if (!outputPath.empty()) {
+    std::cout << "Wrote " << options.rows << " videos to " << outputPath
+              << std::endl;
+  }
+  return 0;
+}
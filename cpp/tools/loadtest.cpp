@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/commandparser.h"
+#include "../src/commandtokens.h"
+#include "../src/helper.h"
+#include "../src/latencyhistogram.h"
+#include "../src/outputsink.h"
+#include "../src/videolibrary.h"
+#include "../src/videoplayer.h"
+
+// Replays a trace of player commands against shared sessions, optionally at
+// a fixed rate and on several threads, and reports latency percentiles for
+// each command and the throughput reached.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kPlaylists = 16;
+
+struct Options {
+  std::string catalogPath = VideoLibrary::defaultCatalogPath();
+  std::string tracePath;
+  std::string writeTracePath;
+  std::size_t sessions = 1;
+  std::size_t threads = 1;
+  double rate = 0;
+  std::size_t commands = 100000;
+  std::uint32_t seed = 1;
+};
+
+void printUsage(const char* program) {
+  std::cout
+      << "Usage: " << program << " [options] [trace]\n"
+      << "Replays a trace, one command per line as for youtube --batch, or a\n"
+      << "generated mix of commands without one, and reports the latency of\n"
+      << "each command and the throughput.\n"
+      << "  --catalog <file>      catalog to load (src/videos.txt)\n"
+      << "  --sessions <n>        shared sessions, given lines in turn (1)\n"
+      << "  --threads <n>         threads running the sessions (1)\n"
+      << "  --rate <n>            target commands per second, 0 for as fast\n"
+      << "                        as possible (0)\n"
+      << "  --commands <n>        length of the generated mix (100000)\n"
+      << "  --seed <n>            random seed for the mix and players (1)\n"
+      << "  --write-trace <file>  save the generated mix as a trace"
+      << std::endl;
+}
+
+bool parseCount(const std::string& text, std::size_t* value) {
+  char* end = nullptr;
+  unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+  if (text.empty() || text[0] == '-' || *end != '\0') {
+    return false;
+  }
+  *value = static_cast<std::size_t>(parsed);
+  return true;
+}
+
+// Returns a mix of commands on random videos of the library: mostly plays,
+// then playlist edits and reads, searches, flags and the cheap status
+// commands, after creating the playlists it uses.
+std::vector<std::string> generateTrace(const VideoLibrary& library,
+                                       std::size_t commands,
+                                       std::uint32_t seed) {
+  std::vector<std::string> trace;
+  for (int playlist = 0; playlist < kPlaylists; ++playlist) {
+    trace.push_back("CREATE_PLAYLIST load_" + std::to_string(playlist));
+  }
+  std::mt19937 random(seed);
+  while (trace.size() < commands) {
+    const Video& video = library.getVideoAt(
+        static_cast<VideoHandle>(random() % library.size()));
+    std::string id(video.getVideoId());
+    std::string playlist = "load_" + std::to_string(random() % kPlaylists);
+    unsigned kind = random() % 100;
+    if (kind < 35) {
+      trace.push_back("PLAY " + id);
+    } else if (kind < 45) {
+      trace.push_back("ADD_TO_PLAYLIST " + playlist + " " + id);
+    } else if (kind < 50) {
+      trace.push_back("REMOVE_FROM_PLAYLIST " + playlist + " " + id);
+    } else if (kind < 55) {
+      trace.push_back("SHOW_PLAYLIST " + playlist);
+    } else if (kind < 60) {
+      // One word of the title; common words make long result lists.
+      std::vector<std::string_view> words;
+      std::string_view title = video.getTitle();
+      while (!title.empty()) {
+        std::size_t space = std::min(title.find(' '), title.size());
+        if (space > 0) {
+          words.push_back(title.substr(0, space));
+        }
+        title.remove_prefix(std::min(space + 1, title.size()));
+      }
+      trace.push_back(
+          "SEARCH_VIDEOS " +
+          (words.empty() ? id : std::string(words[random() % words.size()])));
+    } else if (kind < 70) {
+      auto tags = video.getTags();
+      if (tags.empty()) {
+        trace.push_back("SEARCH_VIDEOS_WITH_TAG #none");
+      } else {
+        auto tag = tags.begin();
+        std::advance(tag, random() % tags.size());
+        trace.push_back("SEARCH_VIDEOS_WITH_TAG " + std::string(*tag));
+      }
+    } else if (kind < 75) {
+      trace.push_back("FLAG_VIDEO " + id + " load_test");
+    } else if (kind < 80) {
+      trace.push_back("ALLOW_VIDEO " + id);
+    } else if (kind < 85) {
+      trace.push_back("PLAY_RANDOM");
+    } else if (kind < 90) {
+      trace.push_back("SHOW_PLAYING");
+    } else if (kind < 95) {
+      trace.push_back(kind % 2 ? "PAUSE" : "CONTINUE");
+    } else {
+      trace.push_back("NUMBER_OF_VIDEOS");
+    }
+  }
+  return trace;
+}
+
+// A line of the trace, ready to run: its session and the index of its
+// command's name in the report.
+struct TraceCommand {
+  std::string line;
+  std::size_t session;
+  std::size_t name;
+};
+
+// Sleeps until shortly before due and spins the rest of the way: waking
+// from a sleep alone can take tens of microseconds, which would show up in
+// every command's latency.
+void waitUntil(Clock::time_point due) {
+  constexpr std::chrono::microseconds kSpin{200};
+  if (due - Clock::now() > kSpin) {
+    std::this_thread::sleep_until(due - kSpin);
+  }
+  while (Clock::now() < due) {
+    std::this_thread::yield();
+  }
+}
+
+std::string micros(std::uint64_t nanoseconds) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(1)
+      << static_cast<double>(nanoseconds) / 1000;
+  return out.str();
+}
+
+void printRow(const std::string& name, const LatencyHistogram& latency) {
+  std::cout << std::left << std::setw(24) << name << std::right
+            << std::setw(12) << latency.count() << std::setw(12)
+            << micros(static_cast<std::uint64_t>(latency.mean()))
+            << std::setw(12) << micros(latency.percentile(0.5))
+            << std::setw(12) << micros(latency.percentile(0.99))
+            << std::setw(12) << micros(latency.percentile(0.999))
+            << std::setw(12) << micros(latency.max()) << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int arg = 1; arg < argc; ++arg) {
+    std::string option = argv[arg];
+    bool hasValue = arg + 1 < argc;
+    std::string value = hasValue ? argv[arg + 1] : "";
+    bool valid = hasValue;
+    std::size_t number = 0;
+    if (option == "--catalog") {
+      options.catalogPath = value;
+    } else if (option == "--sessions") {
+      valid = valid && parseCount(value, &options.sessions) &&
+              options.sessions > 0;
+    } else if (option == "--threads") {
+      valid = valid && parseCount(value, &options.threads) &&
+              options.threads > 0;
+    } else if (option == "--rate") {
+      valid = valid && parseCount(value, &number);
+      options.rate = static_cast<double>(number);
+    } else if (option == "--commands") {
+      valid = valid && parseCount(value, &options.commands);
+    } else if (option == "--seed") {
+      valid = valid && parseCount(value, &number);
+      options.seed = static_cast<std::uint32_t>(number);
+    } else if (option == "--write-trace") {
+      options.writeTracePath = value;
+    } else if (options.tracePath.empty() && !option.empty() &&
+               option[0] != '-') {
+      options.tracePath = option;
+      continue;
+    } else {
+      valid = false;
+    }
+    if (!valid) {
+      printUsage(argv[0]);
+      return 1;
+    }
+    ++arg;
+  }
+  // A thread without a session of its own would have nothing to run.
+  options.threads = std::min(options.threads, options.sessions);
+
+  auto library = std::make_shared<VideoLibrary>(VideoLibrary::open(
+      options.catalogPath, VideoLibrary::snapshotPathFor(options.catalogPath)));
+  if (library->size() == 0) {
+    std::cerr << "Couldn't load " << options.catalogPath << std::endl;
+    return 1;
+  }
+  if (options.threads > 1) {
+    library->enableConcurrency();
+  }
+
+  std::vector<std::string> lines;
+  if (options.tracePath.empty()) {
+    lines = generateTrace(*library, options.commands, options.seed);
+    if (!options.writeTracePath.empty()) {
+      std::ofstream out(options.writeTracePath);
+      for (const std::string& line : lines) {
+        out << line << '\n';
+      }
+      if (!out) {
+        std::cerr << "Couldn't write " << options.writeTracePath << std::endl;
+        return 1;
+      }
+    }
+  } else {
+    std::ifstream in(options.tracePath);
+    if (!in) {
+      std::cerr << "Couldn't open " << options.tracePath << std::endl;
+      return 1;
+    }
+    for (std::string line; std::getline(in, line);) {
+      lines.push_back(std::move(line));
+    }
+  }
+
+  // Number the command names and deal the lines out to the sessions. EXIT
+  // would end a session, so it is left out along with blank lines.
+  std::vector<std::string> names;
+  std::vector<std::vector<TraceCommand>> threadCommands(options.threads);
+  std::size_t total = 0;
+  for (std::string& line : lines) {
+    CommandTokens tokens(line);
+    if (tokens.empty()) {
+      continue;
+    }
+    std::string name = stringToUpper(std::string(tokens[0]));
+    if (name == "EXIT") {
+      continue;
+    }
+    auto found = std::find(names.begin(), names.end(), name);
+    std::size_t index = static_cast<std::size_t>(found - names.begin());
+    if (found == names.end()) {
+      names.push_back(name);
+    }
+    std::size_t session = total++ % options.sessions;
+    threadCommands[session % options.threads].push_back(
+        {std::move(line), session, index});
+  }
+
+  // Shared sessions, like SessionManager's, that never stop a search to ask
+  // which result to play.
+  auto sink = std::make_shared<NullSink>();
+  std::vector<CommandParser> sessions;
+  for (std::size_t session = 0; session < options.sessions; ++session) {
+    VideoPlayer player(library, sink);
+    player.setInteractive(false);
+    player.seedRandom(options.seed + static_cast<std::uint32_t>(session));
+    sessions.emplace_back(std::move(player));
+  }
+
+  // With a rate, each thread runs its share on a fixed schedule and a
+  // command's latency counts from when it was due, so falling behind shows
+  // up as latency rather than as a lower rate alone.
+  std::chrono::nanoseconds interval{0};
+  if (options.rate > 0) {
+    interval = std::chrono::nanoseconds(static_cast<std::int64_t>(
+        1e9 * static_cast<double>(options.threads) / options.rate));
+  }
+  std::vector<std::vector<LatencyHistogram>> latencies(
+      options.threads, std::vector<LatencyHistogram>(names.size()));
+  Clock::time_point start = Clock::now() + std::chrono::milliseconds(10);
+  std::vector<std::thread> threads;
+  for (std::size_t thread = 0; thread < options.threads; ++thread) {
+    threads.emplace_back([&, thread] {
+      std::vector<LatencyHistogram>& latency = latencies[thread];
+      Clock::time_point due = start;
+      std::this_thread::sleep_until(start);
+      for (const TraceCommand& command : threadCommands[thread]) {
+        Clock::time_point begin = due;
+        if (interval.count() > 0) {
+          waitUntil(due);
+          due += interval;
+        } else {
+          begin = Clock::now();
+        }
+        sessions[command.session].executeCommand(CommandTokens(command.line));
+        latency[command.name].record(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - begin)
+                .count()));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  std::vector<std::size_t> order(names.size());
+  for (std::size_t name = 0; name < names.size(); ++name) {
+    order[name] = name;
+  }
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+    return names[a] < names[b];
+  });
+  std::cout << "Ran " << total << " commands on " << options.sessions
+            << " sessions and " << options.threads << " threads in "
+            << std::fixed << std::setprecision(1) << elapsed.count() * 1000
+            << " ms: " << std::setprecision(0)
+            << static_cast<double>(total) / elapsed.count()
+            << " commands/sec";
+  if (options.rate > 0) {
+    std::cout << " (target " << options.rate << ")";
+  }
+  std::cout << "\n\n"
+            << std::left << std::setw(24) << "command (us)" << std::right
+            << std::setw(12) << "count" << std::setw(12) << "mean"
+            << std::setw(12) << "p50" << std::setw(12) << "p99"
+            << std::setw(12) << "p999" << std::setw(12) << "max" << '\n';
+  LatencyHistogram all;
+  for (std::size_t name : order) {
+    LatencyHistogram merged;
+    for (const auto& latency : latencies) {
+      merged.merge(latency[name]);
+    }
+    printRow(names[name], merged);
+    all.merge(merged);
+  }
+  printRow("all", all);
+  return 0;
+}
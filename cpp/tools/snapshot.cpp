@@ -0,0 +1,32 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "../src/videolibrary.h"
+
+// Converts a videos.txt catalog into a binary snapshot that the youtube binary
+// loads instead of the text file while the snapshot is the newer of the two.
+int main(int argc, char* argv[]) {
+  if (argc > 3) {
+    std::cout << "Usage: youtube_snapshot [videos.txt] [videos.snapshot]"
+              << std::endl;
+    return 1;
+  }
+  std::string catalogPath =
+      argc > 1 ? argv[1] : VideoLibrary::defaultCatalogPath();
+  std::string snapshotPath =
+      argc > 2 ? argv[2] : VideoLibrary::snapshotPathFor(catalogPath);
+
+  if (!std::ifstream(catalogPath).good()) {
+    std::cout << "Couldn't find " << catalogPath << std::endl;
+    return 1;
+  }
+  VideoLibrary videoLibrary(catalogPath);
+  if (!videoLibrary.saveSnapshot(snapshotPath)) {
+    std::cout << "Couldn't write snapshot " << snapshotPath << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << videoLibrary.size() << " videos to "
+            << snapshotPath << std::endl;
+  return 0;
+}